@@ -36,6 +36,7 @@ namespace kengine {
 		auto e = getEntity(id);
 		for (const auto & [_, func] : getEntities<functions::OnEntityRemoved>())
 			func(e);
+		_metaTable.clear(id);
 
 		Entity::Mask mask;
 		{
@@ -43,6 +44,8 @@ namespace kengine {
 			mask = _entities[id].mask;
 		}
 
+		bumpComponentVersions(mask);
+
 		{
 			detail::ReadLock archetypes(_archetypesMutex);
 			const auto archetype = std::find_if(
@@ -69,9 +72,24 @@ namespace kengine {
 	}
 
 	void EntityManager::setEntityActive(Entity::ID id, bool active) {
-		detail::WriteLock l(_entitiesMutex);
-		_entities[id].active = active;
-		_entities[id].shouldActivateAfterInit = active;
+		Entity::Mask mask;
+		{
+			detail::WriteLock l(_entitiesMutex);
+			_entities[id].active = active;
+			_entities[id].shouldActivateAfterInit = active;
+			mask = _entities[id].mask;
+		}
+		bumpComponentVersions(mask);
+	}
+
+	size_t EntityManager::getComponentVersion(size_t component) const {
+		return _componentVersions[component];
+	}
+
+	void EntityManager::bumpComponentVersions(const Entity::Mask & mask) {
+		for (size_t i = 0; i < mask.size(); ++i)
+			if (mask[i])
+				++_componentVersions[i];
 	}
 
 	struct ComponentIDSave {
@@ -119,12 +137,67 @@ namespace kengine {
 		return Entity(id, 0, this);
 	}
 
+	void EntityManager::alloc(size_t count, std::vector<Entity> & entities) {
+		entities.reserve(entities.size() + count);
+
+		{
+			detail::WriteLock l(_toReuseMutex);
+			if (!_toReuseSorted) {
+				std::sort(_toReuse.begin(), _toReuse.end(), std::greater<Entity::ID>());
+				_toReuseSorted = true;
+			}
+			for (; count > 0 && !_toReuse.empty(); --count) {
+				entities.push_back(Entity(_toReuse.back(), 0, this));
+				_toReuse.pop_back();
+			}
+		}
+
+		if (count == 0)
+			return;
+
+		detail::WriteLock l(_entitiesMutex);
+		const auto first = _entities.size();
+		_entities.resize(first + count, { false, 0 });
+		for (size_t id = first; id < first + count; ++id)
+			entities.push_back(Entity(id, 0, this));
+	}
+
+	void EntityManager::activateAfterInit(const std::vector<Entity> & entities) {
+		Entity::Mask mask;
+		{
+			detail::WriteLock l(_entitiesMutex);
+			for (const auto & e : entities) {
+				auto & metadata = _entities[e.id];
+				if (!metadata.shouldActivateAfterInit)
+					continue;
+				metadata.active = true;
+				mask |= metadata.mask;
+			}
+		}
+		bumpComponentVersions(mask);
+	}
+
+	EntityManager::MetaTable::MetaTable() {
+		for (auto & id : typeEntities)
+			id = Entity::INVALID_ID;
+	}
+
+	void EntityManager::MetaTable::clear(Entity::ID typeEntity) {
+		for (size_t component = 0; component < KENGINE_COMPONENT_COUNT; ++component)
+			if (typeEntities[component] == typeEntity) {
+				typeEntities[component] = Entity::INVALID_ID;
+				for (auto & row : entries)
+					row[component] = nullptr;
+			}
+	}
+
 	void EntityManager::addComponent(Entity::ID id, size_t component) {
 		updateHasComponent(id, component, true);
 	}
 
 	void EntityManager::removeComponent(Entity::ID id, size_t component) {
 		updateHasComponent(id, component, false);
+		_metaTable.clear(id);
 	}
 
 	void EntityManager::updateHasComponent(Entity::ID id, size_t component, bool newHasComponent) {
@@ -162,8 +235,12 @@ namespace kengine {
 				_archetypes.emplace_back(updatedMask, id);
 		}
 
-		detail::WriteLock l(_entitiesMutex);
-		_entities[id].mask = updatedMask;
+		{
+			detail::WriteLock l(_entitiesMutex);
+			_entities[id].mask = updatedMask;
+		}
+
+		++_componentVersions[component];
 	}
 
 	/*
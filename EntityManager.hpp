@@ -50,6 +50,27 @@ namespace kengine {
 			return createEntity(FWD(postCreate));
 		}
 
+		// Allocates `count` Entities at once, calls `postCreate` on each, then runs the OnEntityCreated callbacks and activates them as a batch
+		template<typename Func> // Func: void(Entity & e, size_t index)
+		void createEntities(size_t count, Func && postCreate) {
+			if (count == 0)
+				return;
+
+			std::vector<Entity> entities;
+			alloc(count, entities);
+			for (size_t i = 0; i < count; ++i)
+				postCreate(entities[i], i);
+
+			std::vector<functions::OnEntityCreated> callbacks; // Copies, as callbacks may create Entities
+			for (const auto & [_, f] : getEntities<functions::OnEntityCreated>())
+				callbacks.push_back(f);
+			for (auto & e : entities)
+				for (const auto & f : callbacks)
+					f(e);
+
+			activateAfterInit(entities);
+		}
+
 	public:
 		Entity getEntity(Entity::ID id);
 		EntityView getEntity(Entity::ID id) const;
@@ -62,6 +83,10 @@ namespace kengine {
 		void setEntityActive(EntityView e, bool active);
 		void setEntityActive(Entity::ID id, bool active);
 
+	public:
+		// Incremented whenever an Entity gains or loses `component`, or an Entity with it is removed or (de)activated
+		size_t getComponentVersion(size_t component) const;
+
 	public:
 		std::atomic<bool> running = true;
 
@@ -232,6 +257,8 @@ namespace kengine {
 
 	private:
 		Entity alloc();
+		void alloc(size_t count, std::vector<Entity> & entities);
+		void activateAfterInit(const std::vector<Entity> & entities);
 
     private:
 		friend class Entity;
@@ -255,10 +282,28 @@ namespace kengine {
 		bool _toReuseSorted = true;
 		mutable detail::Mutex _toReuseMutex;
 
+		std::atomic<size_t> _componentVersions[KENGINE_COMPONENT_COUNT] = {};
+		void bumpComponentVersions(const Entity::Mask & mask);
+
 	private:
 		mutable detail::GlobalCompMap _components; // Mutable to lock mutex
 
 	public: // Reserved to PluginHelper::initPlugin
 		detail::GlobalCompMap & _getComponentMap() { return _components; }
+
+	public: // Reserved to MetaTableHelper
+		struct MetaTable {
+			MetaTable();
+
+			// Type Entity the entries for each Component were found on. Its column is cleared when it loses a Component or is removed
+			std::atomic<Entity::ID> typeEntities[KENGINE_COMPONENT_COUNT];
+			std::atomic<const void *> entries[KENGINE_COMPONENT_COUNT][KENGINE_COMPONENT_COUNT] = {}; // [meta Component ID][Component ID], nullptr until resolved
+
+			void clear(Entity::ID typeEntity);
+		};
+		MetaTable & _getMetaTable() { return _metaTable; }
+
+	private:
+		MetaTable _metaTable;
 	};
 }
@@ -0,0 +1,199 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "EntityManager.hpp"
+#include "Entity.hpp"
+
+// Microbenchmarks for EntityManager, Component and Archetype primitives.
+// Each result is printed as a single-line JSON object so runs can be diffed between commits.
+//
+// Usage: kengine_bench [--sizes 1000,100000,1000000] [--ops 256] [--filter name]
+
+namespace {
+	struct Position { float x = 0, y = 0, z = 0; };
+	struct Velocity { float x = 1, y = 1, z = 1; };
+	struct Health { int value = 100; };
+	struct Tag { int value = 0; };
+
+	struct Options {
+		std::vector<size_t> sizes = { 1000, 100000, 1000000 };
+		size_t ops = 256;
+		const char * filter = nullptr;
+	};
+
+	Options g_options;
+
+	using Clock = std::chrono::steady_clock;
+
+	// Prevents the compiler from optimizing away benchmarked reads
+	std::atomic<float> g_sink;
+
+	template<typename Func>
+	void bench(const char * name, size_t entities, size_t ops, Func && func) {
+		if (g_options.filter != nullptr && strstr(name, g_options.filter) == nullptr)
+			return;
+
+		const auto start = Clock::now();
+		func();
+		const auto end = Clock::now();
+
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		printf("{ \"benchmark\": \"%s\", \"entities\": %zu, \"ops\": %zu, \"total_ns\": %lld, \"ns_per_op\": %.2f }\n",
+			name, entities, ops, (long long)ns, ops > 0 ? (double)ns / ops : 0.0);
+		fflush(stdout);
+	}
+
+	void createPopulation(kengine::EntityManager & em, std::vector<kengine::Entity::ID> & ids, size_t count) {
+		while (ids.size() < count) {
+			const auto i = ids.size();
+			const auto e = em.createEntity([i](kengine::Entity & e) {
+				e += Position{};
+				e += Velocity{};
+				if (i % 2 == 0)
+					e += Health{};
+				if (i % 4 == 0)
+					e += Tag{};
+			});
+			ids.push_back(e.id);
+		}
+	}
+
+	template<typename ... Comps>
+	void iterate(kengine::EntityManager & em, const char * name, size_t entities) {
+		bench(name, entities, entities, [&] {
+			float sum = 0;
+			for (const auto & t : em.getEntities<Comps...>())
+				sum += std::get<1>(t).x;
+			g_sink = sum;
+		});
+	}
+
+	void runSize(kengine::EntityManager & em, std::vector<kengine::Entity::ID> & ids, size_t size) {
+		// Population growth, reusing the entities created for previous sizes
+		const auto previous = ids.size();
+		bench("create", size, size - previous, [&] { createPopulation(em, ids, size); });
+		createPopulation(em, ids, size); // No-op unless "create" was filtered out
+
+		const auto ops = std::min(g_options.ops, size);
+		std::mt19937 rng(42);
+
+		// Distinct positions in `ids`, as removing the same Entity twice is invalid
+		std::vector<size_t> sampleIndices(ids.size());
+		for (size_t i = 0; i < sampleIndices.size(); ++i)
+			sampleIndices[i] = i;
+		std::shuffle(sampleIndices.begin(), sampleIndices.end(), rng);
+		sampleIndices.resize(ops);
+
+		bench("churn_remove_create", size, ops, [&] {
+			for (const auto index : sampleIndices)
+				em.removeEntity(ids[index]);
+			for (const auto index : sampleIndices)
+				ids[index] = em.createEntity([](kengine::Entity & e) {
+					e += Position{};
+					e += Velocity{};
+				}).id;
+		});
+
+		std::vector<kengine::Entity::ID> sample;
+		for (const auto index : sampleIndices)
+			sample.push_back(ids[index]);
+
+		bench("attach_detach_single", size, ops, [&] {
+			for (const auto id : sample) {
+				auto e = em.getEntity(id);
+				if (e.has<Tag>())
+					e.detach<Tag>();
+				else
+					e.attach<Tag>();
+			}
+		});
+
+		bench("attach_detach_multi", size, ops, [&] {
+			for (const auto id : sample) {
+				auto e = em.getEntity(id);
+				const bool had = e.has<Health>();
+				if (had)
+					e.detach<Health>();
+				else
+					e += Health{};
+				if (e.has<Tag>())
+					e.detach<Tag>();
+				else
+					e += Tag{};
+				e.detach<Velocity>();
+				e += Velocity{};
+			}
+		});
+
+		iterate<Position>(em, "iterate_1", size);
+		iterate<Position, Velocity>(em, "iterate_2", size);
+		iterate<Position, Velocity, Health>(em, "iterate_3", size);
+		iterate<Position, Velocity, Health, Tag>(em, "iterate_4", size);
+		iterate<Position, kengine::no<Health>>(em, "iterate_no", size);
+
+		std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+		std::vector<kengine::Entity::ID> randomIDs(size);
+		for (auto & id : randomIDs)
+			id = ids[pick(rng)];
+
+		bench("random_get", size, size, [&] {
+			float sum = 0;
+			for (const auto id : randomIDs) {
+				const auto e = em.getEntity(id);
+				sum += e.get<Position>().x;
+			}
+			g_sink = sum;
+		});
+
+		const auto threads = std::max(1u, std::thread::hardware_concurrency());
+		bench("concurrent_iterate_2", size, size * threads, [&] {
+			for (unsigned int i = 0; i < threads; ++i)
+				em.runTask([&] {
+					float sum = 0;
+					for (const auto & [e, pos, vel] : em.getEntities<Position, Velocity>())
+						sum += pos.x + vel.x;
+					g_sink = sum;
+				});
+			em.completeTasks();
+		});
+	}
+
+	void parseOptions(int ac, char ** av) {
+		for (int i = 1; i < ac; ++i) {
+			if (strcmp(av[i], "--sizes") == 0 && i + 1 < ac) {
+				g_options.sizes.clear();
+				const char * str = av[++i];
+				while (*str) {
+					char * end;
+					g_options.sizes.push_back(strtoull(str, &end, 10));
+					str = *end == ',' ? end + 1 : end;
+				}
+			}
+			else if (strcmp(av[i], "--ops") == 0 && i + 1 < ac)
+				g_options.ops = strtoull(av[++i], nullptr, 10);
+			else if (strcmp(av[i], "--filter") == 0 && i + 1 < ac)
+				g_options.filter = av[++i];
+		}
+		std::sort(g_options.sizes.begin(), g_options.sizes.end());
+	}
+}
+
+int main(int ac, char ** av) {
+	parseOptions(ac, av);
+
+	// Component storage is static, so a single EntityManager is shared by all sizes
+	kengine::EntityManager em(std::thread::hardware_concurrency());
+	std::vector<kengine::Entity::ID> ids;
+
+	for (const auto size : g_options.sizes)
+		runSize(em, ids, size);
+
+	return 0;
+}
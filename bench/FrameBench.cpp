@@ -0,0 +1,277 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+#endif
+
+#include "EntityManager.hpp"
+#include "Entity.hpp"
+
+#include "systems/KinematicSystem.hpp"
+#include "systems/CollisionSystem.hpp"
+#include "systems/InputSystem.hpp"
+
+#ifdef KENGINE_BENCH_BULLET
+# include "systems/bullet/BulletSystem.hpp"
+# include "data/GraphicsComponent.hpp"
+# include "data/ModelColliderComponent.hpp"
+#endif
+
+#ifdef KENGINE_BENCH_LUA
+# include "systems/LuaSystem.hpp"
+# include "data/LuaComponent.hpp"
+#endif
+
+#include "data/CollisionComponent.hpp"
+#include "data/InputBufferComponent.hpp"
+#include "data/InputComponent.hpp"
+#include "data/KinematicComponent.hpp"
+#include "data/PhysicsComponent.hpp"
+#include "data/TransformComponent.hpp"
+
+#include "functions/Execute.hpp"
+
+#include "helpers/MainLoop.hpp"
+
+// Headless whole-frame benchmark: runs the simulation systems over a generated scene and reports
+// the frame time distribution, the time spent in each system and the peak resident set size as JSON.
+//
+// Usage: kengine_frame_bench [--entities 10000] [--frames 600] [--seed 42] [--input-events 16]
+//                            [--bodies 0.1] [--scripts 0.01]
+
+namespace {
+	struct Options {
+		size_t entities = 10000;
+		size_t frames = 600;
+		unsigned int seed = 42;
+		size_t inputEvents = 16;
+		float bodies = .1f; // Fraction of Entities simulated by Bullet
+		float scripts = .01f; // Fraction of Entities running a Lua script
+	};
+
+	Options g_options;
+
+	using Clock = std::chrono::steady_clock;
+
+	struct SystemTimer {
+		const char * name;
+		kengine::functions::Execute execute;
+		long long totalNs = 0;
+		long long maxNs = 0;
+	};
+
+	std::vector<std::unique_ptr<SystemTimer>> g_timers;
+	size_t g_collisions = 0;
+	size_t g_inputCalls = 0;
+
+	// Replaces the system's Execute with one that measures it
+	template<typename Creator>
+	void addSystem(kengine::EntityManager & em, const char * name, Creator && creator) {
+		em.createEntity([&](kengine::Entity & e) {
+			creator(e);
+			if (!e.has<kengine::functions::Execute>())
+				return;
+
+			g_timers.push_back(std::make_unique<SystemTimer>());
+			const auto timer = g_timers.back().get();
+			timer->name = name;
+			timer->execute = e.get<kengine::functions::Execute>();
+
+			e += kengine::functions::Execute{ [timer](float deltaTime) {
+				const auto start = Clock::now();
+				timer->execute(deltaTime);
+				const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+				timer->totalNs += ns;
+				timer->maxNs = std::max(timer->maxNs, (long long)ns);
+			} };
+		});
+	}
+
+	void createScene(kengine::EntityManager & em, std::mt19937 & rng) {
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+		std::uniform_real_distribution<float> direction(-1.f, 1.f);
+		std::uniform_real_distribution<float> chance(0.f, 1.f);
+
+#ifdef KENGINE_BENCH_BULLET
+		const auto model = em.createEntity([](kengine::Entity & e) {
+			kengine::ModelColliderComponent::Collider collider;
+			collider.shape = kengine::ModelColliderComponent::Collider::Box;
+			kengine::ModelColliderComponent comp;
+			comp.colliders.push_back(collider);
+			e += comp;
+		}).id;
+#endif
+
+#ifdef KENGINE_BENCH_LUA
+		const char * script = "kengine_frame_bench.lua";
+		std::ofstream(script) << "local x = deltaTime * 2\n";
+#endif
+
+		for (size_t i = 0; i < g_options.entities; ++i)
+			em.createEntity([&](kengine::Entity & e) {
+				kengine::TransformComponent transform;
+				transform.boundingBox.position = { position(rng), position(rng), position(rng) };
+				e += transform;
+
+				kengine::PhysicsComponent physics;
+				physics.movement = { direction(rng), direction(rng), direction(rng) };
+				physics.yaw = direction(rng);
+				e += physics;
+
+				auto & collision = e.attach<kengine::CollisionComponent>();
+				collision.onCollide = [](kengine::Entity &, kengine::Entity &) { ++g_collisions; };
+
+				if (chance(rng) < .1f) {
+					auto & input = e.attach<kengine::InputComponent>();
+					input.onKey = [](kengine::Entity::ID, int, bool) { ++g_inputCalls; };
+					input.onMouseMove = [](kengine::Entity::ID, const putils::Point2f &, const putils::Point2f &) { ++g_inputCalls; };
+				}
+
+#ifdef KENGINE_BENCH_BULLET
+				if (chance(rng) < g_options.bodies) {
+					kengine::GraphicsComponent graphics;
+					graphics.model = model;
+					e += graphics;
+					return;
+				}
+#endif
+
+#ifdef KENGINE_BENCH_LUA
+				if (chance(rng) < g_options.scripts) {
+					kengine::LuaComponent lua;
+					lua.scripts.push_back(script);
+					e += lua;
+				}
+#endif
+
+				e += kengine::KinematicComponent{};
+			});
+	}
+
+	void feedInput(kengine::EntityManager & em, std::mt19937 & rng) {
+		std::uniform_real_distribution<float> coordinate(0.f, 1920.f);
+		std::uniform_int_distribution<int> key(0, 255);
+
+		for (auto & [e, buffer] : em.getEntities<kengine::InputBufferComponent>())
+			for (size_t i = 0; i < g_options.inputEvents; ++i) {
+				if (i % 2 == 0 && !buffer.keys.full())
+					buffer.keys.push_back({ kengine::Entity::INVALID_ID, key(rng), i % 4 == 0 });
+				else if (!buffer.moves.full())
+					buffer.moves.push_back({ kengine::Entity::INVALID_ID, { coordinate(rng), coordinate(rng) }, { 1.f, 1.f } });
+			}
+	}
+
+	size_t getPeakRSSKB() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize / 1024;
+#else
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+# ifdef __APPLE__
+		return usage.ru_maxrss / 1024; // Bytes on macOS
+# else
+		return usage.ru_maxrss;
+# endif
+#endif
+	}
+
+	double percentile(const std::vector<double> & sorted, double p) {
+		if (sorted.empty())
+			return 0.0;
+		const auto index = (size_t)(p * (sorted.size() - 1) + .5);
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+
+	void parseOptions(int ac, char ** av) {
+		for (int i = 1; i + 1 < ac; ++i) {
+			if (strcmp(av[i], "--entities") == 0)
+				g_options.entities = strtoull(av[++i], nullptr, 10);
+			else if (strcmp(av[i], "--frames") == 0)
+				g_options.frames = strtoull(av[++i], nullptr, 10);
+			else if (strcmp(av[i], "--seed") == 0)
+				g_options.seed = (unsigned int)strtoul(av[++i], nullptr, 10);
+			else if (strcmp(av[i], "--input-events") == 0)
+				g_options.inputEvents = strtoull(av[++i], nullptr, 10);
+			else if (strcmp(av[i], "--bodies") == 0)
+				g_options.bodies = strtof(av[++i], nullptr);
+			else if (strcmp(av[i], "--scripts") == 0)
+				g_options.scripts = strtof(av[++i], nullptr);
+		}
+	}
+}
+
+int main(int ac, char ** av) {
+	parseOptions(ac, av);
+
+	kengine::EntityManager em(std::thread::hardware_concurrency());
+	std::mt19937 rng(g_options.seed);
+
+	addSystem(em, "InputSystem", kengine::InputSystem(em));
+	addSystem(em, "KinematicSystem", kengine::KinematicSystem(em));
+	addSystem(em, "CollisionSystem", kengine::CollisionSystem(em));
+#ifdef KENGINE_BENCH_BULLET
+	addSystem(em, "BulletSystem", kengine::BulletSystem(em));
+#endif
+#ifdef KENGINE_BENCH_LUA
+	addSystem(em, "LuaSystem", kengine::LuaSystem(em));
+#endif
+
+	const auto setupStart = Clock::now();
+	createScene(em, rng);
+	const auto setupMs = std::chrono::duration<double, std::milli>(Clock::now() - setupStart).count();
+
+	const float deltaTime = 1.f / 60.f;
+	std::vector<double> frameTimes;
+	frameTimes.reserve(g_options.frames);
+
+	for (size_t i = 0; i < g_options.frames; ++i) {
+		feedInput(em, rng);
+
+		const auto start = Clock::now();
+		kengine::MainLoop::runFrames(em, 1, deltaTime);
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+
+	double total = 0.0;
+	for (const auto t : frameTimes)
+		total += t;
+	auto sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	printf("{\n");
+	printf("\t\"entities\": %zu,\n\t\"frames\": %zu,\n\t\"seed\": %u,\n", g_options.entities, g_options.frames, g_options.seed);
+	printf("\t\"setup_ms\": %.3f,\n", setupMs);
+	printf("\t\"frame_ms\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+		sorted.empty() ? 0.0 : total / sorted.size(),
+		percentile(sorted, 0.0), percentile(sorted, .5), percentile(sorted, .9), percentile(sorted, .99), percentile(sorted, 1.0));
+
+	printf("\t\"systems\": {");
+	for (size_t i = 0; i < g_timers.size(); ++i) {
+		const auto & timer = *g_timers[i];
+		printf("%s\n\t\t\"%s\": { \"mean_ms\": %.4f, \"max_ms\": %.4f }", i == 0 ? "" : ",",
+			timer.name,
+			g_options.frames == 0 ? 0.0 : timer.totalNs / 1e6 / g_options.frames,
+			timer.maxNs / 1e6);
+	}
+	printf("\n\t},\n");
+
+	printf("\t\"collisions\": %zu,\n\t\"input_calls\": %zu,\n", g_collisions, g_inputCalls);
+	printf("\t\"peak_rss_kb\": %zu\n", getPeakRSSKB());
+	printf("}\n");
+
+	return 0;
+}
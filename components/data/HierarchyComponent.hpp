@@ -0,0 +1,27 @@
+#pragma once
+
+#ifndef KENGINE_HIERARCHY_BONE_NAME_MAX_LENGTH
+# define KENGINE_HIERARCHY_BONE_NAME_MAX_LENGTH 64
+#endif
+
+#include "string.hpp"
+#include "Entity.hpp"
+#include "data/TransformComponent.hpp"
+
+namespace kengine {
+	struct HierarchyComponent {
+		static constexpr char stringName[] = "HierarchyComponentString";
+		using string = putils::string<KENGINE_HIERARCHY_BONE_NAME_MAX_LENGTH, stringName>;
+
+		Entity::ID parent = Entity::INVALID_ID;
+		TransformComponent local; // Relative to `parent` (or to `bone`)
+		string bone; // Optional name of a bone in `parent`'s model
+
+		putils_reflection_class_name(HierarchyComponent);
+		putils_reflection_attributes(
+			putils_reflection_attribute(&HierarchyComponent::parent),
+			putils_reflection_attribute(&HierarchyComponent::local),
+			putils_reflection_attribute(&HierarchyComponent::bone)
+		);
+	};
+}
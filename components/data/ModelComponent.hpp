@@ -18,6 +18,22 @@ namespace kengine {
 		float roll = 0.f;
 		bool mirrored = false;
 
+		// Incremented by `markDirty`, so that data derived from the model's transform (such as WorldMatrixComponent) is only recomputed when it changes
+		size_t version = 0;
+		// Must be called after modifying the members above
+		void markDirty() { ++version; }
+
+		ModelComponent & operator=(const ModelComponent & rhs) { // Counts as a modification
+			file = rhs.file;
+			boundingBox = rhs.boundingBox;
+			pitch = rhs.pitch;
+			yaw = rhs.yaw;
+			roll = rhs.roll;
+			mirrored = rhs.mirrored;
+			markDirty();
+			return *this;
+		}
+
 		putils_reflection_class_name(ModelComponent);
 		putils_reflection_attributes(
 			putils_reflection_attribute(&ModelComponent::file),
@@ -30,5 +46,8 @@ namespace kengine {
 
 			putils_reflection_attribute(&ModelComponent::mirrored)
 		);
+		putils_reflection_methods(
+			putils_reflection_attribute(&ModelComponent::markDirty)
+		);
 	};
 }
\ No newline at end of file
@@ -20,6 +20,12 @@ namespace kengine {
 			DataInfo vertices;
 			DataInfo indices;
 			int indexType; // GLenum (GL_UNSIGNED_SHORT / GL_UNSIGNED_INT / ...)
+
+			struct Lod {
+				size_t firstIndex;
+				size_t nbIndices;
+			};
+			std::vector<Lod> lods; // Ranges of `indices`, from finest to coarsest. Empty if `indices` only hold the full mesh
 		};
 
 		std::vector<Mesh> meshes;
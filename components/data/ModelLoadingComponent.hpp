@@ -0,0 +1,20 @@
+#pragma once
+
+#include "reflection.hpp"
+
+namespace kengine {
+	// Attached to a model Entity while its file is being loaded in the background
+	struct ModelLoadingComponent {
+		enum State {
+			Loading,
+			Failed
+		};
+
+		State state = Loading;
+
+		putils_reflection_class_name(ModelLoadingComponent);
+		putils_reflection_attributes(
+			putils_reflection_attribute(&ModelLoadingComponent::state)
+		);
+	};
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <vector>
 #include <gl/glew.h>
 #include <GL/GL.h>
+#include "Point.hpp"
 
 namespace putils::gl { class Program; }
 
@@ -15,9 +16,16 @@ namespace kengine {
 			GLuint indexBuffer = -1;
 			size_t nbIndices = 0;
 			GLenum indexType = GL_UNSIGNED_INT;
+
+			struct Lod {
+				size_t firstIndex;
+				size_t nbIndices;
+			};
+			std::vector<Lod> lods; // Ranges of the index buffer, from finest to coarsest. Empty if it only holds the full mesh
 		};
 
 		std::vector<Mesh> meshes;
+		putils::Rect3f boundingBox; // Mesh-space bounds of all vertices
 
 		void (*vertexRegisterFunc)() = nullptr;
 	};
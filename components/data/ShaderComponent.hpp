@@ -67,6 +67,13 @@ namespace kengine {
 		putils_reflection_class_name(DepthCubeComponent);
 	};
 
+	struct ShadowMapCacheComponent {
+		size_t lightHash = 0; // Light parameters the shadow map was last rendered with
+		size_t casterHash = 0; // Casters the shadow map was last rendered with
+		bool delayed = false; // Set when KENGINE_SHADOW_MAP_UPDATE_BUDGET postponed a re-render
+		putils_reflection_class_name(ShadowMapCacheComponent);
+	};
+
 	struct ShadowMapShaderComponent {
 		putils_reflection_class_name(ShadowMapShaderComponent);
 	};
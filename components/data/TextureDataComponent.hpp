@@ -12,6 +12,7 @@ namespace kengine {
 		int width;
 		int height;
 		int components;
+		int levels = 1; // Mip levels stored consecutively in `data`, from the largest. Generated by the GPU if 1
 
 		using FreeFunc = void(*)(void * data);
 		FreeFunc free;
@@ -14,11 +14,26 @@ namespace kengine {
         TransformComponent(const putils::Rect3f & rect)
                 : boundingBox(rect) {}
 
+        TransformComponent(const TransformComponent &) = default;
+        TransformComponent & operator=(const TransformComponent & rhs) { // Counts as a modification
+            boundingBox = rhs.boundingBox;
+            pitch = rhs.pitch;
+            yaw = rhs.yaw;
+            roll = rhs.roll;
+            markDirty();
+            return *this;
+        }
+
         putils::Rect3f boundingBox;
         float pitch = 0; // Radians
         float yaw = 0; // Radians
 		float roll = 0; // Radians
 
+        // Incremented by `markDirty`, so that data derived from the transform (such as WorldMatrixComponent) is only recomputed when it changes
+        size_t version = 0;
+        // Must be called after modifying the members above
+        void markDirty() { ++version; }
+
         /*
          * Reflectible
          */
@@ -31,5 +46,8 @@ namespace kengine {
                 putils_reflection_attribute(&TransformComponent::yaw),
                 putils_reflection_attribute(&TransformComponent::roll)
         );
+        putils_reflection_methods(
+                putils_reflection_attribute(&TransformComponent::markDirty)
+        );
     };
 };
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "Entity.hpp"
+
+namespace kengine {
+	struct WorldMatrixComponent {
+		glm::mat4 model{ 1.f }; // Combines TransformComponent and the model Entity's ModelComponent
+		size_t version = 0; // Incremented whenever `model` changes
+
+		// Versions of the TransformComponent and ModelComponent `model` was last computed from, so unchanged Entities can be skipped
+		static constexpr size_t NO_VERSION = (size_t)-1; // Not computed yet, or computed without a ModelComponent
+		Entity::ID modelEntity = Entity::INVALID_ID;
+		size_t transformVersion = NO_VERSION;
+		size_t modelVersion = NO_VERSION;
+	};
+}
@@ -12,5 +12,11 @@ namespace kengine {
 		> {
 			putils_reflection_class_name(LoadFromJSON);
 		};
+
+		// Attached next to LoadFromJSON: key of the parent Component's object in JSON entities, i.e. its class name
+		struct LoadFromJSONKey {
+			const char * name = nullptr;
+			putils_reflection_class_name(LoadFromJSONKey);
+		};
 	}
 }
\ No newline at end of file
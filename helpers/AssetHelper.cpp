@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "AssetHelper.hpp"
+
+namespace kengine::AssetHelper {
+	static constexpr size_t INVALID_KEY = (size_t)-1;
+
+	struct Asset {
+		size_t key = INVALID_KEY; // Assets may be referenced before being registered
+		size_t refCount = 0;
+		std::vector<Entity::ID> dependencies;
+		Reloader reloader = nullptr;
+	};
+
+	// Paths are interned once, then assets are found by a single integer lookup
+	static std::unordered_map<std::string, PathID> g_pathIDs;
+	static std::deque<std::string> g_paths; // Never moved, so `getPath` results stay valid
+	static std::unordered_map<size_t, Entity::ID> g_entities; // Indexed by `getKey`
+	static std::unordered_map<Entity::ID, Asset> g_assets;
+	static kengine::detail::Mutex g_mutex;
+
+	static size_t getKey(size_t component, PathID path) {
+		return path * KENGINE_COMPONENT_COUNT + component;
+	}
+
+	// Expects g_mutex to be held
+	static const PathID * findPathID(const char * path) {
+		const auto it = g_pathIDs.find(path);
+		return it != g_pathIDs.end() ? &it->second : nullptr;
+	}
+
+	PathID getPathID(const char * path) {
+		{
+			kengine::detail::ReadLock l(g_mutex);
+			if (const auto id = findPathID(path))
+				return *id;
+		}
+
+		kengine::detail::WriteLock l(g_mutex);
+		const auto [it, inserted] = g_pathIDs.emplace(path, g_paths.size());
+		if (inserted)
+			g_paths.push_back(path);
+		return it->second;
+	}
+
+	const char * getPath(PathID id) {
+		kengine::detail::ReadLock l(g_mutex);
+		return g_paths[id].c_str();
+	}
+
+	// Expects g_mutex to be held for writing
+	static void addRefLocked(Entity::ID asset) {
+		auto & info = g_assets[asset];
+		if (++info.refCount == 1)
+			for (const auto dependency : info.dependencies)
+				addRefLocked(dependency);
+	}
+
+	static size_t removeRefLocked(Entity::ID asset) {
+		const auto it = g_assets.find(asset);
+		if (it == g_assets.end() || it->second.refCount == 0)
+			return 0;
+
+		const auto ret = --it->second.refCount;
+		if (ret == 0)
+			for (const auto dependency : it->second.dependencies) // `removeRefLocked` never inserts, so `it` stays valid
+				removeRefLocked(dependency);
+		return ret;
+	}
+
+	void remove(Entity::ID asset) {
+		kengine::detail::WriteLock l(g_mutex);
+		const auto it = g_assets.find(asset);
+		if (it == g_assets.end())
+			return;
+
+		if (it->second.refCount > 0)
+			for (const auto dependency : it->second.dependencies)
+				removeRefLocked(dependency);
+		const auto entity = g_entities.find(it->second.key);
+		if (entity != g_entities.end() && entity->second == asset)
+			g_entities.erase(entity);
+		g_assets.erase(it);
+	}
+
+	const char * getAssetPath(Entity::ID asset) {
+		kengine::detail::ReadLock l(g_mutex);
+		const auto it = g_assets.find(asset);
+		if (it == g_assets.end() || it->second.key == INVALID_KEY)
+			return nullptr;
+		return g_paths[it->second.key / KENGINE_COMPONENT_COUNT].c_str();
+	}
+
+	void setReloader(Entity::ID asset, Reloader reloader) {
+		kengine::detail::WriteLock l(g_mutex);
+		g_assets[asset].reloader = reloader;
+	}
+
+	Reloader getReloader(Entity::ID asset) {
+		kengine::detail::ReadLock l(g_mutex);
+		const auto it = g_assets.find(asset);
+		return it != g_assets.end() ? it->second.reloader : nullptr;
+	}
+
+	void addRef(Entity::ID asset) {
+		kengine::detail::WriteLock l(g_mutex);
+		addRefLocked(asset);
+	}
+
+	size_t removeRef(Entity::ID asset) {
+		kengine::detail::WriteLock l(g_mutex);
+		return removeRefLocked(asset);
+	}
+
+	size_t getRefCount(Entity::ID asset) {
+		kengine::detail::ReadLock l(g_mutex);
+		const auto it = g_assets.find(asset);
+		return it != g_assets.end() ? it->second.refCount : 0;
+	}
+
+	void addDependency(Entity::ID asset, Entity::ID dependency) {
+		kengine::detail::WriteLock l(g_mutex);
+		auto & dependencies = g_assets[asset].dependencies;
+		if (std::find(dependencies.begin(), dependencies.end(), dependency) != dependencies.end())
+			return; // Models are committed again when reloaded
+
+		dependencies.push_back(dependency);
+		if (g_assets[asset].refCount > 0)
+			addRefLocked(dependency);
+	}
+
+	void getDependencies(Entity::ID asset, std::vector<Entity::ID> & dependencies) {
+		kengine::detail::ReadLock l(g_mutex);
+		const auto it = g_assets.find(asset);
+		if (it != g_assets.end())
+			dependencies.insert(dependencies.end(), it->second.dependencies.begin(), it->second.dependencies.end());
+	}
+
+	namespace detail {
+		Entity::ID find(size_t component, const char * path) {
+			kengine::detail::ReadLock l(g_mutex);
+			const auto id = findPathID(path);
+			if (id == nullptr)
+				return Entity::INVALID_ID;
+
+			const auto it = g_entities.find(getKey(component, *id));
+			return it != g_entities.end() ? it->second : Entity::INVALID_ID;
+		}
+
+		void add(size_t component, const char * path, Entity::ID asset) {
+			const auto key = getKey(component, getPathID(path));
+
+			kengine::detail::WriteLock l(g_mutex);
+			if (g_entities.emplace(key, asset).second)
+				g_assets[asset].key = key;
+		}
+	}
+}
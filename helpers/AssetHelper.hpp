@@ -0,0 +1,81 @@
+#pragma once
+
+#include "EntityManager.hpp"
+
+namespace kengine::AssetHelper {
+	// Interned path: equal paths always get the same ID
+	using PathID = size_t;
+
+	PathID getPathID(const char * path);
+	const char * getPath(PathID id);
+
+	// Returns the asset Entity registered for `path`'s Comp (ModelComponent, TextureModelComponent...), or Entity::INVALID_ID
+	// Thread-safe, so loaders can skip work for assets that are already loaded
+	template<typename Comp>
+	Entity::ID find(const char * path);
+
+	// Returns the asset Entity registered for `path`'s Comp, after creating it if there was none
+	// `create` should attach a Comp for `path` to the new Entity, which is registered before its OnEntityCreated callbacks run
+	template<typename Comp, typename Func> // Func: void(Entity & e)
+	Entity::ID findOrCreate(EntityManager & em, const char * path, Func && create);
+
+	// Registers an asset Entity that wasn't created by `findOrCreate`, unless one already is for `path`'s Comp
+	template<typename Comp>
+	void add(const char * path, Entity::ID asset);
+
+	// Forgets an asset Entity, which must be called when it is removed
+	void remove(Entity::ID asset);
+
+	// Returns the path `asset` was registered for, or nullptr
+	const char * getAssetPath(Entity::ID asset);
+
+	// Loads `asset`'s data again, e.g. once the Residency evicted it from the GPU, without touching the Components it was loaded from
+	using Reloader = void(*)(Entity & asset);
+	// Called by the loader that registered `asset`
+	void setReloader(Entity::ID asset, Reloader reloader);
+	// Returns nullptr if `asset`'s loader can't reload it
+	Reloader getReloader(Entity::ID asset);
+
+	// Reference counts of asset Entities. `removeRef` returns the new count
+	void addRef(Entity::ID asset);
+	size_t removeRef(Entity::ID asset);
+	size_t getRefCount(Entity::ID asset);
+
+	// `dependency` (e.g. a texture) is referenced once for as long as `asset` (e.g. a model using it) is referenced
+	void addDependency(Entity::ID asset, Entity::ID dependency);
+	// Appends `asset`'s dependencies to `dependencies`
+	void getDependencies(Entity::ID asset, std::vector<Entity::ID> & dependencies);
+}
+
+namespace kengine::AssetHelper {
+	namespace detail {
+		Entity::ID find(size_t component, const char * path);
+		void add(size_t component, const char * path, Entity::ID asset);
+	}
+
+	template<typename Comp>
+	Entity::ID find(const char * path) {
+		return detail::find(Component<Comp>::id(), path);
+	}
+
+	template<typename Comp, typename Func>
+	Entity::ID findOrCreate(EntityManager & em, const char * path, Func && create) {
+		const auto component = Component<Comp>::id();
+
+		auto ret = detail::find(component, path);
+		if (ret != Entity::INVALID_ID)
+			return ret;
+
+		em += [&](Entity & e) {
+			ret = e.id;
+			detail::add(component, path, e.id);
+			create(e);
+		};
+		return ret;
+	}
+
+	template<typename Comp>
+	void add(const char * path, Entity::ID asset) {
+		detail::add(Component<Comp>::id(), path, asset);
+	}
+}
@@ -3,6 +3,8 @@
 
 #include "helpers/TypeHelper.hpp"
 #include "helpers/SortHelper.hpp"
+#include "helpers/MetaTableHelper.hpp"
+#include "data/NameComponent.hpp"
 #include "meta/Has.hpp"
 #include "meta/AttachTo.hpp"
 #include "meta/DetachFrom.hpp"
@@ -11,53 +13,60 @@
 #include "imgui.h"
 
 namespace kengine::ImGuiHelper {
+	// Returns the Meta Components for each of e's Components, sorted by name
+	template<typename Meta>
+	static auto getSortedFunctions(EntityManager & em, const Entity & e) {
+		putils::vector<std::pair<const NameComponent *, const Meta *>, KENGINE_COMPONENT_COUNT> ret;
+
+		for (size_t id = 0; id < e.componentMask.size(); ++id) {
+			if (!e.componentMask.test(id))
+				continue;
+
+			const auto name = MetaTableHelper::get<NameComponent>(em, id);
+			const auto func = MetaTableHelper::get<Meta>(em, id);
+			if (name != nullptr && func != nullptr)
+				ret.emplace_back(name, func);
+		}
+
+		std::sort(ret.begin(), ret.end(), [](const auto & lhs, const auto & rhs) {
+			return strcmp(lhs.first->name, rhs.first->name) < 0;
+		});
+
+		return ret;
+	}
+
 	void displayEntity(EntityManager & em, const Entity & e) {
-		const auto types = SortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
-			meta::Has, meta::DisplayImGui
-		>(em);
-
-		for (const auto & [_, name, has, display] : types)
-			if (has->call(e))
-				if (ImGui::TreeNode(name->name)) {
-					display->call(e);
-					ImGui::TreePop();
-				}
+		for (const auto & [name, display] : getSortedFunctions<meta::DisplayImGui>(em, e))
+			if (ImGui::TreeNode(name->name)) {
+				display->call(e);
+				ImGui::TreePop();
+			}
 	}
 
 	void editEntity(EntityManager & em, Entity & e) {
 		if (ImGui::CollapsingHeader("Edit")) {
-			const auto types = SortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
-				meta::Has, meta::EditImGui
-			>(em);
-
-			for (const auto & [_, name, has, edit] : types)
-				if (has->call(e))
-					if (ImGui::TreeNode(name->name + "##edit")) {
-						edit->call(e);
-						ImGui::TreePop();
-					}
+			for (const auto & [name, edit] : getSortedFunctions<meta::EditImGui>(em, e))
+				if (ImGui::TreeNode(name->name + "##edit")) {
+					edit->call(e);
+					ImGui::TreePop();
+				}
 		}
 
 		if (ImGui::CollapsingHeader("Add")) {
-			const auto types = SortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
+			static SortHelper::NameSortedView<KENGINE_COMPONENT_COUNT,
 				meta::Has, meta::AttachTo
-			>(em);
+			> types;
 
-			for (const auto & [_, name, has, add] : types)
+			for (const auto & [_, name, has, add] : types.update(em))
 				if (!has->call(e))
 					if (ImGui::Button(name->name + "##add"))
 						add->call(e);
 		}
 
 		if (ImGui::CollapsingHeader("Remove")) {
-			const auto types = SortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
-				meta::Has, meta::DetachFrom
-			>(em);
-
-			for (const auto & [_, name, has, remove] : types)
-				if (has->call(e))
-					if (ImGui::Button(name->name + "##remove"))
-						remove->call(e);
+			for (const auto & [name, remove] : getSortedFunctions<meta::DetachFrom>(em, e))
+				if (ImGui::Button(name->name + "##remove"))
+					remove->call(e);
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cctype>
+
+#include "JSONHelper.hpp"
+#include "EntityManager.hpp"
+#include "helpers/VFS.hpp"
+
+#include "meta/LoadFromJSON.hpp"
+
+#include "json.hpp"
+
+#ifndef KENGINE_NDEBUG
+# include <iostream>
+# include "termcolor.hpp"
+#endif
+
+#ifndef KENGINE_JSON_SCENE_BATCH_SIZE
+# define KENGINE_JSON_SCENE_BATCH_SIZE 1024
+#endif
+
+#ifndef KENGINE_JSON_SCENE_RECORDS_PER_TASK
+# define KENGINE_JSON_SCENE_RECORDS_PER_TASK 32
+#endif
+
+#ifndef KENGINE_JSON_SCENE_READ_BUFFER_SIZE
+# define KENGINE_JSON_SCENE_READ_BUFFER_SIZE 65536
+#endif
+
+namespace kengine::JSONHelper {
+	namespace detail {
+		using LoaderMap = std::unordered_map<std::string, meta::LoadFromJSON>;
+
+		static LoaderMap getLoaders(EntityManager & em) {
+			LoaderMap ret;
+			for (const auto & [e, key, loader] : em.getEntities<meta::LoadFromJSONKey, meta::LoadFromJSON>())
+				ret.emplace(key.name, loader);
+			return ret;
+		}
+
+		// Extracts the raw text of each element in a top-level JSON array, without building a DOM
+		// Elements which aren't objects are extracted too, so that the loader can report them
+		class RecordReader {
+		public:
+			RecordReader(std::istream & stream) : _stream(stream) {}
+
+			// Returns false once the array has been exhausted
+			bool next(std::string & out) {
+				out.clear();
+
+				char c;
+				while (!_done && get(c)) {
+					if (_depth == 0) { // Before the top-level array
+						if (c == '[')
+							_depth = 1;
+						continue;
+					}
+
+					if (_depth == 1 && out.empty()) { // Between records
+						if (c == ']') {
+							_done = true;
+							return false;
+						}
+						if (c == ',' || std::isspace((unsigned char)c))
+							continue;
+					}
+
+					if (_depth == 1 && !_inString && (c == ',' || c == ']')) { // End of a scalar element: containers return as soon as they're closed
+						_done = c == ']';
+						return true;
+					}
+
+					out += c;
+
+					if (_inString) {
+						if (_escaped)
+							_escaped = false;
+						else if (c == '\\')
+							_escaped = true;
+						else if (c == '"')
+							_inString = false;
+						continue;
+					}
+
+					if (c == '"')
+						_inString = true;
+					else if (c == '{' || c == '[')
+						++_depth;
+					else if (c == '}' || c == ']') {
+						--_depth;
+						if (_depth == 1)
+							return true;
+					}
+				}
+
+				return false;
+			}
+
+		private:
+			bool get(char & c) {
+				if (_pos == _size) {
+					_stream.read(_buffer, sizeof(_buffer));
+					_size = (size_t)_stream.gcount();
+					_pos = 0;
+					if (_size == 0)
+						return false;
+				}
+				c = _buffer[_pos++];
+				return true;
+			}
+
+		private:
+			std::istream & _stream;
+			char _buffer[KENGINE_JSON_SCENE_READ_BUFFER_SIZE];
+			size_t _pos = 0;
+			size_t _size = 0;
+
+			size_t _depth = 0;
+			bool _inString = false;
+			bool _escaped = false;
+			bool _done = false;
+		};
+	}
+
+	void loadScene(EntityManager & em, const char * file) {
+		VFS::InputStream f(file);
+		if (!f) {
+#ifndef KENGINE_NDEBUG
+			std::cerr << putils::termcolor::red << "[JSONHelper] Failed to open `" << file << "`\n" << putils::termcolor::reset;
+#endif
+			return;
+		}
+		loadScene(em, f);
+	}
+
+	void loadScene(EntityManager & em, std::istream & stream) {
+		const auto loaders = detail::getLoaders(em);
+		const auto reader = std::make_unique<detail::RecordReader>(stream);
+
+		// Only one batch of records is ever held in memory
+		std::vector<std::string> records(KENGINE_JSON_SCENE_BATCH_SIZE);
+		std::vector<putils::json> parsed(KENGINE_JSON_SCENE_BATCH_SIZE);
+		std::vector<size_t> valid; // Indices of the records that are objects
+
+		bool done = false;
+		while (!done) {
+			size_t count = 0;
+			while (count < records.size() && reader->next(records[count]))
+				++count;
+			done = count < records.size();
+
+			for (size_t start = 0; start < count; start += KENGINE_JSON_SCENE_RECORDS_PER_TASK) {
+				const auto end = std::min(count, start + KENGINE_JSON_SCENE_RECORDS_PER_TASK);
+				em.runTask([&, start, end] {
+					for (size_t i = start; i < end; ++i)
+						parsed[i] = putils::json::parse(records[i], nullptr, false);
+				});
+			}
+			em.completeTasks();
+
+			valid.clear();
+			for (size_t i = 0; i < count; ++i) {
+				if (parsed[i].is_object()) {
+					valid.push_back(i);
+					continue;
+				}
+#ifndef KENGINE_NDEBUG
+				std::cerr << putils::termcolor::red << "[JSONHelper] Skipping entity record that isn't a valid JSON object:\n" << records[i] << '\n' << putils::termcolor::reset;
+#endif
+			}
+
+			em.createEntities(valid.size(), [&](Entity & e, size_t index) {
+				const auto & json = parsed[valid[index]];
+				for (auto it = json.begin(); it != json.end(); ++it) {
+					const auto loader = loaders.find(it.key());
+					if (loader != loaders.end())
+						loader->second(it.value(), e);
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <istream>
+
+namespace kengine { class EntityManager; }
+
+namespace kengine::JSONHelper {
+	// Scene files are a JSON array of entity objects, each key of which names a Component
+	void loadScene(EntityManager & em, const char * file);
+	void loadScene(EntityManager & em, std::istream & stream);
+}
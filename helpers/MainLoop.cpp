@@ -18,4 +18,10 @@ namespace kengine::MainLoop {
 			end = std::chrono::system_clock::now();
 		}
 	}
+
+	void runFrames(EntityManager & em, size_t frames, float deltaTime) {
+		for (size_t i = 0; i < frames && em.running; ++i)
+			for (const auto & [e, func] : em.getEntities<functions::Execute>())
+				func(deltaTime);
+	}
 }
\ No newline at end of file
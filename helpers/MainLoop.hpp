@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstddef>
+
 namespace kengine { class EntityManager; }
 
 namespace kengine::MainLoop {
 	void run(EntityManager & em);
-}
\ No newline at end of file
+	void runFrames(EntityManager & em, size_t frames, float deltaTime);
+}
@@ -0,0 +1,139 @@
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+namespace kengine {
+	// Data of empty files, which can't be mapped but are still open
+	static const char g_empty = 0;
+
+	MappedFile & MappedFile::operator=(MappedFile && rhs) noexcept {
+		if (this == &rhs)
+			return *this;
+
+		close();
+		std::swap(_data, rhs._data);
+		std::swap(_size, rhs._size);
+#ifdef _WIN32
+		std::swap(_file, rhs._file);
+		std::swap(_mapping, rhs._mapping);
+#endif
+		return *this;
+	}
+
+	bool MappedFile::open(const char * file) {
+		close();
+
+#ifdef _WIN32
+		_file = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE) {
+			_file = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size)) {
+			close();
+			return false;
+		}
+
+		if (size.QuadPart == 0) {
+			CloseHandle(_file);
+			_file = nullptr;
+			_data = &g_empty;
+			return true;
+		}
+
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mapping == nullptr) {
+			close();
+			return false;
+		}
+
+		_data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (_data == nullptr) {
+			close();
+			return false;
+		}
+		_size = (size_t)size.QuadPart;
+#else
+		const auto fd = ::open(file, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			::close(fd);
+			return false;
+		}
+
+		if (st.st_size == 0) {
+			::close(fd);
+			_data = &g_empty;
+			return true;
+		}
+
+		const auto data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // The mapping keeps the file alive
+		if (data == MAP_FAILED)
+			return false;
+
+		_data = data;
+		_size = (size_t)st.st_size;
+#endif
+		return true;
+	}
+
+	void MappedFile::close() {
+#ifdef _WIN32
+		if (_data != nullptr && _data != &g_empty)
+			UnmapViewOfFile(_data);
+		if (_mapping != nullptr)
+			CloseHandle(_mapping);
+		if (_file != nullptr)
+			CloseHandle(_file);
+		_mapping = nullptr;
+		_file = nullptr;
+#else
+		if (_data != nullptr && _data != &g_empty)
+			munmap(const_cast<void *>(_data), _size);
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	bool MappedFile::write(const char * file, const void * data, size_t size) {
+		// Unique per thread, so concurrent writers of the same file each rename a complete copy
+		const auto tmp = std::string(file) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream stream(tmp, std::ofstream::binary | std::ofstream::trunc);
+			if (!stream)
+				return false;
+			stream.write((const char *)data, size);
+			if (!stream)
+				return false;
+		}
+
+		std::error_code err;
+		std::filesystem::rename(tmp, file, err);
+		if (err) {
+			std::filesystem::remove(tmp, err);
+			return false;
+		}
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace kengine {
+	// Read-only memory mapping of a whole file. Movable, unmapped on destruction
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const char * file) { open(file); }
+		~MappedFile() { close(); }
+
+		MappedFile(MappedFile && rhs) noexcept { *this = std::move(rhs); }
+		MappedFile & operator=(MappedFile && rhs) noexcept;
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		// Returns false if `file` couldn't be mapped. Empty files are open, with a size of 0
+		bool open(const char * file);
+		void close();
+
+		bool isOpen() const { return _data != nullptr; }
+		const void * data() const { return _data; }
+		size_t size() const { return _size; }
+
+		// Replaces `file`'s contents through a temporary file, so that existing mappings of it are never modified in place
+		// Returns false if it couldn't be written, e.g. on Windows while it is mapped
+		static bool write(const char * file, const void * data, size_t size);
+
+	private:
+		const void * _data = nullptr;
+		size_t _size = 0;
+#ifdef _WIN32
+		void * _file = nullptr; // HANDLE
+		void * _mapping = nullptr; // HANDLE
+#endif
+	};
+}
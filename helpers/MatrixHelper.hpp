@@ -1,10 +1,88 @@
 #pragma once
 
+#include <cmath>
 #include <glm/glm.hpp>
 #include "Point.hpp"
 
+#include "data/TransformComponent.hpp"
+#include "data/ModelComponent.hpp"
+
 namespace kengine {
 	namespace MatrixHelper {
 		inline putils::Point3f getPos(const glm::mat4 & mat) { return { mat[3][0], mat[3][1], mat[3][2] }; }
+
+		// Equivalent to rotating around Y, then X, then Z
+		inline glm::mat3 getRotation(float yaw, float pitch, float roll) {
+			const auto cy = std::cos(yaw), sy = std::sin(yaw);
+			const auto cp = std::cos(pitch), sp = std::sin(pitch);
+			const auto cr = std::cos(roll), sr = std::sin(roll);
+
+			return {
+				{ cy * cr + sy * sp * sr, cp * sr, -sy * cr + cy * sp * sr },
+				{ -cy * sr + sy * sp * cr, cp * cr, sy * sr + cy * sp * cr },
+				{ sy * cp, -sp, cy * cp }
+			};
+		}
+
+		// translate(position) * rotate(yaw, pitch, roll) * scale(size)
+		inline glm::mat4 getTransformMatrix(const TransformComponent & transform) {
+			const auto & size = transform.boundingBox.size;
+			const auto & pos = transform.boundingBox.position;
+
+			glm::mat4 ret(getRotation(transform.yaw, transform.pitch, transform.roll));
+			ret[0] *= size.x;
+			ret[1] *= size.y;
+			ret[2] *= size.z;
+			ret[3] = { pos.x, pos.y, pos.z, 1.f };
+			return ret;
+		}
+
+		// translate(transform) * rotate(transform) * scale(transform) * rotate(model) * translate(-model) * scale(model), folded into a single affine transform
+		inline glm::mat4 getModelMatrix(const ModelComponent & modelInfo, const TransformComponent & transform) {
+			const auto toVec = [](const putils::Point3f & p) { return glm::vec3(p.x, p.y, p.z); };
+
+			glm::mat3 scale(1.f);
+			scale[0][0] = transform.boundingBox.size.x;
+			scale[1][1] = transform.boundingBox.size.y;
+			scale[2][2] = transform.boundingBox.size.z;
+
+			const auto rotationScale = getRotation(transform.yaw, transform.pitch, transform.roll) * scale * getRotation(modelInfo.yaw, modelInfo.pitch, modelInfo.roll);
+			const auto translation = toVec(transform.boundingBox.position) - rotationScale * toVec(modelInfo.boundingBox.position);
+
+			const auto & modelSize = modelInfo.boundingBox.size;
+			glm::mat4 ret(rotationScale);
+			ret[0] *= modelSize.x;
+			ret[1] *= modelSize.y;
+			ret[2] *= modelSize.z;
+			ret[3] = glm::vec4(translation, 1.f);
+			return ret;
+		}
+
+		// Inverse of getTransformMatrix. Shear (from non-uniform scale combined with rotation) is lost
+		inline void toTransform(const glm::mat4 & mat, TransformComponent & transform) {
+			const glm::vec3 x(mat[0]), y(mat[1]), z(mat[2]);
+			const glm::vec3 size(glm::length(x), glm::length(y), glm::length(z));
+			transform.boundingBox.position = getPos(mat);
+			transform.boundingBox.size = { size.x, size.y, size.z };
+
+			const glm::mat3 rot(
+				size.x != 0.f ? x / size.x : x,
+				size.y != 0.f ? y / size.y : y,
+				size.z != 0.f ? z / size.z : z
+			);
+
+			// See getRotation for the layout of `rot`
+			transform.pitch = std::asin(glm::clamp(-rot[2][1], -1.f, 1.f));
+			if (std::abs(rot[2][1]) < .9999f) {
+				transform.yaw = std::atan2(rot[2][0], rot[2][2]);
+				transform.roll = std::atan2(rot[0][1], rot[1][1]);
+			}
+			else { // Gimbal lock: only yaw + roll (or yaw - roll) can be recovered
+				transform.yaw = std::atan2(-rot[0][2], rot[0][0]);
+				transform.roll = 0.f;
+			}
+
+			transform.markDirty();
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,537 @@
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "MeshOptimizer.hpp"
+
+namespace kengine::MeshOptimizer {
+	static constexpr size_t CACHE_SIZE = KENGINE_MESH_OPTIMIZER_CACHE_SIZE;
+	static_assert(CACHE_SIZE > 3, "The vertex cache must hold more than a triangle");
+
+	// FIFO cache simulation: a vertex is cached if it was last shaded less than CACHE_SIZE misses ago
+	class FIFOCache {
+	public:
+		explicit FIFOCache(size_t vertexCount) : _timestamps(vertexCount, 0) {}
+
+		void clear() { _time += CACHE_SIZE + 1; }
+
+		// Returns the number of the triangle's vertices that had to be shaded
+		unsigned int add(const std::uint32_t * triangle) {
+			unsigned int misses = 0;
+			for (size_t i = 0; i < 3; ++i) {
+				auto & timestamp = _timestamps[triangle[i]];
+				if (_time - timestamp >= CACHE_SIZE) {
+					timestamp = _time++;
+					++misses;
+				}
+			}
+			return misses;
+		}
+
+	private:
+		std::vector<size_t> _timestamps;
+		size_t _time = CACHE_SIZE + 1; // So that no vertex starts out cached
+	};
+
+	float getACMR(const std::uint32_t * indices, size_t indexCount, size_t vertexCount) {
+		const auto triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return 0.f;
+
+		FIFOCache cache(vertexCount);
+		size_t misses = 0;
+		for (size_t i = 0; i < triangleCount; ++i)
+			misses += cache.add(indices + i * 3);
+		return (float)misses / (float)triangleCount;
+	}
+
+	// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation": greedily emits the triangle whose vertices score highest,
+	// favoring vertices recently added to a modeled LRU cache and those with few triangles left to emit
+	namespace Forsyth {
+		static constexpr float CACHE_DECAY_POWER = 1.5f;
+		static constexpr float LAST_TRIANGLE_SCORE = .75f;
+		static constexpr float VALENCE_BOOST_SCALE = 2.f;
+		static constexpr float VALENCE_BOOST_POWER = .5f;
+		static constexpr int NOT_CACHED = -1;
+
+		static float getVertexScore(int cachePosition, unsigned int remainingTriangles) {
+			if (remainingTriangles == 0)
+				return -1.f; // Won't be used again
+
+			float score = 0.f;
+			if (cachePosition >= 0) {
+				if (cachePosition < 3) // Used by the last triangle: a fixed score, so that triangles aren't emitted right back to back
+					score = LAST_TRIANGLE_SCORE;
+				else {
+					const auto scaler = 1.f / (float)(CACHE_SIZE - 3);
+					score = std::pow(1.f - (float)(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+				}
+			}
+
+			// Finish off vertices with few triangles left, so they don't linger as lone triangles
+			score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+			return score;
+		}
+	}
+
+	void optimizeVertexCache(std::uint32_t * indices, size_t indexCount, size_t vertexCount) {
+		const auto triangleCount = indexCount / 3;
+		if (triangleCount <= 1)
+			return;
+
+		struct Vertex {
+			float score = 0.f;
+			int cachePosition = Forsyth::NOT_CACHED;
+			unsigned int remainingTriangles = 0; // Live entries in `adjacency` from `firstTriangle`
+			size_t firstTriangle = 0;
+		};
+		std::vector<Vertex> vertices(vertexCount);
+
+		// Triangles using each vertex
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++vertices[indices[i]].remainingTriangles;
+		size_t offset = 0;
+		for (auto & vertex : vertices) {
+			vertex.firstTriangle = offset;
+			offset += vertex.remainingTriangles;
+			vertex.remainingTriangles = 0;
+		}
+		std::vector<std::uint32_t> adjacency(triangleCount * 3);
+		for (size_t i = 0; i < triangleCount * 3; ++i) {
+			auto & vertex = vertices[indices[i]];
+			adjacency[vertex.firstTriangle + vertex.remainingTriangles++] = (std::uint32_t)(i / 3);
+		}
+
+		for (auto & vertex : vertices)
+			vertex.score = Forsyth::getVertexScore(vertex.cachePosition, vertex.remainingTriangles);
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		const auto scoreTriangle = [&](size_t triangle) {
+			const auto t = indices + triangle * 3;
+			return vertices[t[0]].score + vertices[t[1]].score + vertices[t[2]].score;
+		};
+
+		size_t bestTriangle = 0;
+		for (size_t i = 0; i < triangleCount; ++i) {
+			triangleScores[i] = scoreTriangle(i);
+			if (triangleScores[i] > triangleScores[bestTriangle])
+				bestTriangle = i;
+		}
+
+		std::vector<std::uint32_t> result;
+		result.reserve(triangleCount * 3);
+
+		// Modeled LRU cache, with room for the vertices of a new triangle before the oldest ones are evicted
+		std::uint32_t cache[CACHE_SIZE + 3];
+		size_t cacheCount = 0;
+
+		size_t scanPosition = 0; // Triangles before it have all been emitted
+		for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+			const auto triangle = indices + bestTriangle * 3;
+			result.insert(result.end(), triangle, triangle + 3);
+			emitted[bestTriangle] = true;
+
+			// Remove the triangle from its vertices' adjacency
+			for (size_t i = 0; i < 3; ++i) {
+				auto & vertex = vertices[triangle[i]];
+				const auto begin = adjacency.begin() + vertex.firstTriangle;
+				const auto end = begin + vertex.remainingTriangles;
+				const auto it = std::find(begin, end, (std::uint32_t)bestTriangle);
+				std::iter_swap(it, end - 1);
+				--vertex.remainingTriangles;
+			}
+
+			// Move the triangle's vertices to the front of the cache
+			std::uint32_t newCache[CACHE_SIZE + 3];
+			size_t newCacheCount = 0;
+			for (size_t i = 0; i < 3; ++i)
+				if (std::find(newCache, newCache + newCacheCount, triangle[i]) == newCache + newCacheCount) // Degenerate triangles
+					newCache[newCacheCount++] = triangle[i];
+			for (size_t i = 0; i < cacheCount; ++i)
+				if (std::find(newCache, newCache + newCacheCount, cache[i]) == newCache + newCacheCount)
+					newCache[newCacheCount++] = cache[i]; // May temporarily hold up to CACHE_SIZE + 3 vertices
+
+			// Rescore the cached vertices, including those just evicted, then their remaining triangles
+			for (size_t i = 0; i < newCacheCount; ++i) {
+				auto & vertex = vertices[newCache[i]];
+				vertex.cachePosition = i < CACHE_SIZE ? (int)i : Forsyth::NOT_CACHED;
+				vertex.score = Forsyth::getVertexScore(vertex.cachePosition, vertex.remainingTriangles);
+			}
+
+			float bestScore = -1.f;
+			for (size_t i = 0; i < newCacheCount; ++i) {
+				const auto & vertex = vertices[newCache[i]];
+				for (size_t j = 0; j < vertex.remainingTriangles; ++j) {
+					const auto adjacent = adjacency[vertex.firstTriangle + j];
+					triangleScores[adjacent] = scoreTriangle(adjacent);
+					if (triangleScores[adjacent] > bestScore) {
+						bestScore = triangleScores[adjacent];
+						bestTriangle = adjacent;
+					}
+				}
+			}
+
+			cacheCount = std::min(newCacheCount, CACHE_SIZE);
+			std::copy(newCache, newCache + cacheCount, cache);
+
+			if (bestScore < 0.f) { // No cached vertex has triangles left: start over from the next triangle in the original order
+				while (scanPosition < triangleCount && emitted[scanPosition])
+					++scanPosition;
+				bestTriangle = scanPosition;
+			}
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	// Sander, Nehab and Barczak's "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", applied to an existing cache-friendly order
+	void optimizeOverdraw(std::uint32_t * indices, size_t indexCount, const float * positions, size_t vertexCount, size_t positionStride, float threshold) {
+		const auto triangleCount = indexCount / 3;
+		if (triangleCount <= 1)
+			return;
+
+		FIFOCache cache(vertexCount);
+
+		// Hard boundaries: where all of a triangle's vertices miss the cache, the order has moved on to a disjoint part of the mesh
+		std::vector<size_t> hardBoundaries;
+		for (size_t i = 0; i < triangleCount; ++i)
+			if (cache.add(indices + i * 3) == 3 || i == 0)
+				hardBoundaries.push_back(i);
+		hardBoundaries.push_back(triangleCount);
+
+		// Soft boundaries: split hard clusters wherever starting over with an empty cache costs little
+		std::vector<size_t> clusters;
+		for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+			const auto begin = hardBoundaries[h];
+			const auto end = hardBoundaries[h + 1];
+
+			cache.clear();
+			size_t clusterMisses = 0;
+			for (size_t i = begin; i < end; ++i)
+				clusterMisses += cache.add(indices + i * 3);
+			const auto maxACMR = threshold * (float)clusterMisses / (float)(end - begin);
+
+			clusters.push_back(begin);
+			cache.clear();
+			size_t misses = 0;
+			size_t count = 0;
+			for (size_t i = begin; i < end; ++i) {
+				misses += cache.add(indices + i * 3);
+				++count;
+				if (i + 1 < end && (float)misses / (float)count <= maxACMR) {
+					clusters.push_back(i + 1);
+					cache.clear();
+					misses = 0;
+					count = 0;
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+
+		const auto getPosition = [&](std::uint32_t index) {
+			return (const float *)((const char *)positions + index * positionStride);
+		};
+
+		// Area-weighted centroid of the whole mesh
+		float meshCentroid[3] = { 0.f, 0.f, 0.f };
+		float meshArea = 0.f;
+
+		struct Cluster {
+			size_t begin;
+			size_t end;
+			float centroid[3] = { 0.f, 0.f, 0.f };
+			float normal[3] = { 0.f, 0.f, 0.f }; // Area-weighted
+			float area = 0.f;
+			float sortKey = 0.f;
+		};
+		std::vector<Cluster> sorted;
+		sorted.reserve(clusters.size() - 1);
+
+		for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+			Cluster cluster;
+			cluster.begin = clusters[c];
+			cluster.end = clusters[c + 1];
+
+			for (size_t i = cluster.begin; i < cluster.end; ++i) {
+				const auto p0 = getPosition(indices[i * 3]);
+				const auto p1 = getPosition(indices[i * 3 + 1]);
+				const auto p2 = getPosition(indices[i * 3 + 2]);
+
+				const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				const float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				const auto area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				for (size_t k = 0; k < 3; ++k) {
+					cluster.centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.f * area;
+					cluster.normal[k] += normal[k];
+				}
+				cluster.area += area;
+			}
+
+			for (size_t k = 0; k < 3; ++k)
+				meshCentroid[k] += cluster.centroid[k];
+			meshArea += cluster.area;
+
+			if (cluster.area > 0.f)
+				for (auto & v : cluster.centroid)
+					v /= cluster.area;
+			sorted.push_back(cluster);
+		}
+
+		if (meshArea > 0.f)
+			for (auto & v : meshCentroid)
+				v /= meshArea;
+
+		// Clusters facing away from the center are on the outside of the mesh, so draw them first
+		for (auto & cluster : sorted) {
+			const auto length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+			if (length == 0.f)
+				continue;
+			for (size_t k = 0; k < 3; ++k)
+				cluster.sortKey += (cluster.centroid[k] - meshCentroid[k]) * cluster.normal[k] / length;
+		}
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster & lhs, const Cluster & rhs) { return lhs.sortKey > rhs.sortKey; });
+
+		std::vector<std::uint32_t> result;
+		result.reserve(triangleCount * 3);
+		for (const auto & cluster : sorted)
+			result.insert(result.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	size_t optimizeVertexFetch(void * vertices, std::uint32_t * indices, size_t indexCount, size_t vertexCount, size_t vertexSize) {
+		static constexpr auto UNUSED = std::numeric_limits<std::uint32_t>::max();
+		std::vector<std::uint32_t> remap(vertexCount, UNUSED);
+
+		std::uint32_t nextVertex = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			auto & newIndex = remap[indices[i]];
+			if (newIndex == UNUSED)
+				newIndex = nextVertex++;
+			indices[i] = newIndex;
+		}
+
+		const auto bytes = (char *)vertices;
+		std::vector<char> reordered(nextVertex * vertexSize);
+		for (size_t i = 0; i < vertexCount; ++i)
+			if (remap[i] != UNUSED)
+				memcpy(reordered.data() + remap[i] * vertexSize, bytes + i * vertexSize, vertexSize);
+		if (!reordered.empty())
+			memcpy(bytes, reordered.data(), reordered.size());
+
+		return nextVertex;
+	}
+
+	// Symmetric 4x4 matrix measuring the squared distance to a set of planes, from Garland and Heckbert's "Surface Simplification Using Quadric Error Metrics"
+	struct Quadric {
+		float a2 = 0.f, ab = 0.f, ac = 0.f, ad = 0.f;
+		float b2 = 0.f, bc = 0.f, bd = 0.f;
+		float c2 = 0.f, cd = 0.f;
+		float d2 = 0.f;
+
+		void addPlane(float a, float b, float c, float d, float weight) {
+			a2 += a * a * weight; ab += a * b * weight; ac += a * c * weight; ad += a * d * weight;
+			b2 += b * b * weight; bc += b * c * weight; bd += b * d * weight;
+			c2 += c * c * weight; cd += c * d * weight;
+			d2 += d * d * weight;
+		}
+
+		void add(const Quadric & rhs) {
+			a2 += rhs.a2; ab += rhs.ab; ac += rhs.ac; ad += rhs.ad;
+			b2 += rhs.b2; bc += rhs.bc; bd += rhs.bd;
+			c2 += rhs.c2; cd += rhs.cd;
+			d2 += rhs.d2;
+		}
+
+		float getError(const float * p) const {
+			const auto x = p[0], y = p[1], z = p[2];
+			return a2 * x * x + 2.f * ab * x * y + 2.f * ac * x * z + 2.f * ad * x
+				+ b2 * y * y + 2.f * bc * y * z + 2.f * bd * y
+				+ c2 * z * z + 2.f * cd * z
+				+ d2;
+		}
+	};
+
+	size_t simplify(std::uint32_t * destination, const std::uint32_t * indices, size_t indexCount, const float * positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount) {
+		const auto triangleCount = indexCount / 3;
+		if (triangleCount == 0 || targetIndexCount < 3)
+			return 0;
+
+		const auto getPosition = [&](std::uint32_t index) {
+			return (const float *)((const char *)positions + index * positionStride);
+		};
+
+		// Each vertex's quadric holds the planes of its triangles, weighted by their area
+		std::vector<Quadric> quadrics(vertexCount);
+		float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i = 0; i < triangleCount; ++i) {
+			const auto t = indices + i * 3;
+			const auto p0 = getPosition(t[0]);
+			const auto p1 = getPosition(t[1]);
+			const auto p2 = getPosition(t[2]);
+
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 0.f) {
+				for (auto & n : normal)
+					n /= length;
+				const auto d = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+				for (size_t j = 0; j < 3; ++j)
+					quadrics[t[j]].addPlane(normal[0], normal[1], normal[2], d, length / 2.f);
+			}
+
+			for (const auto p : { p0, p1, p2 })
+				for (size_t k = 0; k < 3; ++k) {
+					min[k] = std::min(min[k], p[k]);
+					max[k] = std::max(max[k], p[k]);
+				}
+		}
+		const auto extent = std::max({ max[0] - min[0], max[1] - min[1], max[2] - min[2] });
+
+		static constexpr auto UNUSED = std::numeric_limits<std::uint32_t>::max();
+		std::vector<std::uint32_t> remap(vertexCount, UNUSED);
+		std::vector<std::uint32_t> used;
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			if (remap[indices[i]] == UNUSED) {
+				remap[indices[i]] = indices[i];
+				used.push_back(indices[i]);
+			}
+
+		// Attribute seams (UV chart borders, hard normals, bone weight changes) split vertices: both sides have their own vertex at the same position
+		// Vertices sharing their position with another one are kept as they are, so seams don't crack
+		// Others are only merged with vertices of their chart, i.e. those their triangles connect them to, so attributes aren't smeared across seams
+		std::vector<std::uint32_t> chart(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+			chart[i] = (std::uint32_t)i;
+		const auto findChart = [&](std::uint32_t index) {
+			while (chart[index] != index)
+				index = chart[index] = chart[chart[index]];
+			return index;
+		};
+		for (size_t i = 0; i < triangleCount * 3; ++i) {
+			const auto a = findChart(indices[i]);
+			const auto b = findChart(indices[i - i % 3 + (i + 1) % 3]);
+			if (a != b)
+				chart[std::max(a, b)] = std::min(a, b);
+		}
+		for (const auto index : used)
+			chart[index] = findChart(index);
+
+		struct PositionHash {
+			size_t operator()(const std::array<float, 3> & p) const {
+				const float normalized[3] = { p[0] + 0.f, p[1] + 0.f, p[2] + 0.f }; // -0 equals 0, so it must hash the same
+				std::uint32_t bits[3];
+				memcpy(bits, normalized, sizeof(bits));
+				return std::hash<std::uint64_t>()(((std::uint64_t)bits[0] << 32) | bits[1]) ^ std::hash<std::uint32_t>()(bits[2]) * 31;
+			}
+		};
+		std::vector<bool> seam(vertexCount, false);
+		{
+			std::unordered_map<std::array<float, 3>, std::uint32_t, PositionHash> firstAtPosition;
+			for (const auto index : used) {
+				const auto p = getPosition(index);
+				const auto it = firstAtPosition.emplace(std::array<float, 3>{ p[0], p[1], p[2] }, index).first;
+				if (it->second != index)
+					seam[index] = seam[it->second] = true;
+			}
+		}
+
+		struct Cell {
+			Quadric quadric; // Of all its vertices
+			std::uint32_t vertex = UNUSED; // Minimizing `quadric`
+		};
+		struct CellKey {
+			std::uint64_t cell;
+			std::uint32_t chart;
+			bool operator==(const CellKey & rhs) const { return cell == rhs.cell && chart == rhs.chart; }
+		};
+		struct CellHash {
+			size_t operator()(const CellKey & key) const { return std::hash<std::uint64_t>()(key.cell) ^ std::hash<std::uint32_t>()(key.chart) * 31; }
+		};
+		std::unordered_map<CellKey, Cell, CellHash> cells;
+
+		struct TriangleHash {
+			size_t operator()(const std::array<std::uint32_t, 3> & t) const {
+				return std::hash<std::uint64_t>()(((std::uint64_t)t[0] << 32) | t[1]) ^ std::hash<std::uint32_t>()(t[2]) * 31;
+			}
+		};
+		std::unordered_set<std::array<std::uint32_t, 3>, TriangleHash> emitted;
+
+		// Merges vertices on a grid of `gridSize` cells along the mesh's largest side, writes the remaining triangles to `out` if it isn't null, and returns their index count
+		const auto cluster = [&](size_t gridSize, std::uint32_t * out) {
+			const auto cellSize = extent > 0.f ? extent / (float)gridSize : 1.f;
+			const auto getCell = [&](std::uint32_t index) {
+				const auto p = getPosition(index);
+				std::uint64_t cell = 0;
+				for (size_t k = 0; k < 3; ++k) {
+					const auto coordinate = std::min((std::uint64_t)((p[k] - min[k]) / cellSize), (std::uint64_t)gridSize - 1);
+					cell = cell * gridSize + coordinate;
+				}
+				return CellKey{ cell, chart[index] };
+			};
+
+			cells.clear();
+			for (const auto index : used)
+				if (!seam[index])
+					cells[getCell(index)].quadric.add(quadrics[index]);
+
+			for (const auto index : used) {
+				if (seam[index])
+					continue;
+				auto & cell = cells[getCell(index)];
+				if (cell.vertex == UNUSED || cell.quadric.getError(getPosition(index)) < cell.quadric.getError(getPosition(cell.vertex)))
+					cell.vertex = index;
+			}
+
+			for (const auto index : used)
+				remap[index] = seam[index] ? index : cells[getCell(index)].vertex;
+
+			emitted.clear();
+			size_t count = 0;
+			for (size_t i = 0; i < triangleCount; ++i) {
+				const std::uint32_t t[3] = { remap[indices[i * 3]], remap[indices[i * 3 + 1]], remap[indices[i * 3 + 2]] };
+				if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2])
+					continue; // Collapsed
+
+				std::array<std::uint32_t, 3> sorted = { t[0], t[1], t[2] };
+				std::sort(sorted.begin(), sorted.end());
+				if (!emitted.insert(sorted).second)
+					continue; // Several triangles collapsed into the same one
+
+				if (out != nullptr)
+					std::copy(std::begin(t), std::end(t), out + count);
+				count += 3;
+			}
+			return count;
+		};
+
+		// The index count grows with the grid's size: look for the largest grid that stays within the target
+		size_t low = 1;
+		size_t high = 4096;
+		size_t best = 0;
+		while (low <= high) {
+			const auto gridSize = (low + high) / 2;
+			if (cluster(gridSize, nullptr) <= targetIndexCount) {
+				best = gridSize;
+				low = gridSize + 1;
+			}
+			else
+				high = gridSize - 1;
+		}
+
+		if (best == 0)
+			return 0;
+		return cluster(best, destination);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef KENGINE_MESH_OPTIMIZER_CACHE_SIZE
+# define KENGINE_MESH_OPTIMIZER_CACHE_SIZE 16 // Post-transform vertex cache entries that triangle orders are tuned for
+#endif
+
+namespace kengine::MeshOptimizer {
+	// Reorders triangles so that consecutive ones share vertices, which then hit the post-transform cache instead of being shaded again
+	void optimizeVertexCache(std::uint32_t * indices, size_t indexCount, size_t vertexCount);
+
+	// Reorders clusters of triangles previously sorted by optimizeVertexCache so that those facing outwards, which tend to occlude the others, are drawn first
+	// Clusters are only split where their cache miss ratio stays below `threshold` times that of the whole cluster, e.g. 1.05 allows 5% more misses
+	// `positions` points to the first vertex's position (3 floats), and vertices are `positionStride` bytes apart
+	void optimizeOverdraw(std::uint32_t * indices, size_t indexCount, const float * positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f);
+
+	// Reorders vertices in the order in which indices first reference them, so that vertex fetches are mostly sequential, and drops unreferenced ones
+	// Returns the new vertex count
+	size_t optimizeVertexFetch(void * vertices, std::uint32_t * indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+	// Writes a simplified version of the triangles to `destination`, using as many of the `targetIndexCount` indices as possible, and returns the number of indices written
+	// Vertices are merged by clustering them on a grid, keeping the one that best preserves each cell's surface, so the result only references existing vertices and can share the original's vertex buffer
+	// Vertices split by attribute seams (sharing their position with another vertex) are kept, and others are only merged within the triangles they're connected to
+	// `destination` must hold `indexCount` indices
+	size_t simplify(std::uint32_t * destination, const std::uint32_t * indices, size_t indexCount, const float * positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount);
+
+	// Average number of vertices shaded per triangle (between 0.5 and 3, lower is better) with a FIFO cache of KENGINE_MESH_OPTIMIZER_CACHE_SIZE entries
+	float getACMR(const std::uint32_t * indices, size_t indexCount, size_t vertexCount);
+}
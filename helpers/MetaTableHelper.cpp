@@ -0,0 +1,12 @@
+#include "MetaTableHelper.hpp"
+
+namespace kengine::MetaTableHelper {
+	Entity::ID getTypeEntityID(EntityManager & em, size_t componentID) {
+		auto & components = em._getComponentMap();
+		kengine::detail::ReadLock l(components.mutex);
+		for (const auto & [_, meta] : components.map)
+			if (meta->id == componentID)
+				return meta->typeEntityID;
+		return Entity::INVALID_ID;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "EntityManager.hpp"
+#include "helpers/TypeHelper.hpp"
+
+namespace kengine::MetaTableHelper {
+	// Attaches `value` to Comp's type Entity and records it in `em`'s table for T
+	template<typename Comp, typename T>
+	void attach(EntityManager & em, T && value);
+
+	// Returns the T attached to the type Entity of the Component with the given ID, or nullptr
+	template<typename T>
+	const T * get(EntityManager & em, size_t componentID);
+
+	// Returns the type Entity of the Component with the given ID, or Entity::INVALID_ID
+	Entity::ID getTypeEntityID(EntityManager & em, size_t componentID);
+}
+
+namespace kengine::MetaTableHelper {
+	namespace detail {
+		// Entry for meta Components that aren't attached, so that they aren't looked up again
+		inline const char absent = 0;
+
+		template<typename T>
+		void set(EntityManager & em, size_t componentID, Entity::ID typeEntityID, const T * value) {
+			auto & table = em._getMetaTable();
+			table.typeEntities[componentID] = typeEntityID; // Before the entry, so that a concurrent `clear` can't miss it
+			table.entries[Component<T>::id()][componentID] = value != nullptr ? (const void *)value : &absent;
+		}
+	}
+
+	template<typename Comp, typename T>
+	void attach(EntityManager & em, T && value) {
+		using Type = std::decay_t<T>;
+
+		auto type = TypeHelper::getTypeEntity<Comp>(em);
+		type += FWD(value);
+		detail::set(em, Component<Comp>::id(), type.id, &type.get<Type>()); // Component storage never moves, so this stays valid
+	}
+
+	template<typename T>
+	const T * get(EntityManager & em, size_t componentID) {
+		const void * entry = em._getMetaTable().entries[Component<T>::id()][componentID];
+		if (entry != nullptr)
+			return entry != &detail::absent ? (const T *)entry : nullptr;
+
+		// T may not have been attached through `attach`, or its entry was cleared when its type Entity changed
+		const auto typeEntityID = getTypeEntityID(em, componentID);
+		if (typeEntityID == Entity::INVALID_ID)
+			return nullptr; // Don't record it, the type Entity might be created later
+
+		const auto type = em.getEntity(typeEntityID);
+		const auto ret = type.has<T>() ? &type.get<T>() : nullptr;
+		detail::set(em, componentID, typeEntityID, ret);
+		return ret;
+	}
+}
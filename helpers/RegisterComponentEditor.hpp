@@ -5,6 +5,7 @@
 #include "meta/EditImGui.hpp"
 #include "reflection/imgui_helper.hpp"
 #include "helpers/TypeHelper.hpp"
+#include "helpers/MetaTableHelper.hpp"
 
 namespace kengine {
 	template<typename Comp>
@@ -22,18 +23,26 @@ namespace kengine {
 				putils::reflection::imguiDisplay(e.get<Comp>());
 		}
 
+		template<typename Comp, typename = void>
+		struct HasMarkDirty : std::false_type {};
+		template<typename Comp>
+		struct HasMarkDirty<Comp, std::void_t<decltype(std::declval<Comp &>().markDirty())>> : std::true_type {};
+
 		template<typename Comp>
 		static void editComponent(Entity & e) {
-			if (e.has<Comp>())
-				putils::reflection::imguiEdit(e.get<Comp>());
+			if (!e.has<Comp>())
+				return;
+			auto & comp = e.get<Comp>();
+			putils::reflection::imguiEdit(comp);
+			if constexpr (HasMarkDirty<Comp>()) // The editor doesn't tell whether the Component was modified
+				comp.markDirty();
 		}
 	}
 
 	template<typename Comp>
 	void registerComponentEditor(EntityManager & em) {
-		auto type = TypeHelper::getTypeEntity<Comp>(em);
-		type += meta::DisplayImGui{ detail::displayComponent<Comp> };
-		type += meta::EditImGui{ detail::editComponent<Comp> };
+		MetaTableHelper::attach<Comp>(em, meta::DisplayImGui{ detail::displayComponent<Comp> });
+		MetaTableHelper::attach<Comp>(em, meta::EditImGui{ detail::editComponent<Comp> });
 	}
 
 	template<typename ... Comps>
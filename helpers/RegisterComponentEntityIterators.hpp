@@ -3,6 +3,7 @@
 #include "EntityManager.hpp"
 #include "meta/ForEachEntity.hpp"
 #include "helpers/TypeHelper.hpp"
+#include "helpers/MetaTableHelper.hpp"
 
 namespace kengine {
 	namespace detail {
@@ -21,9 +22,8 @@ namespace kengine {
 	
 	template<typename Comp>
 	void registerComponentEntityIterator(EntityManager & em) {
-		auto type = TypeHelper::getTypeEntity<Comp>(em);
-		type += meta::ForEachEntity{ detail::forEachEntity<Comp> };
-		type += meta::ForEachEntityWithout{ detail::forEachEntityWithout<Comp> };
+		MetaTableHelper::attach<Comp>(em, meta::ForEachEntity{ detail::forEachEntity<Comp> });
+		MetaTableHelper::attach<Comp>(em, meta::ForEachEntityWithout{ detail::forEachEntityWithout<Comp> });
 	}
 
 	template<typename ... Comps>
@@ -5,6 +5,7 @@
 #include "meta/AttachTo.hpp"
 #include "meta/DetachFrom.hpp"
 #include "helpers/TypeHelper.hpp"
+#include "helpers/MetaTableHelper.hpp"
 
 namespace kengine {
 	template<typename Comp>
@@ -28,10 +29,9 @@ namespace kengine {
 
 	template<typename Comp>
 	void registerComponentFunctions(EntityManager & em) {
-		auto type = TypeHelper::getTypeEntity<Comp>(em);
-		type += meta::Has{ detail::has<Comp> };
-		type += meta::AttachTo{ detail::attach<Comp> };
-		type += meta::DetachFrom{ detail::detach<Comp> };
+		MetaTableHelper::attach<Comp>(em, meta::Has{ detail::has<Comp> });
+		MetaTableHelper::attach<Comp>(em, meta::AttachTo{ detail::attach<Comp> });
+		MetaTableHelper::attach<Comp>(em, meta::DetachFrom{ detail::detach<Comp> });
 	}
 
 	template<typename ... Comps>
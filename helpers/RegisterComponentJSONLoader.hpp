@@ -4,6 +4,7 @@
 #include "reflection/json_helper.hpp"
 #include "meta/LoadFromJSON.hpp"
 #include "helpers/TypeHelper.hpp"
+#include "helpers/MetaTableHelper.hpp"
 
 namespace kengine {
 	template<typename Comp>
@@ -16,19 +17,17 @@ namespace kengine {
 namespace kengine {
 	namespace detail {
 		template<typename Component>
-		static void loadJSONComponent(const putils::json & jsonEntity, Entity & e) {
-			const auto it = jsonEntity.find(putils::reflection::get_class_name<Component>());
-			if (it == jsonEntity.end())
-				return;
+		static void loadJSONComponent(const putils::json & json, Entity & e) {
 			auto & comp = e.attach<Component>();
-			putils::reflection::fromJSON(*it, comp);
+			putils::reflection::fromJSON(json, comp);
 		}
 	}
 
 	template<typename Comp>
 	void registerComponentJSONLoader(EntityManager & em) {
-		auto type = TypeHelper::getTypeEntity<Comp>(em);
-		type += meta::LoadFromJSON{ detail::loadJSONComponent<Comp> };
+		MetaTableHelper::attach<Comp>(em, meta::LoadFromJSON{ detail::loadJSONComponent<Comp> });
+		// Lets JSONHelper::loadScene map JSON keys to this loader
+		MetaTableHelper::attach<Comp>(em, meta::LoadFromJSONKey{ putils::reflection::get_class_name<Comp>() });
 	}
 
 	template<typename ... Comps>
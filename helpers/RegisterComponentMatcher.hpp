@@ -3,6 +3,7 @@
 #include "EntityManager.hpp"
 #include "meta/MatchString.hpp"
 #include "helpers/TypeHelper.hpp"
+#include "helpers/MetaTableHelper.hpp"
 #include "sol.hpp"
 
 namespace kengine {
@@ -82,8 +83,7 @@ namespace kengine {
 
 	template<typename Comp>
 	void registerComponentMatcher(EntityManager & em) {
-		auto type = TypeHelper::getTypeEntity<Comp>(em);
-		type += meta::MatchString{ detail::componentMatches<Comp> };
+		MetaTableHelper::attach<Comp>(em, meta::MatchString{ detail::componentMatches<Comp> });
 	}
 
 	template<typename ... Comps>
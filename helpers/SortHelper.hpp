@@ -11,6 +11,40 @@ namespace kengine::SortHelper {
 
 	template<size_t MaxCount, typename ... Comps>
 	auto getNameSortedEntities(EntityManager & em);
+
+	// Persistent equivalent of getSortedEntities, only rebuilt when Comps are added or removed
+	template<size_t MaxCount, typename Pred, typename ... Comps>
+	class SortedView {
+	public:
+		using Type = std::tuple<Entity, Comps *...>;
+
+		SortedView(Pred && pred = Pred{}) : _pred(FWD(pred)) {}
+
+		// Brings the view up to date and returns it, so it can be iterated over directly
+		const SortedView & update(EntityManager & em);
+
+		auto begin() const { return _entities.begin(); }
+		auto end() const { return _entities.end(); }
+		size_t size() const { return _entities.size(); }
+
+	private:
+		putils::vector<Type, MaxCount> _entities;
+		size_t _versions[sizeof...(Comps)] = {};
+		bool _initialized = false;
+		Pred _pred;
+	};
+
+	namespace detail {
+		struct NameCompare {
+			template<typename T>
+			bool operator()(const T & lhs, const T & rhs) const {
+				return strcmp(std::get<1>(lhs)->name, std::get<1>(rhs)->name) < 0;
+			}
+		};
+	}
+
+	template<size_t MaxCount, typename ... Comps>
+	using NameSortedView = SortedView<MaxCount, detail::NameCompare, NameComponent, Comps...>;
 }
 
 namespace kengine::SortHelper {
@@ -50,10 +84,48 @@ namespace kengine::SortHelper {
 
 	template<size_t MaxCount, typename ... Comps>
 	auto getNameSortedEntities(EntityManager & em) {
-		return getSortedEntities<MaxCount, NameComponent, Comps...>(em,
-			[](const auto & lhs, const auto & rhs) {
-				return strcmp(std::get<1>(lhs)->name, std::get<1>(rhs)->name) < 0;
+		return getSortedEntities<MaxCount, NameComponent, Comps...>(em, detail::NameCompare{});
+	}
+
+	template<size_t MaxCount, typename Pred, typename ... Comps>
+	const SortedView<MaxCount, Pred, Comps...> & SortedView<MaxCount, Pred, Comps...>::update(EntityManager & em) {
+		bool changed = !_initialized;
+
+		size_t i = 0;
+		putils::for_each_type<Comps...>([&](auto && type) {
+			using T = putils_wrapped_type(type);
+
+			size_t id;
+			if constexpr (kengine::is_not<T>())
+				id = Component<typename T::CompType>::id();
+			else
+				id = Component<T>::id();
+
+			const auto version = em.getComponentVersion(id);
+			if (version != _versions[i]) {
+				_versions[i] = version;
+				changed = true;
+			}
+			++i;
+		});
+
+		if (changed) {
+			_entities.clear();
+			for (const auto & t : em.getEntities<Comps...>()) {
+				if (_entities.full())
+					break;
+				_entities.emplace_back();
+				detail::set(_entities.back(), t, std::make_index_sequence<sizeof...(Comps)>());
 			}
-		);
+			std::sort(_entities.begin(), _entities.end(), _pred);
+			_initialized = true;
+		}
+		else if (!std::is_sorted(_entities.begin(), _entities.end(), _pred)) {
+			// Keys have changed since the last update: the view is nearly sorted, so insertion sort is cheap and doesn't allocate
+			for (auto it = _entities.begin(); it != _entities.end(); ++it)
+				std::rotate(std::upper_bound(_entities.begin(), it, *it, _pred), it, it + 1);
+		}
+
+		return *this;
 	}
 }
\ No newline at end of file
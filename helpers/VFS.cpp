@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include "VFS.hpp"
+#include "termcolor.hpp"
+
+namespace kengine::VFS {
+	// Pack layout: Header, then each file's blob, then the Entries sorted by path hash, then the paths
+	static constexpr char MAGIC[] = { 'K', 'P', 'A', 'K' };
+	static constexpr std::uint32_t VERSION = 2;
+	static constexpr size_t ALIGNMENT = 16; // Blobs are aligned so cooked assets can be used in place
+
+	struct Header {
+		char magic[sizeof(MAGIC)];
+		std::uint32_t version;
+		std::uint64_t entryCount;
+		std::uint64_t entriesOffset;
+	};
+
+	struct Entry {
+		std::uint64_t pathHash;
+		std::uint64_t offset;
+		std::uint64_t storedSize; // Differs from `size` if the blob is compressed
+		std::uint64_t size;
+		std::uint64_t pathOffset; // From the end of the Entries
+		std::uint64_t pathLength;
+		std::uint64_t contentHash; // Of the original data, so that caches don't have to read it to detect changes
+	};
+
+	struct Pack {
+		MappedFile file;
+		const Entry * entries = nullptr;
+		size_t entryCount = 0;
+		const char * paths = nullptr;
+	};
+
+	static std::vector<std::unique_ptr<Pack>> g_packs;
+	static std::shared_mutex g_packsMutex;
+
+	// Paths are stored with forward slashes and without leading "./", so that any spelling of a path finds its entry
+	static std::string normalize(const char * path) {
+		std::string ret = path;
+		std::replace(ret.begin(), ret.end(), '\\', '/');
+		while (ret.compare(0, 2, "./") == 0)
+			ret.erase(0, 2);
+		return ret;
+	}
+
+	static std::uint64_t hashBytes(const void * data, size_t size) { // FNV-1a
+		std::uint64_t hash = 14695981039346656037ull;
+		const auto bytes = (const unsigned char *)data;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static std::uint64_t hashPath(const std::string & path) {
+		return hashBytes(path.data(), path.size());
+	}
+
+	// Expects g_packsMutex to be held
+	static const Entry * find(const std::string & path, const Pack ** pack) {
+		const auto hash = hashPath(path);
+		for (auto it = g_packs.rbegin(); it != g_packs.rend(); ++it) {
+			const auto & p = **it;
+			const auto end = p.entries + p.entryCount;
+			for (auto entry = std::lower_bound(p.entries, end, hash, [](const Entry & e, std::uint64_t h) { return e.pathHash < h; });
+				entry != end && entry->pathHash == hash; ++entry)
+				if (path.compare(0, std::string::npos, p.paths + entry->pathOffset, entry->pathLength) == 0) {
+					*pack = &p;
+					return entry;
+				}
+		}
+		return nullptr;
+	}
+
+	namespace lz {
+		// LZ4-style sequences: a token holding the literal count and match length, the literals, then the match's 16-bit offset. The last sequence has no match
+		static constexpr size_t MIN_MATCH = 4;
+		static constexpr size_t MAX_OFFSET = 0xffff;
+		static constexpr size_t HASH_BITS = 16;
+
+		static void writeLength(std::vector<char> & out, size_t length) {
+			while (length >= 255) {
+				out.push_back((char)255);
+				length -= 255;
+			}
+			out.push_back((char)length);
+		}
+
+		static void writeSequence(std::vector<char> & out, const unsigned char * literals, size_t literalCount, size_t offset, size_t matchLength) {
+			const auto extraMatch = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+			out.push_back((char)((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(extraMatch, 15)));
+			if (literalCount >= 15)
+				writeLength(out, literalCount - 15);
+			out.insert(out.end(), literals, literals + literalCount);
+
+			if (matchLength == 0)
+				return;
+			out.push_back((char)(offset & 0xff));
+			out.push_back((char)(offset >> 8));
+			if (extraMatch >= 15)
+				writeLength(out, extraMatch - 15);
+		}
+
+		static std::vector<char> compress(const unsigned char * src, size_t size) {
+			std::vector<char> out;
+			out.reserve(size);
+
+			static constexpr size_t NONE = (size_t)-1;
+			std::vector<size_t> table(size_t(1) << HASH_BITS, NONE); // Last position of each hashed 4-byte sequence
+
+			size_t anchor = 0;
+			size_t i = 0;
+			while (i + MIN_MATCH <= size) {
+				std::uint32_t sequence;
+				memcpy(&sequence, src + i, sizeof(sequence));
+				const auto hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+
+				const auto candidate = table[hash];
+				table[hash] = i;
+				if (candidate == NONE || i - candidate > MAX_OFFSET || memcmp(src + candidate, src + i, MIN_MATCH) != 0) {
+					++i;
+					continue;
+				}
+
+				auto length = MIN_MATCH;
+				while (i + length < size && src[candidate + length] == src[i + length])
+					++length;
+
+				writeSequence(out, src + anchor, i - anchor, i - candidate, length);
+				i += length;
+				anchor = i;
+			}
+
+			writeSequence(out, src + anchor, size - anchor, 0, 0);
+			return out;
+		}
+
+		static bool readLength(const unsigned char * src, size_t size, size_t & i, size_t & length) {
+			unsigned char byte;
+			do {
+				if (i >= size)
+					return false;
+				byte = src[i++];
+				length += byte;
+			} while (byte == 255);
+			return true;
+		}
+
+		static bool decompress(const unsigned char * src, size_t size, unsigned char * dest, size_t destSize) {
+			size_t i = 0;
+			size_t o = 0;
+			while (i < size) {
+				const auto token = src[i++];
+
+				size_t literalCount = token >> 4;
+				if (literalCount == 15 && !readLength(src, size, i, literalCount))
+					return false;
+				if (literalCount > size - i || literalCount > destSize - o)
+					return false;
+				memcpy(dest + o, src + i, literalCount);
+				i += literalCount;
+				o += literalCount;
+
+				if (i == size) // Last sequence
+					break;
+
+				if (size - i < 2)
+					return false;
+				const size_t offset = src[i] | (src[i + 1] << 8);
+				i += 2;
+				if (offset == 0 || offset > o)
+					return false;
+
+				size_t length = token & 15;
+				if (length == 15 && !readLength(src, size, i, length))
+					return false;
+				length += MIN_MATCH;
+				if (length > destSize - o)
+					return false;
+
+				for (size_t j = 0; j < length; ++j) // Byte by byte, as the match may overlap what it writes
+					dest[o + j] = dest[o + j - offset];
+				o += length;
+			}
+			return o == destSize;
+		}
+	}
+
+	File & File::operator=(File && rhs) noexcept {
+		if (this == &rhs)
+			return *this;
+
+		close();
+		std::swap(_data, rhs._data);
+		std::swap(_size, rhs._size);
+		_file = std::move(rhs._file);
+		_buffer = std::move(rhs._buffer);
+		return *this;
+	}
+
+	bool File::open(const char * path) {
+		close();
+		const auto normalized = normalize(path);
+
+		{
+			std::shared_lock<std::shared_mutex> lock(g_packsMutex);
+			const Pack * pack;
+			if (const auto entry = find(normalized, &pack)) {
+				const auto blob = (const unsigned char *)pack->file.data() + entry->offset;
+				if (entry->storedSize == entry->size) {
+					_data = blob;
+					_size = entry->size;
+					return true;
+				}
+
+				_buffer.resize(entry->size);
+				if (!lz::decompress(blob, entry->storedSize, (unsigned char *)_buffer.data(), _buffer.size())) {
+					std::cerr << putils::termcolor::red << "[VFS] Corrupt entry " << normalized << '\n' << putils::termcolor::reset;
+					_buffer.clear();
+					return false;
+				}
+				_data = _buffer.data();
+				_size = _buffer.size();
+				return true;
+			}
+		}
+
+#ifndef KENGINE_VFS_NO_LOOSE_FILES
+		return openLoose(path);
+#else
+		return false;
+#endif
+	}
+
+	bool File::openLoose(const char * path) {
+		close();
+		if (!_file.open(path))
+			return false;
+		_data = _file.data();
+		_size = _file.size();
+		return true;
+	}
+
+	void File::close() {
+		_file.close();
+		_buffer.clear();
+		_buffer.shrink_to_fit();
+		_data = nullptr;
+		_size = 0;
+	}
+
+	void InputStream::Buffer::set(const File & file) {
+		const auto begin = (char *)file.data(); // Never written to: the streambuf is only read
+		setg(begin, begin, begin + file.size());
+	}
+
+	std::streambuf::pos_type InputStream::Buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+		if (!(which & std::ios_base::in))
+			return pos_type(off_type(-1));
+
+		off_type base = 0;
+		if (dir == std::ios_base::cur)
+			base = gptr() - eback();
+		else if (dir == std::ios_base::end)
+			base = egptr() - eback();
+
+		const auto pos = base + off;
+		if (pos < 0 || pos > egptr() - eback())
+			return pos_type(off_type(-1));
+		setg(eback(), eback() + pos, egptr());
+		return pos_type(pos);
+	}
+
+	std::streambuf::pos_type InputStream::Buffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+		return seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+
+	InputStream::InputStream(const char * path)
+		: std::istream(nullptr),
+		_file(path)
+	{
+		if (!_file.isOpen()) {
+			setstate(std::ios_base::failbit);
+			return;
+		}
+		_buffer.set(_file);
+		rdbuf(&_buffer);
+	}
+
+	bool mount(const char * pack) {
+		auto p = std::make_unique<Pack>();
+		const auto fail = [pack] {
+			std::cerr << putils::termcolor::red << "[VFS] Failed to mount " << pack << '\n' << putils::termcolor::reset;
+			return false;
+		};
+
+		if (!p->file.open(pack))
+			return fail();
+
+		const auto data = (const char *)p->file.data();
+		const auto size = p->file.size();
+
+		Header header;
+		if (size < sizeof(header))
+			return fail();
+		memcpy(&header, data, sizeof(header));
+		if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+			header.entriesOffset > size || header.entriesOffset % alignof(Entry) != 0 ||
+			header.entryCount > (size - header.entriesOffset) / sizeof(Entry))
+			return fail();
+
+		p->entries = (const Entry *)(data + header.entriesOffset);
+		p->entryCount = (size_t)header.entryCount;
+		p->paths = (const char *)(p->entries + p->entryCount);
+		const auto pathsSize = size - (size_t)(p->paths - data);
+
+		for (size_t i = 0; i < p->entryCount; ++i) {
+			const auto & entry = p->entries[i];
+			if (entry.offset > header.entriesOffset || entry.storedSize > header.entriesOffset - entry.offset ||
+				entry.pathOffset > pathsSize || entry.pathLength > pathsSize - entry.pathOffset ||
+				(i > 0 && p->entries[i - 1].pathHash > entry.pathHash))
+				return fail();
+		}
+
+		std::lock_guard<std::shared_mutex> lock(g_packsMutex);
+		g_packs.push_back(std::move(p));
+		return true;
+	}
+
+	bool exists(const char * path) {
+		{
+			std::shared_lock<std::shared_mutex> lock(g_packsMutex);
+			const Pack * pack;
+			if (find(normalize(path), &pack) != nullptr)
+				return true;
+		}
+
+#ifndef KENGINE_VFS_NO_LOOSE_FILES
+		std::error_code err;
+		return std::filesystem::is_regular_file(path, err);
+#else
+		return false;
+#endif
+	}
+
+	bool stamp(const char * path, std::uint64_t & stamp) {
+		{
+			std::shared_lock<std::shared_mutex> lock(g_packsMutex);
+			const Pack * pack;
+			if (const auto entry = find(normalize(path), &pack)) {
+				stamp = entry->contentHash;
+				return true;
+			}
+		}
+
+#ifndef KENGINE_VFS_NO_LOOSE_FILES
+		std::error_code err;
+		std::uint64_t sizeAndTime[2];
+		sizeAndTime[0] = (std::uint64_t)std::filesystem::file_size(path, err);
+		if (err)
+			return false;
+		sizeAndTime[1] = (std::uint64_t)std::filesystem::last_write_time(path, err).time_since_epoch().count();
+		if (err)
+			return false;
+		stamp = hashBytes(sizeAndTime, sizeof(sizeAndTime));
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool pack(const char * pack, const std::vector<std::string> & files, bool compress) {
+		std::ofstream out(pack, std::ofstream::binary | std::ofstream::trunc);
+		if (!out)
+			return false;
+
+		const auto pad = [&out] {
+			static const char zeros[ALIGNMENT] = {};
+			const auto pos = (size_t)out.tellp();
+			out.write(zeros, (ALIGNMENT - pos % ALIGNMENT) % ALIGNMENT);
+		};
+
+		Header header;
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.entryCount = files.size();
+		out.write((const char *)&header, sizeof(header)); // Rewritten once the entries' offset is known
+
+		std::vector<Entry> entries;
+		std::string paths;
+		for (const auto & f : files) {
+			const MappedFile file(f.c_str());
+			if (!file.isOpen()) {
+				std::cerr << putils::termcolor::red << "[VFS] Failed to read " << f << '\n' << putils::termcolor::reset;
+				return false;
+			}
+
+			const auto path = normalize(f.c_str());
+			Entry entry;
+			entry.pathHash = hashPath(path);
+			entry.size = file.size();
+			entry.pathOffset = paths.size();
+			entry.pathLength = path.size();
+			entry.contentHash = hashBytes(file.data(), file.size());
+			paths += path;
+
+			pad();
+			entry.offset = (std::uint64_t)out.tellp();
+
+			std::vector<char> compressed;
+			if (compress)
+				compressed = lz::compress((const unsigned char *)file.data(), file.size());
+			if (compress && compressed.size() < file.size() - file.size() / 8) { // Not worth decompressing for less
+				entry.storedSize = compressed.size();
+				out.write(compressed.data(), compressed.size());
+			}
+			else {
+				entry.storedSize = entry.size;
+				out.write((const char *)file.data(), file.size());
+			}
+
+			entries.push_back(entry);
+		}
+
+		std::stable_sort(entries.begin(), entries.end(), [](const Entry & lhs, const Entry & rhs) { return lhs.pathHash < rhs.pathHash; });
+
+		pad();
+		header.entriesOffset = (std::uint64_t)out.tellp();
+		out.write((const char *)entries.data(), entries.size() * sizeof(Entry));
+		out.write(paths.data(), paths.size());
+
+		out.seekp(0);
+		out.write((const char *)&header, sizeof(header));
+		return (bool)out;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+namespace kengine::VFS {
+	// Contents of a file, found in the mounted packs or on disk. Can be used in place of a read-only MappedFile
+	class File {
+	public:
+		File() = default;
+		explicit File(const char * path) { open(path); }
+
+		File(File && rhs) noexcept { *this = std::move(rhs); }
+		File & operator=(File && rhs) noexcept;
+
+		File(const File &) = delete;
+		File & operator=(const File &) = delete;
+
+		// Looks `path` up in the mounted packs, most recently mounted first, then on disk
+		// Returns false if it wasn't found, or its compressed data is corrupt
+		bool open(const char * path);
+		// Skips the mounted packs, e.g. to read a cooked file that was just written next to a packed source
+		bool openLoose(const char * path);
+		void close();
+
+		bool isOpen() const { return _data != nullptr; }
+		const void * data() const { return _data; }
+		size_t size() const { return _size; }
+
+	private:
+		const void * _data = nullptr; // Into `_file`, `_buffer` or a pack's mapping
+		size_t _size = 0;
+		MappedFile _file; // Loose file
+		std::vector<char> _buffer; // Decompressed pack entry
+	};
+
+	// std::istream over a File, for loaders that parse streams
+	class InputStream : public std::istream {
+	public:
+		explicit InputStream(const char * path);
+		bool isOpen() const { return _file.isOpen(); }
+
+	private:
+		struct Buffer : std::streambuf {
+			void set(const File & file);
+			pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+			pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+		};
+
+		File _file;
+		Buffer _buffer;
+	};
+
+	// Makes a pack's files available to File. Packs stay mapped until the program exits
+	// Returns false if `pack` couldn't be mapped or is corrupt
+	bool mount(const char * pack);
+
+	bool exists(const char * path);
+
+	// Fingerprint of `path`'s contents, obtained without reading them: its pack entry's content hash, or its size and modification time if it is loose
+	// Caches compare it to detect changed sources. Returns false if `path` wasn't found
+	bool stamp(const char * path, std::uint64_t & stamp);
+
+	// Writes a pack holding `files`, each stored under the path it is read from here. Blobs that compress well are compressed, unless `compress` is false
+	bool pack(const char * pack, const std::vector<std::string> & files, bool compress = true);
+}
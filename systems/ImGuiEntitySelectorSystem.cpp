@@ -6,8 +6,7 @@
 #include "data/SelectedComponent.hpp"
 
 #include "helpers/TypeHelper.hpp"
-#include "helpers/SortHelper.hpp"
-#include "meta/Has.hpp"
+#include "helpers/MetaTableHelper.hpp"
 #include "meta/MatchString.hpp"
 
 #include "helpers/ImGuiHelper.hpp"
@@ -65,12 +64,13 @@ namespace kengine {
 				displayText += "ID";
 			}
 			else {
-				const auto types = SortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
-					meta::Has, meta::MatchString
-				>(em);
+				for (size_t id = 0; id < e.componentMask.size(); ++id) {
+					if (!e.componentMask.test(id))
+						continue;
 
-				for (const auto & [_, type, has, matchFunc] : types) {
-					if (!has->call(e) || !matchFunc->call(e, str))
+					const auto matchFunc = MetaTableHelper::get<meta::MatchString>(em, id);
+					const auto type = MetaTableHelper::get<NameComponent>(em, id);
+					if (matchFunc == nullptr || type == nullptr || !matchFunc->call(e, str))
 						continue;
 
 					if (displayText.size() + type->name.size() + 2 < decltype(displayText)::max_size) {
@@ -31,6 +31,7 @@ namespace kengine {
 			applyRotation(transform.pitch, physics.pitch);
 			applyRotation(transform.yaw, physics.yaw);
 			applyRotation(transform.roll, physics.roll);
+			transform.markDirty();
 		}
 	}
 }
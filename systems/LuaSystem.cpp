@@ -1,9 +1,12 @@
+#include <iostream>
+
 #include "LuaSystem.hpp"
 #include "ScriptSystem.hpp"
 #include "data/LuaComponent.hpp"
 #include "functions/Execute.hpp"
 
 #include "meta/type.hpp"
+#include "helpers/VFS.hpp"
 
 namespace kengine {
 	// declarations
@@ -34,8 +37,14 @@ namespace kengine {
 		state["deltaTime"] = deltaTime;
 		for (auto & [e, comp] : em.getEntities<LuaComponent>()) {
 			state["self"] = &e;
-			for (const auto & s : comp.scripts)
-				state.script_file(s.c_str());
+			for (const auto & s : comp.scripts) {
+				const VFS::File file(s.c_str());
+				if (!file.isOpen()) {
+					std::cerr << "[Lua] Failed to read " << s.c_str() << '\n';
+					continue;
+				}
+				state.script(std::string_view((const char *)file.data(), file.size()), std::string("@") + s.c_str()); // '@' makes errors report the file name
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
+#include <iostream>
+
 #include "PySystem.hpp"
 #include "ScriptSystem.hpp"
 #include "data/PyComponent.hpp"
 #include "functions/Execute.hpp"
 
+#include "helpers/VFS.hpp"
+
 namespace kengine {
 	// declarations
 	static void execute(EntityManager & em, py::module & module, float deltaTime);
@@ -32,8 +36,14 @@ namespace kengine {
 		module.attr("deltaTime") = deltaTime;
 		for (auto & [e, comp] : em.getEntities<PyComponent>()) {
 			module.attr("self") = &e;
-			for (const auto & s : comp.scripts)
-				py::eval_file(s.c_str(), py::globals());
+			for (const auto & s : comp.scripts) {
+				const VFS::File file(s.c_str());
+				if (!file.isOpen()) {
+					std::cerr << "[Python] Failed to read " << s.c_str() << '\n';
+					continue;
+				}
+				py::exec(py::str((const char *)file.data(), file.size()), py::globals());
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -5,66 +5,119 @@
 #include "data/TextureModelComponent.hpp"
 #include "data/OpenGLModelComponent.hpp"
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
+#include "systems/opengl/LevelOfDetail.hpp"
 
 #include "opengl/Program.hpp"
 
 namespace kengine {
 	namespace AssImpHelper {
-		void drawModel(EntityManager & em, const GraphicsComponent & graphics, const TransformComponent & transform, const SkeletonComponent & skeleton, bool useTextures, const Uniforms & uniforms) {
-			if (graphics.model == Entity::INVALID_ID)
+		const glm::mat4 * getDefaultBones() {
+			static glm::mat4 defaultMats[KENGINE_SKELETON_MAX_BONES];
+			static bool first = true;
+			if (first) {
+				for (unsigned int i = 0; i < KENGINE_SKELETON_MAX_BONES; ++i)
+					defaultMats[i] = glm::mat4(1.f);
+				first = false;
+			}
+			return defaultMats;
+		}
+
+		AssImpVertexFormat getVertexFormat(const Entity & modelInfoEntity) {
+			if (!modelInfoEntity.has<AssImpVertexFormatComponent>())
+				return AssImpVertexFormat::Full;
+			return modelInfoEntity.get<AssImpVertexFormatComponent>().format;
+		}
+
+		GLuint getDiffuseTexture(EntityManager & em, const AssImpTexturesModelComponent::MeshTextures & meshTextures) {
+			if (meshTextures.diffuse.empty())
+				return (GLuint)-1;
+
+			const auto & textureEntity = em.getEntity(meshTextures.diffuse[0]);
+			if (!textureEntity.has<TextureModelComponent>())
+				return (GLuint)-1;
+			return textureEntity.get<TextureModelComponent>().texture;
+		}
+
+		static void setDefaultBones(const Uniforms & uniforms) {
+			glUniformMatrix4fv(uniforms.bones, KENGINE_SKELETON_MAX_BONES, GL_FALSE, glm::value_ptr(getDefaultBones()[0]));
+		}
+
+		static void setMeshTextures(EntityManager & em, const AssImpTexturesModelComponent::MeshTextures & meshTextures, const Uniforms & uniforms) {
+			const auto texture = getDiffuseTexture(em, meshTextures);
+			if (texture != (GLuint)-1) {
+				glActiveTexture((GLenum)(GL_TEXTURE0 + uniforms.diffuseTextureID));
+				glBindTexture(GL_TEXTURE_2D, texture);
+			}
+			else // Textures that aren't resident yet fall back to the material's color
+				uniforms.diffuseColor = meshTextures.diffuseColor;
+
+			uniforms.hasTexture = texture != (GLuint)-1;
+
+			// glActiveTexture(GL_TEXTURE0 + locations.specularTextureID);
+			// if (!meshTextures.specular.empty())
+			// 	glBindTexture(GL_TEXTURE_2D, meshTextures.specular[0]);
+			// else if (!meshTextures.diffuse.empty())
+			// 	glBindTexture(GL_TEXTURE_2D, meshTextures.diffuse[0]);
+			// else
+			// 	putils::gl::setUniform(locations.specularColor, meshTextures.specularColor);
+		}
+
+		void drawModel(EntityManager & em, const RenderSnapshot::Drawable & drawable, bool useTextures, const Uniforms & uniforms, size_t lod) {
+			if (drawable.model == Entity::INVALID_ID)
 				return;
 
-			const auto & modelInfoEntity = em.getEntity(graphics.model);
+			const auto & modelInfoEntity = em.getEntity(drawable.model);
 			if (!modelInfoEntity.has<ModelComponent>() || !modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<AssImpTexturesModelComponent>())
 				return;
 
 			const auto & openGL = modelInfoEntity.get<OpenGLModelComponent>();
-			const auto & modelInfo = modelInfoEntity.get<ModelComponent>();
 			const auto & textures = modelInfoEntity.get<AssImpTexturesModelComponent>();
+			const auto & snapshot = RenderSnapshot::get();
 
-			uniforms.model = ShaderHelper::getModelMatrix(modelInfo, transform);
-
-			if (skeleton.meshes.empty()) {
-				static glm::mat4 defaultMats[KENGINE_SKELETON_MAX_BONES];
-				static bool first = true;
-				if (first) {
-					for (unsigned int i = 0; i < KENGINE_SKELETON_MAX_BONES; ++i)
-						defaultMats[i] = glm::mat4(1.f);
-					first = false;
-				}
-				glUniformMatrix4fv(uniforms.bones, KENGINE_SKELETON_MAX_BONES, GL_FALSE, glm::value_ptr(defaultMats[0]));
-			}
+			uniforms.instanced = false;
+			uniforms.model = drawable.world;
+			uniforms.vertexFormat = (int)getVertexFormat(modelInfoEntity);
+
+			if (drawable.boneMeshes == 0)
+				setDefaultBones(uniforms);
 
 			for (unsigned int i = 0; i < openGL.meshes.size(); ++i) {
-				if (!skeleton.meshes.empty())
-					glUniformMatrix4fv(uniforms.bones, KENGINE_SKELETON_MAX_BONES, GL_FALSE, glm::value_ptr(skeleton.meshes[i].boneMatsBoneSpace[0]));
-
-				if (useTextures) {
-					const auto & meshTextures = textures.meshes[i];
-					if (!meshTextures.diffuse.empty()) {
-						glActiveTexture((GLenum)(GL_TEXTURE0 + uniforms.diffuseTextureID));
-						const auto & modelEntity = em.getEntity(meshTextures.diffuse[0]);
-						glBindTexture(GL_TEXTURE_2D, modelEntity.get<TextureModelComponent>().texture);
-					}
-					else
-						uniforms.diffuseColor = meshTextures.diffuseColor;
-
-					uniforms.hasTexture = !meshTextures.diffuse.empty();
-
-					// glActiveTexture(GL_TEXTURE0 + locations.specularTextureID);
-					// if (!meshTextures.specular.empty())
-					// 	glBindTexture(GL_TEXTURE_2D, meshTextures.specular[0]);
-					// else if (!meshTextures.diffuse.empty())
-					// 	glBindTexture(GL_TEXTURE_2D, meshTextures.diffuse[0]);
-					// else
-					// 	putils::gl::setUniform(locations.specularColor, meshTextures.specularColor);
-				}
+				const auto bones = snapshot.getBones(drawable, i);
+				if (bones != nullptr)
+					glUniformMatrix4fv(uniforms.bones, KENGINE_SKELETON_MAX_BONES, GL_FALSE, glm::value_ptr(*bones));
+
+				if (useTextures)
+					setMeshTextures(em, textures.meshes[i], uniforms);
 
 				const auto & meshInfo = openGL.meshes[i];
 				glBindVertexArray(meshInfo.vertexArrayObject);
 				glBindBuffer(GL_ARRAY_BUFFER, meshInfo.vertexBuffer);
-				glDrawElements(GL_TRIANGLES, (GLsizei)meshInfo.nbIndices, meshInfo.indexType, nullptr);
+				const auto range = LevelOfDetail::getRange(meshInfo, lod);
+				glDrawElements(GL_TRIANGLES, range.count, meshInfo.indexType, range.offset);
+			}
+		}
+
+		void drawModelInstanced(EntityManager & em, Entity::ID model, const std::vector<Instancing::InstanceData> & instances, bool useTextures, const Uniforms & uniforms, size_t lod) {
+			const auto & modelInfoEntity = em.getEntity(model);
+			if (!modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<AssImpTexturesModelComponent>())
+				return;
+
+			const auto & openGL = modelInfoEntity.get<OpenGLModelComponent>();
+			const auto & textures = modelInfoEntity.get<AssImpTexturesModelComponent>();
+
+			uniforms.instanced = true;
+			uniforms.vertexFormat = (int)getVertexFormat(modelInfoEntity);
+			setDefaultBones(uniforms);
+
+			Instancing::upload(instances);
+			for (unsigned int i = 0; i < openGL.meshes.size(); ++i) {
+				if (useTextures)
+					setMeshTextures(em, textures.meshes[i], uniforms);
+				Instancing::drawMesh(openGL.meshes[i], lod);
 			}
+
+			uniforms.instanced = false;
 		}
 	}
-}
\ No newline at end of file
+}
@@ -18,11 +18,25 @@
 #include "data/TransformComponent.hpp"
 #include "data/SkeletonComponent.hpp"
 
+#include "systems/opengl/Instancing.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
+
 namespace kengine {
 	class EntityManager;
 
 	struct AssImpObjectComponent {};
 
+	// Layout of a model's vertices, passed to the AssImp shaders' `vertexFormat` uniform
+	enum class AssImpVertexFormat : int {
+		Full = 0, // float position, normal, UVs, bone weights and IDs (80 bytes)
+		Static = 1, // float position, octahedral normal and half-float UVs (20 bytes)
+		Skinned = 2 // Static, plus unorm8 bone weights and uint8 bone IDs (28 bytes)
+	};
+
+	struct AssImpVertexFormatComponent {
+		AssImpVertexFormat format = AssImpVertexFormat::Full;
+	};
+
 	struct AssImpTexturesModelComponent {
 		struct MeshTextures {
 			std::vector<Entity::ID> diffuse; // id of entities with TextureModelComponent
@@ -39,6 +53,8 @@ namespace kengine {
 		struct Uniforms {
 			putils::gl::Uniform<glm::mat4> model;
 			GLint bones;
+			putils::gl::Uniform<bool> instanced;
+			putils::gl::Uniform<int> vertexFormat;
 
 			putils::gl::Uniform<bool> hasTexture;
 			size_t diffuseTextureID;
@@ -48,6 +64,17 @@ namespace kengine {
 			putils::gl::Uniform<putils::NormalizedColor> specularColor;
 		};
 
-		void drawModel(EntityManager & em, const GraphicsComponent & model, const TransformComponent & transform, const SkeletonComponent & skeleton, bool useTextures, const Uniforms & uniforms);
+		// KENGINE_SKELETON_MAX_BONES identity matrices, for models drawn without a pose
+		const glm::mat4 * getDefaultBones();
+
+		AssImpVertexFormat getVertexFormat(const Entity & modelInfoEntity);
+
+		// Texture the mesh's diffuse should be sampled from, or (GLuint)-1 if it has none, or if it isn't resident (still uploading, or evicted)
+		GLuint getDiffuseTexture(EntityManager & em, const AssImpTexturesModelComponent::MeshTextures & meshTextures);
+
+		// `lod` is the level of detail to draw, see LevelOfDetail::getRange
+		void drawModel(EntityManager & em, const RenderSnapshot::Drawable & drawable, bool useTextures, const Uniforms & uniforms, size_t lod = 0);
+		// Draws all `instances` of `model` with one call per mesh. Only valid for Entities whose SkeletonComponent held no pose
+		void drawModelInstanced(EntityManager & em, Entity::ID model, const std::vector<Instancing::InstanceData> & instances, bool useTextures, const Uniforms & uniforms, size_t lod = 0);
 	}
 }
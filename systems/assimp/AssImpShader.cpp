@@ -1,4 +1,9 @@
+#include <cfloat>
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
 #include "AssImpShader.hpp"
+#include "EntityManager.hpp"
 
 #include "data/TransformComponent.hpp"
 #include "data/ModelComponent.hpp"
@@ -8,6 +13,9 @@
 #include "systems/opengl/shaders/ApplyTransparencySrc.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Culling.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
+#include "systems/opengl/LevelOfDetail.hpp"
 
 #include "AssImpHelper.hpp"
 
@@ -35,23 +43,133 @@ namespace kengine {
 		_view = params.view;
 		_proj = params.proj;
 
-		for (const auto &[e, textured, graphics, transform, skeleton] : _em.getEntities<AssImpObjectComponent, GraphicsComponent, TransformComponent, SkeletonComponent>()) {
-			if (graphics.model == Entity::INVALID_ID)
-				return;
+		_merged.clear();
+		_instances.clear();
+
+		// Preparation only reads the snapshot and model Entities, so it is split across the thread pool. GL calls stay on this thread
+		const auto & drawables = RenderSnapshot::get().drawables;
+		const auto tasks = RenderSnapshot::getTaskCount(drawables.size());
+		if (_taskBuffers.size() < tasks)
+			_taskBuffers.resize(tasks);
+
+		RenderSnapshot::runTasks(drawables.size(), [&](size_t task, size_t begin, size_t end) {
+			auto & buffer = _taskBuffers[task];
+			buffer.clear();
+			prepare(buffer, drawables.data() + begin, drawables.data() + end, params.camPos);
+		});
+
+		for (size_t task = 0; task < tasks; ++task) { // Merged in task order, so the result doesn't depend on scheduling
+			const auto & buffer = _taskBuffers[task];
+			_merged.drawList.append(buffer.drawList, _merged.records.size());
+			_merged.records.insert(_merged.records.end(), buffer.records.begin(), buffer.records.end());
+			_merged.batcher.merge(buffer.batcher);
+		}
+
+		_merged.batcher.forEach([&](Entity::ID model, size_t lod, const auto & instances) {
+			float depth = FLT_MAX;
+			for (const auto & instance : instances)
+				depth = std::min(depth, glm::distance(params.camPos, glm::vec3(instance.model[3])));
+
+			DrawRecord record;
+			record.instanced = true;
+			pushModel(_merged, _em.getEntity(model), record, nullptr, (std::uint32_t)_instances.size(), (std::uint32_t)instances.size(), depth, lod);
+			_instances.insert(_instances.end(), instances.begin(), instances.end());
+		});
+
+		if (_merged.drawList.empty())
+			return;
+
+		if (!_instances.empty())
+			Instancing::upload(_instances);
+
+		const glm::mat4 * currentBones = nullptr;
+		_merged.drawList.submit((GLenum)(GL_TEXTURE0 + _diffuseTextureID), [&](const RenderQueue::DrawItem & item) {
+			const auto & record = _merged.records[item.userData];
+
+			if (record.bones != currentBones) {
+				glUniformMatrix4fv(_bones, KENGINE_SKELETON_MAX_BONES, GL_FALSE, glm::value_ptr(*record.bones));
+				currentBones = record.bones;
+			}
+
+			_instanced = record.instanced;
+			_vertexFormat = record.vertexFormat;
+			if (!record.instanced) {
+				_model = record.model;
+				_entityID = record.entityID;
+				_color = record.color;
+			}
+
+			_hasTexture = record.hasTexture;
+			if (!record.hasTexture)
+				_diffuseColor = record.diffuseColor;
+		});
+	}
+
+	void AssImpShader::prepare(DrawBuffer & buffer, const RenderSnapshot::Drawable * begin, const RenderSnapshot::Drawable * end, const glm::vec3 & camPos) {
+		for (auto it = begin; it != end; ++it) {
+			const auto & drawable = *it;
+			if (!drawable.entity.has<AssImpObjectComponent>() || !drawable.entity.has<SkeletonComponent>())
+				continue;
+			if (drawable.model == Entity::INVALID_ID)
+				continue;
+			if (!Culling::isVisible(drawable.entity.id))
+				continue;
+
+			const auto lod = LevelOfDetail::get(drawable.entity.id);
+			if (drawable.boneMeshes == 0) { // No pose of its own, drawn along with the other instances of its model and level of detail
+				buffer.batcher.add(_em, drawable, lod);
+				continue;
+			}
+
+			const auto & modelInfoEntity = _em.getEntity(drawable.model);
+			if (!modelInfoEntity.has<ModelComponent>())
+				continue;
+
+			DrawRecord record;
+			record.model = drawable.world;
+			record.color = drawable.color;
+			record.entityID = (float)drawable.entity.id;
+			record.instanced = false;
+			pushModel(buffer, modelInfoEntity, record, &drawable, 0, 0, glm::distance(camPos, glm::vec3(record.model[3])), lod);
+		}
+	}
+
+	void AssImpShader::pushModel(DrawBuffer & buffer, const Entity & modelInfoEntity, DrawRecord record, const RenderSnapshot::Drawable * posed, std::uint32_t firstInstance, std::uint32_t instanceCount, float depth, size_t lod) {
+		if (!modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<AssImpTexturesModelComponent>())
+			return;
+
+		const auto & openGL = modelInfoEntity.get<OpenGLModelComponent>();
+		const auto & textures = modelInfoEntity.get<AssImpTexturesModelComponent>();
+		record.vertexFormat = (int)AssImpHelper::getVertexFormat(modelInfoEntity);
+
+		for (size_t i = 0; i < openGL.meshes.size(); ++i) {
+			const auto & meshTextures = textures.meshes[i];
+
+			// Textures that aren't resident yet (still uploading, or evicted) fall back to the material's color, and bind nothing
+			auto texture = AssImpHelper::getDiffuseTexture(_em, meshTextures);
+			record.hasTexture = texture != (GLuint)-1;
+			if (!record.hasTexture) {
+				texture = 0;
+				record.diffuseColor = meshTextures.diffuseColor;
+			}
+
+			record.bones = posed != nullptr ? RenderSnapshot::get().getBones(*posed, i) : nullptr;
+			if (record.bones == nullptr)
+				record.bones = AssImpHelper::getDefaultBones();
 
-			_entityID = (float)e.id;
-			_color = graphics.color;
+			const auto & mesh = openGL.meshes[i];
 
-			AssImpHelper::Uniforms uniforms;
-			uniforms.model = _model;
-			uniforms.bones = _bones;
-			uniforms.hasTexture = _hasTexture;
-			uniforms.diffuseTextureID = _diffuseTextureID;
-			uniforms.specularTextureID = _specularTextureID;
-			uniforms.specularColor = _specularColor;
-			uniforms.diffuseColor = _diffuseColor;
+			RenderQueue::DrawItem item;
+			item.key = RenderQueue::makeKey(texture, mesh.vertexArrayObject, depth);
+			item.mesh = &mesh;
+			item.texture = texture;
+			item.firstInstance = firstInstance;
+			item.instanceCount = instanceCount;
+			item.lod = lod;
+			item.userData = buffer.records.size();
 
-			AssImpHelper::drawModel(_em, graphics, transform, skeleton, true, uniforms);
+			buffer.records.push_back(record);
+			buffer.drawList.push(item);
 		}
 	}
-}
\ No newline at end of file
+}
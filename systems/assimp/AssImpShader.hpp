@@ -1,6 +1,11 @@
 #pragma once
 
+#include <vector>
+#include <cstdint>
+
 #include "opengl/Program.hpp"
+#include "systems/opengl/Instancing.hpp"
+#include "systems/opengl/RenderQueue.hpp"
 
 namespace kengine {
 	class EntityManager;
@@ -19,6 +24,8 @@ namespace kengine {
 		putils::gl::Uniform<glm::mat4> _model;
 		putils::gl::Uniform<glm::mat4> _view;
 		putils::gl::Uniform<glm::mat4> _proj;
+		putils::gl::Uniform<bool> _instanced;
+		putils::gl::Uniform<int> _vertexFormat;
 
 		GLint _bones;
 
@@ -35,6 +42,8 @@ namespace kengine {
 			putils_reflection_attribute_private(&AssImpShader::_model),
 			putils_reflection_attribute_private(&AssImpShader::_view),
 			putils_reflection_attribute_private(&AssImpShader::_proj),
+			putils_reflection_attribute_private(&AssImpShader::_instanced),
+			putils_reflection_attribute_private(&AssImpShader::_vertexFormat),
 
 			putils_reflection_attribute_private(&AssImpShader::_bones),
 
@@ -48,9 +57,40 @@ namespace kengine {
 			putils_reflection_attribute_private(&AssImpShader::_color)
 		);
 
+	private:
+		// Per-mesh uniforms, set by the RenderQueue before each draw
+		struct DrawRecord {
+			glm::mat4 model;
+			const glm::mat4 * bones = nullptr;
+			putils::NormalizedColor color;
+			putils::NormalizedColor diffuseColor;
+			float entityID = 0.f;
+			int vertexFormat = 0;
+			bool hasTexture = false;
+			bool instanced = false;
+		};
+
+		// Draws prepared by a single task, merged on the GL thread
+		struct DrawBuffer {
+			Instancing::Batcher batcher;
+			RenderQueue::DrawList drawList;
+			std::vector<DrawRecord> records;
+
+			void clear() { batcher.clear(); drawList.clear(); records.clear(); }
+		};
+
+		// Fills `buffer` with the draws for `drawables`
+		void prepare(DrawBuffer & buffer, const RenderSnapshot::Drawable * begin, const RenderSnapshot::Drawable * end, const glm::vec3 & camPos);
+		// Pushes a draw item for each of the model's meshes. `instanceCount` is 0 for a single Entity described by `record`, whose pose is read from `posed`
+		void pushModel(DrawBuffer & buffer, const Entity & modelInfoEntity, DrawRecord record, const RenderSnapshot::Drawable * posed, std::uint32_t firstInstance, std::uint32_t instanceCount, float depth, size_t lod);
+
 	private:
 		EntityManager & _em;
 		size_t _diffuseTextureID;
 		size_t _specularTextureID;
+
+		std::vector<DrawBuffer> _taskBuffers; // One per task, kept across frames to avoid reallocations
+		DrawBuffer _merged;
+		std::vector<Instancing::InstanceData> _instances;
 	};
 }
\ No newline at end of file
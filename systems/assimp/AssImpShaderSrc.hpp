@@ -9,14 +9,26 @@ namespace kengine {
 #version 330
 
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normal;
+layout (location = 1) in vec3 normal; // Octahedral-encoded in .xy for compact formats
 layout (location = 2) in vec2 texCoords;
-layout (location = 3) in vec4 boneWeights;
+layout (location = 3) in vec4 boneWeights; // Not bound for FORMAT_STATIC
 layout (location = 4) in ivec4 boneIDs;
+layout (location = 5) in mat4 instanceModel;
+layout (location = 9) in vec4 instanceColor;
+layout (location = 10) in float instanceEntityID;
 
 uniform mat4 proj;
 uniform mat4 view;
 uniform mat4 model;
+uniform int instanced;
+uniform int vertexFormat;
+
+// AssImpVertexFormat
+const int FORMAT_FULL = 0;
+const int FORMAT_STATIC = 1;
+
+uniform float entityID;
+uniform vec4 color;
 
 const int MAX_BONES = )" putils_macro_as_string(KENGINE_SKELETON_MAX_BONES) R"(;
 uniform mat4 bones[MAX_BONES];
@@ -24,15 +36,41 @@ uniform mat4 bones[MAX_BONES];
 out vec4 WorldPosition;
 out vec3 Normal;
 out vec2 TexCoords;
+out vec4 EntityColor;
+flat out float EntityID;
+
+vec3 decodeNormal() {
+	if (vertexFormat == FORMAT_FULL)
+		return normal;
+
+	vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
 
 void main() {
-	mat4 boneMatrix = bones[boneIDs[0]] * boneWeights[0];
-	boneMatrix += bones[boneIDs[1]] * boneWeights[1];
-	boneMatrix += bones[boneIDs[2]] * boneWeights[2];
-	boneMatrix += bones[boneIDs[3]] * boneWeights[3];
+	mat4 boneMatrix = mat4(1.0);
+	if (vertexFormat != FORMAT_STATIC) {
+		boneMatrix = bones[boneIDs[0]] * boneWeights[0];
+		boneMatrix += bones[boneIDs[1]] * boneWeights[1];
+		boneMatrix += bones[boneIDs[2]] * boneWeights[2];
+		boneMatrix += bones[boneIDs[3]] * boneWeights[3];
+	}
 
-	WorldPosition = model * boneMatrix * vec4(position, 1.0);
-	Normal = (boneMatrix * vec4(normal, 0.0)).xyz;
+	if (instanced != 0) {
+		WorldPosition = instanceModel * boneMatrix * vec4(position, 1.0);
+		EntityColor = instanceColor;
+		EntityID = instanceEntityID;
+	}
+	else {
+		WorldPosition = model * boneMatrix * vec4(position, 1.0);
+		EntityColor = color;
+		EntityID = entityID;
+	}
+
+	Normal = (boneMatrix * vec4(decodeNormal(), 0.0)).xyz;
 	TexCoords = texCoords;
 
 	gl_Position = proj * view * WorldPosition;
@@ -45,6 +83,8 @@ void main() {
 in vec4 WorldPosition;
 in vec3 Normal;
 in vec2 TexCoords;
+in vec4 EntityColor;
+flat in float EntityID;
 
 layout (location = 0) out vec4 gposition;
 layout (location = 1) out vec3 gnormal;
@@ -57,9 +97,6 @@ uniform sampler2D texture_specular;
 uniform vec4 diffuseColor;
 uniform vec4 specularColor;
 
-uniform float entityID;
-uniform vec4 color;
-
 void applyTransparency(float a);
 
 void main() {
@@ -69,13 +106,13 @@ void main() {
 	else
 		totalColor = texture(texture_diffuse, TexCoords);
 
-	totalColor *= color;
+	totalColor *= EntityColor;
 
 	applyTransparency(totalColor.a);
 
 	gposition = WorldPosition;
 	gnormal = Normal;
-	gentityID = entityID;
+	gentityID = EntityID;
 	gcolor = vec4(totalColor.xyz, 0.0);
 }
 	)";
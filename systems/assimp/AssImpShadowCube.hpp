@@ -2,6 +2,7 @@
 
 #include "putils/opengl/Program.hpp"
 #include "systems/opengl/shaders/ShadowMapShader.hpp"
+#include "systems/opengl/Instancing.hpp"
 
 namespace kengine {
 	class EntityManager;
@@ -22,12 +23,15 @@ namespace kengine {
 
 	private:
 		EntityManager & _em;
+		Instancing::Batcher _batcher;
 
 	public:
 		GLint _bones;
+		putils::gl::Uniform<int> _vertexFormat;
 
 		putils_reflection_attributes(
-			putils_reflection_attribute_private(&AssImpShadowCube::_bones)
+			putils_reflection_attribute_private(&AssImpShadowCube::_bones),
+			putils_reflection_attribute_private(&AssImpShadowCube::_vertexFormat)
 		);
 
 		putils_reflection_parents(
@@ -7,6 +7,9 @@
 
 #include "helpers/LightHelper.hpp"
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Culling.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
+#include "systems/opengl/LevelOfDetail.hpp"
 
 #include "AssImpShaderSrc.hpp"
 #include "AssImpHelper.hpp"
@@ -28,8 +31,26 @@ namespace kengine {
 		AssImpHelper::Uniforms uniforms;
 		uniforms.model = _model;
 		uniforms.bones = _bones;
-
-		for (const auto & [e, textured, graphics, transform, skeleton] : _em.getEntities<AssImpObjectComponent, GraphicsComponent, TransformComponent, SkeletonComponent>())
-			AssImpHelper::drawModel(_em, graphics, transform, skeleton, false, uniforms);
+		uniforms.instanced = _instanced;
+		uniforms.vertexFormat = _vertexFormat;
+
+		const auto & snapshot = RenderSnapshot::get();
+
+		_batcher.clear();
+		for (const auto id : Culling::getCasters(lightSpaceMatrix)) {
+			const auto drawable = snapshot.find(id);
+			if (drawable == nullptr || !drawable->entity.has<AssImpObjectComponent>() || !drawable->entity.has<SkeletonComponent>())
+				continue;
+
+			const auto lod = LevelOfDetail::getShadow(id);
+			if (drawable->boneMeshes == 0)
+				_batcher.add(_em, *drawable, lod);
+			else
+				AssImpHelper::drawModel(_em, *drawable, false, uniforms, lod);
+		}
+
+		_batcher.forEach([&](Entity::ID model, size_t lod, const auto & instances) {
+			AssImpHelper::drawModelInstanced(_em, model, instances, false, uniforms, lod);
+		});
 	}
 }
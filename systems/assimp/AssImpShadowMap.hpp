@@ -1,6 +1,7 @@
 #pragma once
 
 #include "systems/opengl/shaders/ShadowMapShader.hpp"
+#include "systems/opengl/Instancing.hpp"
 
 namespace kengine {
 	class EntityManager;
@@ -17,11 +18,14 @@ namespace kengine {
 
 	private:
 		EntityManager & _em;
+		Instancing::Batcher _batcher;
 
 	public:
 		putils::gl::Uniform<glm::mat4> _proj;
 		putils::gl::Uniform<glm::mat4> _view;
 		putils::gl::Uniform<glm::mat4> _model;
+		putils::gl::Uniform<bool> _instanced;
+		putils::gl::Uniform<int> _vertexFormat;
 
 		GLint _bones;
 
@@ -29,6 +33,8 @@ namespace kengine {
 			putils_reflection_attribute_private(&AssImpShadowMap::_proj),
 			putils_reflection_attribute_private(&AssImpShadowMap::_view),
 			putils_reflection_attribute_private(&AssImpShadowMap::_model),
+			putils_reflection_attribute_private(&AssImpShadowMap::_instanced),
+			putils_reflection_attribute_private(&AssImpShadowMap::_vertexFormat),
 
 			putils_reflection_attribute_private(&AssImpShadowMap::_bones)
 		);
@@ -1,9 +1,26 @@
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
 #include "AssimpSystem.hpp"
 #include "EntityManager.hpp"
+#include "ThreadPool.hpp"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+#include <glm/gtc/packing.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -20,6 +37,7 @@
 #include "data/TextureDataComponent.hpp"
 #include "data/TextureModelComponent.hpp"
 #include "data/ModelComponent.hpp"
+#include "data/ModelLoadingComponent.hpp"
 
 #include "data/AnimationComponent.hpp"
 #include "data/SkeletonComponent.hpp"
@@ -30,8 +48,40 @@
 
 #include "functions/Execute.hpp"
 #include "functions/OnEntityCreated.hpp"
+#include "functions/OnEntityRemoved.hpp"
 
 #include "AssImpHelper.hpp"
+#include "helpers/AssetHelper.hpp"
+#include "helpers/MappedFile.hpp"
+#include "helpers/MeshOptimizer.hpp"
+#include "helpers/VFS.hpp"
+#include "systems/opengl/TextureCache.hpp"
+
+#ifndef KENGINE_ASSIMP_LOADING_THREADS
+# define KENGINE_ASSIMP_LOADING_THREADS 2
+#endif
+
+#ifndef KENGINE_ASSIMP_CACHE_EXTENSION
+# define KENGINE_ASSIMP_CACHE_EXTENSION "kmdl"
+#endif
+
+// Define KENGINE_ASSIMP_FULL_VERTICES to cook models with float normals, UVs and bone weights instead of the compact formats
+
+#ifndef KENGINE_ASSIMP_MERGE_MESH_VERTICES
+# define KENGINE_ASSIMP_MERGE_MESH_VERTICES 1024 // Unskinned meshes with fewer vertices are merged with others sharing their material. 0 disables merging
+#endif
+
+#ifndef KENGINE_ASSIMP_OVERDRAW_THRESHOLD
+# define KENGINE_ASSIMP_OVERDRAW_THRESHOLD 1.05f // Vertex cache misses traded for less overdraw, see MeshOptimizer::optimizeOverdraw
+#endif
+
+#ifndef KENGINE_ASSIMP_LOD_LEVELS
+# define KENGINE_ASSIMP_LOD_LEVELS 4 // Levels of detail cooked per mesh, including the full one. 1 disables simplification
+#endif
+
+#ifndef KENGINE_ASSIMP_LOD_MIN_TRIANGLES
+# define KENGINE_ASSIMP_LOD_MIN_TRIANGLES 64 // Meshes aren't simplified below this
+#endif
 
 namespace kengine {
 	static EntityManager * g_em = nullptr;
@@ -39,6 +89,7 @@ namespace kengine {
 	// declarations
 	static void execute(float deltaTime);
 	static void onEntityCreated(Entity & e);
+	static void onEntityRemoved(Entity & e);
 	//
 	EntityCreator * AssImpSystem(EntityManager & em) {
 		g_em = &em;
@@ -60,6 +111,7 @@ namespace kengine {
 		return [](Entity & e) {
 			e += functions::Execute{ execute };
 			e += functions::OnEntityCreated{ onEntityCreated };
+			e += functions::OnEntityRemoved{ onEntityRemoved };
 		};
 	}
 
@@ -77,6 +129,7 @@ namespace kengine {
 	static Assimp::Importer g_importer;
 
 	namespace AssImp {
+		static constexpr unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals /*| aiProcess_OptimizeMeshes*/ | aiProcess_JoinIdenticalVertices;
 
 		struct AssImpModelComponent {
 			struct Mesh {
@@ -97,36 +150,167 @@ namespace kengine {
 					);
 				};
 
-				std::vector<Vertex> vertices;
-				std::vector<unsigned int> indices;
+				// Compact formats, see AssImpVertexFormat
+				struct StaticVertex {
+					float position[3];
+					std::int16_t normal[2]; // Octahedral, snorm
+					std::uint16_t texCoords[2]; // Half-float
+				};
+
+				struct SkinnedVertex {
+					float position[3];
+					std::int16_t normal[2];
+					std::uint16_t texCoords[2];
+					std::uint8_t boneWeights[KENGINE_ASSIMP_BONE_INFO_PER_VERTEX]; // Unorm, summing to 255
+					std::uint8_t boneIDs[KENGINE_ASSIMP_BONE_INFO_PER_VERTEX];
+				};
+
+				// Point into the cooked model, in `AssImpModelComponent::format`
+				const void * vertices = nullptr;
+				size_t nbVertices = 0;
+				const void * indices = nullptr;
+				size_t nbIndices = 0;
+				size_t indexSize = sizeof(std::uint32_t); // 2 for meshes with fewer than 65536 vertices
+
+				struct Lod {
+					std::uint32_t firstIndex;
+					std::uint32_t nbIndices;
+				};
+				const Lod * lods = nullptr; // Ranges of `indices`, from the full mesh to the coarsest level
+				size_t nbLods = 0;
 			};
 
-			Assimp::Importer importer;
-			std::vector<Assimp::Importer> animImporters;
+			VFS::File file; // Cooked model, mapped from its cache file
+			std::vector<char> buffer; // Cooked model, if its cache file couldn't be written
 			std::vector<Mesh> meshes;
+			AssImpVertexFormat format = AssImpVertexFormat::Full;
 		};
 
+		static_assert(sizeof(AssImpModelComponent::Mesh::StaticVertex) == 20 && sizeof(AssImpModelComponent::Mesh::SkinnedVertex) == 28, "Compact vertices shouldn't be padded");
+		static_assert(KENGINE_SKELETON_MAX_BONES <= 256, "Compact vertices store bone IDs on 8 bits");
+
+		static size_t getVertexSize(AssImpVertexFormat format) {
+			switch (format) {
+				case AssImpVertexFormat::Static: return sizeof(AssImpModelComponent::Mesh::StaticVertex);
+				case AssImpVertexFormat::Skinned: return sizeof(AssImpModelComponent::Mesh::SkinnedVertex);
+				default: return sizeof(AssImpModelComponent::Mesh::Vertex);
+			}
+		}
+
+		// Vertex attributes for the compact formats, matching the locations in AssImpShaderSrc
+		template<typename Vertex>
+		static void setCompactVertexAttributes() {
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *)offsetof(Vertex, position));
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(Vertex), (const void *)offsetof(Vertex, normal));
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(Vertex), (const void *)offsetof(Vertex, texCoords));
+		}
+
+		static void setStaticVertexType() {
+			setCompactVertexAttributes<AssImpModelComponent::Mesh::StaticVertex>();
+		}
+
+		static void setSkinnedVertexType() {
+			using Vertex = AssImpModelComponent::Mesh::SkinnedVertex;
+			setCompactVertexAttributes<Vertex>();
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, KENGINE_ASSIMP_BONE_INFO_PER_VERTEX, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void *)offsetof(Vertex, boneWeights));
+			glEnableVertexAttribArray(4);
+			glVertexAttribIPointer(4, KENGINE_ASSIMP_BONE_INFO_PER_VERTEX, GL_UNSIGNED_BYTE, sizeof(Vertex), (const void *)offsetof(Vertex, boneIDs));
+		}
+
+		static ModelDataComponent::VertexRegisterFunc getVertexRegisterFunc(AssImpVertexFormat format) {
+			switch (format) {
+				case AssImpVertexFormat::Static: return setStaticVertexType;
+				case AssImpVertexFormat::Skinned: return setSkinnedVertexType;
+				default: return putils::gl::setVertexType<AssImpModelComponent::Mesh::Vertex>;
+			}
+		}
+
+		// Flattened out of the aiScene, so that it can be cooked and doesn't need the importer to stay alive
 		struct AssImpSkeletonComponent {
+			static constexpr unsigned int INVALID_NODE = (unsigned int)-1;
+
+			struct Node {
+				glm::mat4 transform;
+				std::vector<unsigned int> children; // Indices into `nodes`
+				std::vector<std::pair<unsigned int, unsigned int>> bones; // Mesh and bone indices of the bones attached to this node
+			};
+
 			struct Mesh {
 				struct Bone {
-					aiNode * node = nullptr;
-					std::vector<const aiNodeAnim *> animNodes;
+					unsigned int node = INVALID_NODE;
 					glm::mat4 offset;
 				};
 				std::vector<Bone> bones;
 			};
 
-			aiNode * rootNode;
+			template<typename T>
+			struct Key {
+				float time;
+				T value;
+			};
+
+			struct Channel {
+				std::vector<Key<glm::vec3>> positions;
+				std::vector<Key<glm::quat>> rotations;
+				std::vector<Key<glm::vec3>> scales;
+
+				bool empty() const { return positions.empty() && rotations.empty() && scales.empty(); }
+			};
+
+			struct Animation {
+				std::vector<Channel> channels; // Indexed by node, empty for nodes the animation doesn't move
+			};
+
+			std::vector<Node> nodes; // nodes[0] is the root, parents come before their children
 			std::vector<Mesh> meshes;
 			glm::mat4 globalInverseTransform;
+			std::vector<Animation> animations; // Parallel to AnimListComponent::anims
 		};
 
-		static aiMatrix4x4 toAiMat(const glm::mat4 & mat) {
-			return aiMatrix4x4(mat[0][0], mat[1][0], mat[2][0], mat[3][0],
-				mat[0][1], mat[1][1], mat[2][1], mat[3][1],
-				mat[0][2], mat[1][2], mat[2][2], mat[3][2],
-				mat[0][3], mat[1][3], mat[2][3], mat[3][3]);
-		}
+		// CPU-side result of a background load, committed to the model Entity by `execute`
+		struct LoadedModel {
+			struct Texture {
+				putils::string<KENGINE_TEXTURE_PATH_MAX_LENGTH> file;
+				TextureCache::Texture decoded; // Owned until committed
+			};
+
+			struct MeshTextures {
+				std::vector<size_t> diffuse; // Indices into `textures`
+				std::vector<size_t> specular;
+
+				putils::NormalizedColor diffuseColor;
+				putils::NormalizedColor specularColor;
+			};
+
+			AssImpModelComponent model;
+			std::vector<MeshTextures> meshTextures;
+			std::vector<Texture> textures; // Decoded once per file, even if used by several meshes
+			ModelSkeletonComponent skeletonNames;
+			AssImpSkeletonComponent skeleton;
+			AnimListComponent animList;
+
+			~LoadedModel() {
+				for (const auto & texture : textures)
+					if (texture.decoded.data != nullptr)
+						TextureCache::release(texture.decoded.data);
+			}
+		};
+
+		struct LoadJob {
+			Entity::ID id;
+			putils::string<KENGINE_MODEL_STRING_MAX_LENGTH> file;
+			std::vector<std::string> animFiles;
+
+			std::atomic<bool> cancelled{ false }; // Set when the model Entity is removed before the job completes
+			std::atomic<bool> done{ false };
+			std::atomic<size_t> pendingTextures{ 0 };
+			bool succeeded = false;
+			LoadedModel result;
+		};
 
 		static glm::mat4 toglm(const aiMatrix4x4 & mat) {
 			return glm::make_mat4(&mat.a1);
@@ -141,383 +325,1057 @@ namespace kengine {
 		static glm::quat toglm(const aiQuaternion & quat) { return { quat.w, quat.x, quat.y, quat.z }; }
 
 		template<typename T>
-		static unsigned int findPreviousIndex(T * arr, unsigned int size, float time) {
-			for (unsigned i = 0; i < size - 1; ++i) {
-				if (time < (float)arr[i + 1].mTime)
+		static size_t findPreviousIndex(const std::vector<AssImpSkeletonComponent::Key<T>> & keys, float time) {
+			for (size_t i = 0; i < keys.size() - 1; ++i) {
+				if (time < keys[i + 1].time)
 					return i;
 			}
 			return 0;
 		}
 
 		template<typename T, typename Func>
-		static auto calculateInterpolatedValue(T * arr, unsigned int size, float time, Func func) {
-			if (size == 1)
-				return toglm(arr[0].mValue);
+		static T calculateInterpolatedValue(const std::vector<AssImpSkeletonComponent::Key<T>> & keys, float time, const T & defaultValue, Func func) {
+			if (keys.empty())
+				return defaultValue;
+			if (keys.size() == 1)
+				return keys[0].value;
 
-			const auto index = findPreviousIndex(arr, size, time);
-			const auto & value = arr[index];
-			const auto & nextValue = arr[index + 1];
+			const auto index = findPreviousIndex(keys, time);
+			const auto & key = keys[index];
+			const auto & nextKey = keys[index + 1];
 
-			const auto deltaTime = (float)nextValue.mTime - (float)value.mTime;
-			const auto factor = (time - (float)value.mTime) / (float)deltaTime;
+			const auto deltaTime = nextKey.time - key.time;
+			const auto factor = (time - key.time) / deltaTime;
 
-			const auto startValue = toglm(value.mValue);
-			const auto endValue = toglm(nextValue.mValue);
-
-			return func(startValue, endValue, factor);
+			return func(key.value, nextKey.value, factor);
 		}
 
-		static glm::vec3 calculateInterpolatedPosition(const AssImpSkeletonComponent::Mesh::Bone & bone, float time, size_t currentAnim) {
-			return calculateInterpolatedValue(bone.animNodes[currentAnim]->mPositionKeys, bone.animNodes[currentAnim]->mNumPositionKeys, time, [](const glm::vec3 & v1, const glm::vec3 & v2, float f) { return glm::mix(v1, v2, f); });
+		static glm::vec3 calculateInterpolatedPosition(const AssImpSkeletonComponent::Channel & channel, float time) {
+			return calculateInterpolatedValue(channel.positions, time, glm::vec3(0.f), [](const glm::vec3 & v1, const glm::vec3 & v2, float f) { return glm::mix(v1, v2, f); });
 		}
 
-		static glm::quat calculateInterpolatedRotation(const AssImpSkeletonComponent::Mesh::Bone & bone, float time, size_t currentAnim) {
-			return calculateInterpolatedValue(bone.animNodes[currentAnim]->mRotationKeys, bone.animNodes[currentAnim]->mNumRotationKeys, time, glm::slerp<float, glm::defaultp>);
+		static glm::quat calculateInterpolatedRotation(const AssImpSkeletonComponent::Channel & channel, float time) {
+			return calculateInterpolatedValue(channel.rotations, time, glm::quat(1.f, 0.f, 0.f, 0.f), glm::slerp<float, glm::defaultp>);
 		}
 
-		static glm::vec3 calculateInterpolatedScale(const AssImpSkeletonComponent::Mesh::Bone & bone, float time, size_t currentAnim) {
-			return calculateInterpolatedValue(bone.animNodes[currentAnim]->mScalingKeys, bone.animNodes[currentAnim]->mNumScalingKeys, time, [](const glm::vec3 & v1, const glm::vec3 & v2, float f) { return glm::mix(v1, v2, f); });
+		static glm::vec3 calculateInterpolatedScale(const AssImpSkeletonComponent::Channel & channel, float time) {
+			return calculateInterpolatedValue(channel.scales, time, glm::vec3(1.f), [](const glm::vec3 & v1, const glm::vec3 & v2, float f) { return glm::mix(v1, v2, f); });
 		}
 
-		static void updateBoneMats(const aiNode * node, float time, size_t currentAnim, const AssImpSkeletonComponent & assimp, SkeletonComponent & comp, const glm::mat4 & parentTransform) {
-			bool firstCalc = true;
-			glm::mat4 totalTransform = parentTransform * toglmWeird(node->mTransformation);
+		static void updateBoneMats(const AssImpSkeletonComponent & assimp, unsigned int nodeIndex, float time, size_t currentAnim, SkeletonComponent & comp, const glm::mat4 & parentTransform) {
+			const auto & node = assimp.nodes[nodeIndex];
+			glm::mat4 totalTransform = parentTransform * node.transform;
+
+			if (!node.bones.empty()) {
+				glm::mat4 mat(1.f);
+				const auto & channel = assimp.animations[currentAnim].channels[nodeIndex];
+				if (!channel.empty()) {
+					const auto pos = calculateInterpolatedPosition(channel, time);
+					const auto rot = calculateInterpolatedRotation(channel, time);
+					const auto scale = calculateInterpolatedScale(channel, time);
+
+					mat = glm::translate(mat, pos);
+					mat *= glm::mat4_cast(rot);
+					mat = glm::scale(mat, scale);
+				}
+				totalTransform = parentTransform * mat;
 
-			for (unsigned int i = 0; i < assimp.meshes.size(); ++i) {
-				const auto & input = assimp.meshes[i];
-				auto & output = comp.meshes[i];
+				for (const auto & [mesh, bone] : node.bones) {
+					const auto & input = assimp.meshes[mesh];
+					auto & output = comp.meshes[mesh];
 
-				assert(input.bones.size() < lengthof(output.boneMatsBoneSpace)); // Need to increase KENGINE_SKELETON_MAX_BONES
+					assert(input.bones.size() < lengthof(output.boneMatsBoneSpace)); // Need to increase KENGINE_SKELETON_MAX_BONES
 
-				size_t boneIndex = 0;
-				for (const auto & bone : input.bones) {
-					if (bone.node == node)
-						break;
-					++boneIndex;
+					output.boneMatsMeshSpace[bone] = totalTransform;
+					output.boneMatsBoneSpace[bone] = totalTransform * input.bones[bone].offset;
 				}
+			}
 
-				if (boneIndex != input.bones.size()) {
-					const auto & modelBone = input.bones[boneIndex];
+			for (const auto child : node.children)
+				updateBoneMats(assimp, child, time, currentAnim, comp, totalTransform);
+		}
 
-					if (firstCalc) {
-						glm::mat4 mat(1.f);
-						if (modelBone.animNodes[currentAnim] != nullptr) {
-							const auto pos = calculateInterpolatedPosition(modelBone, time, currentAnim);
-							const auto rot = calculateInterpolatedRotation(modelBone, time, currentAnim);
-							const auto scale = calculateInterpolatedScale(modelBone, time, currentAnim);
+		// Lets assimp read models, and the files they reference (e.g. .mtl materials), through the VFS
+		class VFSStream : public Assimp::IOStream {
+		public:
+			VFSStream(VFS::File && file) : _file(std::move(file)) {}
+
+			size_t Read(void * buffer, size_t size, size_t count) override {
+				if (size == 0)
+					return 0;
+				count = std::min(count, (_file.size() - _pos) / size);
+				memcpy(buffer, (const char *)_file.data() + _pos, size * count);
+				_pos += size * count;
+				return count;
+			}
 
-							mat = glm::translate(mat, pos);
-							mat *= glm::mat4_cast(rot);
-							mat = glm::scale(mat, scale);
-						}
-						totalTransform = parentTransform * mat;
+			size_t Write(const void *, size_t, size_t) override { return 0; }
 
-						firstCalc = false;
-					}
+			aiReturn Seek(size_t offset, aiOrigin origin) override {
+				const auto base = origin == aiOrigin_CUR ? _pos : origin == aiOrigin_END ? _file.size() : 0;
+				if (offset > _file.size() - base)
+					return aiReturn_FAILURE;
+				_pos = base + offset;
+				return aiReturn_SUCCESS;
+			}
 
-					output.boneMatsMeshSpace[boneIndex] = totalTransform;
-					output.boneMatsBoneSpace[boneIndex] = totalTransform * modelBone.offset;
-				}
+			size_t Tell() const override { return _pos; }
+			size_t FileSize() const override { return _file.size(); }
+			void Flush() override {}
+
+		private:
+			VFS::File _file;
+			size_t _pos = 0;
+		};
+
+		class VFSSystem : public Assimp::IOSystem {
+		public:
+			// Every file assimp opens is appended to `opened`
+			VFSSystem(std::vector<std::string> & opened) : _opened(opened) {}
+
+			bool Exists(const char * file) const override { return VFS::exists(file); }
+			char getOsSeparator() const override { return '/'; }
+
+			Assimp::IOStream * Open(const char * file, const char * mode) override {
+				if (strchr(mode, 'w') != nullptr || strchr(mode, 'a') != nullptr)
+					return nullptr; // Read-only
+				VFS::File f(file);
+				if (!f.isOpen())
+					return nullptr;
+				if (std::find(_opened.begin(), _opened.end(), file) == _opened.end())
+					_opened.push_back(file);
+				return new VFSStream(std::move(f));
 			}
 
-			for (size_t i = 0; i < node->mNumChildren; ++i)
-				updateBoneMats(node->mChildren[i], time, currentAnim, assimp, comp, totalTransform);
-		}
+			void Close(Assimp::IOStream * stream) override { delete stream; }
 
-		static void loadMaterialTextures(std::vector<Entity::ID> & textures, const char * directory, const aiMaterial * mat, aiTextureType type) {
-			for (unsigned int i = 0; i < mat->GetTextureCount(type); ++i) {
-				aiString path;
-				mat->GetTexture(type, i, &path);
+		private:
+			std::vector<std::string> & _opened;
+		};
 
-				const putils::string<KENGINE_TEXTURE_PATH_MAX_LENGTH> fullPath("%s/%s", directory, path.C_Str());
+		// Cooked models are written next to their source file and mapped by later runs, skipping the import
+		namespace Cache {
+			static constexpr char MAGIC[] = { 'K', 'M', 'D', 'L' };
+			static constexpr std::uint32_t VERSION = 7;
+			static constexpr size_t ALIGNMENT = 16; // Arrays are aligned so they can be used in place once mapped
+
+			struct Header {
+				char magic[sizeof(MAGIC)];
+				std::uint32_t version;
+				std::uint32_t vertexFormat; // AssImpVertexFormat
+				std::uint32_t boneInfoPerVertex;
+				std::uint64_t sourceHash; // Of the model and animation files' VFS stamps, and of everything else that affects cooking
+				std::uint64_t dependencyHash; // Of the VFS stamps of the side files (e.g. .mtl materials) listed after the header
+			};
 
-				Entity::ID modelID = Entity::INVALID_ID;
-				for (const auto &[e, model] : g_em->getEntities<TextureModelComponent>())
-					if (model.file == fullPath) {
-						modelID = e.id;
-						break;
-					}
+			static void hashBytes(std::uint64_t & hash, const void * data, size_t size) { // FNV-1a
+				const auto bytes = (const unsigned char *)data;
+				for (size_t i = 0; i < size; ++i) {
+					hash ^= bytes[i];
+					hash *= 1099511628211ull;
+				}
+			}
+
+			// Only hashes the files' VFS stamps, so that checking a cooked model doesn't read its sources
+			// Returns false if the model file wasn't found
+			static bool hashSources(const LoadJob & job, std::uint64_t & hash) {
+				hash = 14695981039346656037ull;
+
+				const std::uint32_t settings[] = {
+					VERSION, IMPORT_FLAGS, (std::uint32_t)sizeof(AssImpModelComponent::Mesh::Vertex), KENGINE_ASSIMP_BONE_INFO_PER_VERTEX,
+					KENGINE_ASSIMP_MERGE_MESH_VERTICES, KENGINE_MESH_OPTIMIZER_CACHE_SIZE, KENGINE_ASSIMP_LOD_LEVELS, KENGINE_ASSIMP_LOD_MIN_TRIANGLES,
+#ifdef KENGINE_ASSIMP_FULL_VERTICES
+					1
+#else
+					0
+#endif
+				};
+				hashBytes(hash, settings, sizeof(settings));
+				const float overdrawThreshold = KENGINE_ASSIMP_OVERDRAW_THRESHOLD;
+				hashBytes(hash, &overdrawThreshold, sizeof(overdrawThreshold));
+
+				const auto hashFile = [&hash](const char * f) {
+					hashBytes(hash, f, strlen(f) + 1); // Texture paths and animation names depend on it
+					std::uint64_t stamp = 0;
+					const bool found = VFS::stamp(f, stamp);
+					hashBytes(hash, &found, sizeof(found));
+					hashBytes(hash, &stamp, sizeof(stamp));
+					return found;
+				};
 
-				if (modelID == Entity::INVALID_ID) {
-					*g_em += [&](Entity & e) {
-						modelID = e.id;
+				if (!hashFile(job.file.c_str()))
+					return false;
+				for (const auto & animFile : job.animFiles)
+					hashFile(animFile.c_str()); // Missing animation files are skipped when cooking
+				return true;
+			}
 
-						auto & comp = e.attach<TextureModelComponent>();
-						comp.file = fullPath.c_str();
+			// Files assimp read while cooking, other than the model and animation files
+			static std::uint64_t hashDependencies(const std::vector<std::string> & dependencies) {
+				std::uint64_t hash = 14695981039346656037ull;
+				for (const auto & dependency : dependencies) {
+					hashBytes(hash, dependency.c_str(), dependency.size() + 1);
+					std::uint64_t stamp = 0;
+					const bool found = VFS::stamp(dependency.c_str(), stamp);
+					hashBytes(hash, &found, sizeof(found));
+					hashBytes(hash, &stamp, sizeof(stamp));
+				}
+				return hash;
+			}
 
-						TextureDataComponent textureLoader; {
-							textureLoader.textureID = &comp.texture;
+			class Writer {
+			public:
+				template<typename T>
+				void write(const T & value) { append(&value, sizeof(value)); }
 
-							textureLoader.data = stbi_load(fullPath.c_str(), &textureLoader.width, &textureLoader.height, &textureLoader.components, 0);
-							assert(textureLoader.data != nullptr);
-							textureLoader.free = stbi_image_free;
-						} e += textureLoader;
-					};
+				void writeString(const std::string & s) {
+					write((std::uint32_t)s.size());
+					append(s.data(), s.size());
 				}
 
-				textures.push_back(modelID);
-			}
-		}
+				template<typename T>
+				void writeArray(const T * values, size_t count) {
+					write((std::uint32_t)count);
+					buffer.resize((buffer.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+					append(values, count * sizeof(T));
+				}
 
-		static AssImpModelComponent::Mesh processMesh(const aiMesh * mesh) {
-			AssImpModelComponent::Mesh ret;
+				template<typename T>
+				void writeArray(const std::vector<T> & values) { writeArray(values.data(), values.size()); }
 
-			for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-				AssImpModelComponent::Mesh::Vertex vertex;
+				std::vector<char> buffer;
 
-				vertex.position[0] = mesh->mVertices[i].x;
-				vertex.position[1] = mesh->mVertices[i].y;
-				vertex.position[2] = mesh->mVertices[i].z;
+			private:
+				void append(const void * data, size_t size) {
+					const auto offset = buffer.size();
+					buffer.resize(offset + size);
+					if (size > 0)
+						memcpy(buffer.data() + offset, data, size);
+				}
+			};
 
-				vertex.normal[0] = mesh->mNormals[i].x;
-				vertex.normal[1] = mesh->mNormals[i].y;
-				vertex.normal[2] = mesh->mNormals[i].z;
+			// Bounds-checked, so that a truncated or corrupt cache is re-cooked instead of read past its end
+			class Reader {
+			public:
+				Reader(const void * data, size_t size) : _data((const char *)data), _size(size) {}
+
+				template<typename T>
+				bool read(T & value) {
+					if (_size - _offset < sizeof(T))
+						return false;
+					memcpy(&value, _data + _offset, sizeof(T));
+					_offset += sizeof(T);
+					return true;
+				}
 
-				if (mesh->mTextureCoords[0] != nullptr) {
-					vertex.texCoords[0] = mesh->mTextureCoords[0][i].x;
-					vertex.texCoords[1] = mesh->mTextureCoords[0][i].y;
+				bool readString(std::string & s) {
+					std::uint32_t size;
+					if (!read(size) || _size - _offset < size)
+						return false;
+					s.assign(_data + _offset, size);
+					_offset += size;
+					return true;
 				}
-				else {
-					vertex.texCoords[0] = 0.f;
-					vertex.texCoords[1] = 0.f;
+
+				// Points into the cooked data instead of copying it
+				template<typename T>
+				bool view(const T * & values, size_t & count) {
+					std::uint32_t size;
+					if (!read(size))
+						return false;
+
+					const auto aligned = (_offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+					if (aligned > _size || (_size - aligned) / sizeof(T) < size)
+						return false;
+
+					values = (const T *)(_data + aligned);
+					count = size;
+					_offset = aligned + size * sizeof(T);
+					return true;
 				}
 
-				ret.vertices.push_back(vertex);
-			}
+				// Skips the padding the Writer inserts before nested buffers
+				bool align() {
+					const auto aligned = (_offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+					if (aligned > _size)
+						return false;
+					_offset = aligned;
+					return true;
+				}
 
-			// for each bone
-			for (unsigned int i = 0; i < mesh->mNumBones; ++i) {
-				const auto bone = mesh->mBones[i];
-				// for each weight (vertex it has an influence on)
-				for (unsigned int j = 0; j < bone->mNumWeights; ++j) {
-					const auto & weight = bone->mWeights[j];
-					auto & vertex = ret.vertices[weight.mVertexId];
+				template<typename T>
+				bool readArray(std::vector<T> & values) {
+					const T * data;
+					size_t count;
+					if (!view(data, count))
+						return false;
+					values.assign(data, data + count);
+					return true;
+				}
 
-					// add this bone to the vertex
-					bool found = false;
-					for (unsigned int k = 0; k < KENGINE_ASSIMP_BONE_INFO_PER_VERTEX; ++k)
-						if (vertex.boneWeights[k] == 0.f) {
-							found = true;
-							vertex.boneWeights[k] = weight.mWeight;
-							vertex.boneIDs[k] = i;
-							break;
-						}
-					assert(found); // too many bones have info for a single vertex
-					if (!found) {
-						float smallestWeight = FLT_MAX;
-						unsigned int smallestIndex = 0;
+			private:
+				const char * _data;
+				size_t _size;
+				size_t _offset = 0;
+			};
+
+			struct CookedMesh {
+				std::vector<AssImpModelComponent::Mesh::Vertex> vertices;
+				std::vector<std::uint32_t> indices; // Of all levels of detail
+				std::vector<AssImpModelComponent::Mesh::Lod> lods;
+				unsigned int material;
+			};
+
+			static CookedMesh processMesh(const aiMesh * mesh) {
+				CookedMesh ret;
+				ret.material = mesh->mMaterialIndex;
+
+				for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+					AssImpModelComponent::Mesh::Vertex vertex;
+
+					vertex.position[0] = mesh->mVertices[i].x;
+					vertex.position[1] = mesh->mVertices[i].y;
+					vertex.position[2] = mesh->mVertices[i].z;
+
+					vertex.normal[0] = mesh->mNormals[i].x;
+					vertex.normal[1] = mesh->mNormals[i].y;
+					vertex.normal[2] = mesh->mNormals[i].z;
+
+					if (mesh->mTextureCoords[0] != nullptr) {
+						vertex.texCoords[0] = mesh->mTextureCoords[0][i].x;
+						vertex.texCoords[1] = mesh->mTextureCoords[0][i].y;
+					}
+					else {
+						vertex.texCoords[0] = 0.f;
+						vertex.texCoords[1] = 0.f;
+					}
+
+					ret.vertices.push_back(vertex);
+				}
+
+				// for each bone
+				for (unsigned int i = 0; i < mesh->mNumBones; ++i) {
+					const auto bone = mesh->mBones[i];
+					// for each weight (vertex it has an influence on)
+					for (unsigned int j = 0; j < bone->mNumWeights; ++j) {
+						const auto & weight = bone->mWeights[j];
+						auto & vertex = ret.vertices[weight.mVertexId];
+
+						// add this bone to the vertex
+						bool found = false;
 						for (unsigned int k = 0; k < KENGINE_ASSIMP_BONE_INFO_PER_VERTEX; ++k)
-							if (vertex.boneWeights[k] < smallestWeight) {
-								smallestWeight = vertex.boneWeights[k];
-								smallestIndex = k;
+							if (vertex.boneWeights[k] == 0.f) {
+								found = true;
+								vertex.boneWeights[k] = weight.mWeight;
+								vertex.boneIDs[k] = i;
+								break;
 							}
-						if (weight.mWeight > smallestWeight)
-							vertex.boneWeights[smallestIndex] = weight.mWeight;
+						assert(found); // too many bones have info for a single vertex
+						if (!found) {
+							float smallestWeight = FLT_MAX;
+							unsigned int smallestIndex = 0;
+							for (unsigned int k = 0; k < KENGINE_ASSIMP_BONE_INFO_PER_VERTEX; ++k)
+								if (vertex.boneWeights[k] < smallestWeight) {
+									smallestWeight = vertex.boneWeights[k];
+									smallestIndex = k;
+								}
+							if (weight.mWeight > smallestWeight)
+								vertex.boneWeights[smallestIndex] = weight.mWeight;
+						}
 					}
 				}
+
+				// For models with no skeleton
+				for (auto & vertex : ret.vertices)
+					if (vertex.boneWeights[0] == 0.f) {
+						vertex.boneWeights[0] = 1.f;
+						vertex.boneIDs[0] = 0;
+					}
+
+				for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+					if (mesh->mFaces[i].mNumIndices == 3) // Triangulation leaves points and lines, which would throw off the triangle optimizations
+						for (unsigned int j = 0; j < 3; ++j)
+							ret.indices.push_back(mesh->mFaces[i].mIndices[j]);
+				return ret;
 			}
 
-			// For models with no skeleton
-			for (auto & vertex : ret.vertices)
-				if (vertex.boneWeights[0] == 0.f) {
-					vertex.boneWeights[0] = 1.f;
-					vertex.boneIDs[0] = 0;
+			// Merges small meshes into the first one sharing their material, to save draw calls. Merged meshes keep 16-bit indices
+			static void mergeMeshes(std::vector<CookedMesh> & meshes) {
+				static constexpr size_t MAX_MERGED_VERTICES = std::numeric_limits<std::uint16_t>::max();
+
+				std::vector<CookedMesh> merged;
+				std::unordered_map<unsigned int, size_t> targets; // Material to index in `merged`
+				for (auto & mesh : meshes) {
+					if (mesh.vertices.size() >= KENGINE_ASSIMP_MERGE_MESH_VERTICES) {
+						merged.push_back(std::move(mesh));
+						continue;
+					}
+
+					const auto it = targets.find(mesh.material);
+					if (it == targets.end() || merged[it->second].vertices.size() + mesh.vertices.size() > MAX_MERGED_VERTICES) {
+						targets[mesh.material] = merged.size();
+						merged.push_back(std::move(mesh));
+						continue;
+					}
+
+					auto & target = merged[it->second];
+					const auto offset = (std::uint32_t)target.vertices.size();
+					target.vertices.insert(target.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+					for (const auto index : mesh.indices)
+						target.indices.push_back(index + offset);
 				}
+				meshes = std::move(merged);
+			}
 
-			for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
-				for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; ++j)
-					ret.indices.push_back(mesh->mFaces[i].mIndices[j]);
-			return ret;
-		}
+			// Reorders triangles for the vertex cache and overdraw, then vertices for fetching
+			static void optimizeMesh(CookedMesh & mesh) {
+				auto & vertices = mesh.vertices;
+				auto & indices = mesh.indices;
 
-		static AssImpTexturesModelComponent::MeshTextures processMeshTextures(const char * directory, const aiMesh * mesh, const aiScene * scene) {
-			AssImpTexturesModelComponent::MeshTextures meshTextures;
-			if (mesh->mMaterialIndex >= 0) {
-				const auto material = scene->mMaterials[mesh->mMaterialIndex];
-				loadMaterialTextures(meshTextures.diffuse, directory, material, aiTextureType_DIFFUSE);
-				loadMaterialTextures(meshTextures.specular, directory, material, aiTextureType_SPECULAR);
+				MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+				MeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), vertices.empty() ? nullptr : vertices[0].position, vertices.size(), sizeof(vertices[0]), KENGINE_ASSIMP_OVERDRAW_THRESHOLD);
+				vertices.resize(MeshOptimizer::optimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.size(), sizeof(vertices[0])));
+			}
+
+			// Appends simplified versions of the optimized mesh to its indices, each with about half the previous level's triangles
+			// They reference the same vertices, so switching levels only changes the range of indices drawn
+			static void generateLods(CookedMesh & mesh) {
+				auto & indices = mesh.indices;
+				mesh.lods.push_back({ 0, (std::uint32_t)indices.size() });
 
-				aiColor3D color{ 0.f, 0.f, 0.f };
-				material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-				meshTextures.diffuseColor = { color.r, color.g, color.b };
-				material->Get(AI_MATKEY_COLOR_SPECULAR, color);
-				meshTextures.specularColor = { color.r, color.g, color.b };
+				std::vector<std::uint32_t> simplified(indices.size());
+				while (mesh.lods.size() < KENGINE_ASSIMP_LOD_LEVELS) {
+					const auto previous = mesh.lods.back();
+					if (previous.nbIndices / 3 < KENGINE_ASSIMP_LOD_MIN_TRIANGLES * 2)
+						break;
+
+					const auto first = indices.data() + previous.firstIndex;
+					const auto count = MeshOptimizer::simplify(simplified.data(), first, previous.nbIndices, mesh.vertices[0].position, mesh.vertices.size(), sizeof(mesh.vertices[0]), previous.nbIndices / 2);
+					if (count == 0 || count > previous.nbIndices * 3 / 4) // Not worth the memory
+						break;
+
+					MeshOptimizer::optimizeVertexCache(simplified.data(), count, mesh.vertices.size());
+					mesh.lods.push_back({ (std::uint32_t)indices.size(), (std::uint32_t)count });
+					indices.insert(indices.end(), simplified.begin(), simplified.begin() + count);
+				}
 			}
-			else
-				assert(false);
-			return meshTextures;
-		}
 
-		static void processNode(AssImpModelComponent & modelData, AssImpTexturesModelComponent & textures, const char * directory, const aiNode * node, const aiScene * scene, bool firstLoad) {
-			for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-				const aiMesh * mesh = scene->mMeshes[node->mMeshes[i]];
-				if (firstLoad)
-					modelData.meshes.push_back(processMesh(mesh));
-				textures.meshes.push_back(processMeshTextures(directory, mesh, scene));
+			static void encodeOctahedral(const float * normal, std::int16_t * encoded) {
+				const auto length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+				float x = length > 0.f ? normal[0] / length : 0.f;
+				float y = length > 0.f ? normal[1] / length : 0.f;
+				if (normal[2] < 0.f) { // Fold the lower hemisphere over the diagonals
+					const auto folded = x;
+					x = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+					y = (1.f - std::abs(folded)) * (y >= 0.f ? 1.f : -1.f);
+				}
+				encoded[0] = (std::int16_t)std::round(std::clamp(x, -1.f, 1.f) * 32767.f);
+				encoded[1] = (std::int16_t)std::round(std::clamp(y, -1.f, 1.f) * 32767.f);
 			}
 
-			for (unsigned int i = 0; i < node->mNumChildren; ++i)
-				processNode(modelData, textures, directory, node->mChildren[i], scene, firstLoad);
-		}
+			// Rounds weights to 8 bits while keeping their sum at 255, so that skinned positions aren't scaled
+			static void quantizeWeights(const float * weights, std::uint8_t * quantized) {
+				float sum = 0.f;
+				for (size_t i = 0; i < KENGINE_ASSIMP_BONE_INFO_PER_VERTEX; ++i)
+					sum += weights[i];
+
+				int total = 0;
+				size_t largest = 0;
+				for (size_t i = 0; i < KENGINE_ASSIMP_BONE_INFO_PER_VERTEX; ++i) {
+					quantized[i] = (std::uint8_t)std::round(sum > 0.f ? weights[i] / sum * 255.f : 0.f);
+					total += quantized[i];
+					if (weights[i] > weights[largest])
+						largest = i;
+				}
+				quantized[largest] = (std::uint8_t)(quantized[largest] + 255 - total);
+			}
 
-		static void addNode(std::vector<aiNode *> & allNodes, aiNode * node) {
-			allNodes.push_back(node);
-			for (unsigned int i = 0; i < node->mNumChildren; ++i)
-				addNode(allNodes, node->mChildren[i]);
-		}
+			template<typename Compact>
+			static void writeCompactVertices(Writer & writer, const std::vector<AssImpModelComponent::Mesh::Vertex> & vertices) {
+				std::vector<Compact> compact(vertices.size());
+				for (size_t i = 0; i < vertices.size(); ++i) {
+					const auto & in = vertices[i];
+					auto & out = compact[i];
+
+					std::copy(std::begin(in.position), std::end(in.position), out.position);
+					encodeOctahedral(in.normal, out.normal);
+					out.texCoords[0] = glm::packHalf1x16(in.texCoords[0]);
+					out.texCoords[1] = glm::packHalf1x16(in.texCoords[1]);
+
+					if constexpr (std::is_same<Compact, AssImpModelComponent::Mesh::SkinnedVertex>()) {
+						quantizeWeights(in.boneWeights, out.boneWeights);
+						for (size_t j = 0; j < KENGINE_ASSIMP_BONE_INFO_PER_VERTEX; ++j)
+							out.boneIDs[j] = (std::uint8_t)in.boneIDs[j];
+					}
+				}
+				writer.writeArray(compact);
+			}
 
-		static const AssImpSkeletonComponent::Mesh::Bone * findBone(const ModelSkeletonComponent::Mesh & model, const AssImpSkeletonComponent::Mesh & skeleton, const char * name) {
-			for (unsigned int i = 0; i < skeleton.bones.size(); ++i)
-				if (model.boneNames[i] == name)
-					return &skeleton.bones[i];
-			return nullptr;
-		}
+			static void writeMesh(Writer & writer, const CookedMesh & mesh, AssImpVertexFormat format) {
+				switch (format) {
+					case AssImpVertexFormat::Static:
+						writeCompactVertices<AssImpModelComponent::Mesh::StaticVertex>(writer, mesh.vertices);
+						break;
+					case AssImpVertexFormat::Skinned:
+						writeCompactVertices<AssImpModelComponent::Mesh::SkinnedVertex>(writer, mesh.vertices);
+						break;
+					default:
+						writer.writeArray(mesh.vertices);
+						break;
+				}
 
-		static aiNode * findNode(const std::vector<aiNode *> & allNodes, const char * name) {
-			for (const auto node : allNodes)
-				if (strcmp(node->mName.data, name) == 0)
-					return node;
-			assert(false);
-			return nullptr;
-		}
+				if (mesh.vertices.size() > std::numeric_limits<std::uint16_t>::max()) {
+					writer.write((std::uint32_t)sizeof(std::uint32_t));
+					writer.writeArray(mesh.indices);
+				}
+				else {
+					const std::vector<std::uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+					writer.write((std::uint32_t)sizeof(std::uint16_t));
+					writer.writeArray(indices);
+				}
 
-		static aiNodeAnim * findNodeAnim(const std::vector<aiNodeAnim *> & allNodes, const char * name) {
-			for (const auto node : allNodes)
-				if (strcmp(node->mNodeName.data, name) == 0)
-					return node;
-			return nullptr;
-		}
+				writer.writeArray(mesh.lods);
+			}
+
+			static void loadMaterialTextures(std::vector<std::string> & allTextures, std::vector<std::uint32_t> & textures, const char * directory, const aiMaterial * mat, aiTextureType type) {
+				for (unsigned int i = 0; i < mat->GetTextureCount(type); ++i) {
+					aiString path;
+					mat->GetTexture(type, i, &path);
 
-		static void addAnim(const char * animFile, aiAnimation * aiAnim, const ModelSkeletonComponent & model, AssImpSkeletonComponent & skeleton, AnimListComponent & animList) {
-			AnimListComponent::Anim anim;
-			anim.name = animFile;
-			anim.name += "/";
-			anim.name += aiAnim->mName.data;
-			anim.ticksPerSecond = (float)(aiAnim->mTicksPerSecond != 0 ? aiAnim->mTicksPerSecond : 25.0);
-			anim.totalTime = (float)aiAnim->mDuration / anim.ticksPerSecond;
-			animList.anims.push_back(std::move(anim));
+					const putils::string<KENGINE_TEXTURE_PATH_MAX_LENGTH> fullPath("%s/%s", directory, path.C_Str());
 
-			std::vector<aiNodeAnim *> allNodeAnims;
-			for (unsigned int i = 0; i < aiAnim->mNumChannels; ++i)
-				allNodeAnims.push_back(aiAnim->mChannels[i]);
+					size_t index = 0;
+					while (index < allTextures.size() && allTextures[index] != fullPath.c_str())
+						++index;
 
-			for (unsigned int i = 0; i < skeleton.meshes.size(); ++i) {
-				auto & mesh = skeleton.meshes[i];
-				for (unsigned int j = 0; j < mesh.bones.size(); ++j) {
-					auto & bone = mesh.bones[j];
-					const auto & boneName = model.meshes[i].boneNames[j];
-					bone.animNodes.push_back(findNodeAnim(allNodeAnims, boneName.c_str()));
+					if (index == allTextures.size())
+						allTextures.push_back(fullPath.c_str());
+
+					textures.push_back((std::uint32_t)index);
 				}
 			}
-		}
 
-		static auto release(Entity::ID id) {
-			return [id] {
-#if 0 // Disabled because scene is still used for animation at this point
-				auto & e = g_em->getEntity(id);
-
-				auto & model = e.attach<AssImpModelComponent>(); // previous attach hasn't been processed yet, so `get` would assert
-				model.importer.FreeScene();
-				for (auto & importer : model.animImporters)
-					importer.FreeScene();
-				e.detach<AssImpModelComponent>();
-#endif
-			};
-		}
+			static void addMeshes(std::vector<const aiMesh *> & meshes, const aiNode * node, const aiScene * scene) {
+				for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+					meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 
-		static bool loadFile(Entity & e) {
-			const auto & f = e.get<ModelComponent>().file.c_str();
-			if (!g_importer.IsExtensionSupported(putils::file_extension(f).data()))
-				return false;
+				for (unsigned int i = 0; i < node->mNumChildren; ++i)
+					addMeshes(meshes, node->mChildren[i], scene);
+			}
 
-#ifndef KENGINE_NDEBUG
-			std::cout << putils::termcolor::green << "[AssImp] Loading " << putils::termcolor::cyan << f << putils::termcolor::green << "..." << putils::termcolor::reset;
-#endif
+			static void addNode(std::vector<const aiNode *> & allNodes, const aiNode * node) {
+				allNodes.push_back(node);
+				for (unsigned int i = 0; i < node->mNumChildren; ++i)
+					addNode(allNodes, node->mChildren[i]);
+			}
 
-			auto & model = e.attach<AssImpModelComponent>();
+			static std::uint32_t findNode(const std::vector<const aiNode *> & allNodes, const char * name) {
+				for (size_t i = 0; i < allNodes.size(); ++i)
+					if (strcmp(allNodes[i]->mName.data, name) == 0)
+						return (std::uint32_t)i;
+				assert(false);
+				return AssImpSkeletonComponent::INVALID_NODE;
+			}
 
-			auto & textures = e.attach<AssImpTexturesModelComponent>();
-			textures.meshes.clear();
-			auto & skeletonNames = e.attach<ModelSkeletonComponent>();
-			skeletonNames.meshes.clear();
-			auto & skeleton = e.attach<AssImpSkeletonComponent>();
-			skeleton.meshes.clear();
-			auto & animList = e.attach<AnimListComponent>();
-			animList.anims.clear();
+			static const aiNodeAnim * findNodeAnim(const aiAnimation * anim, const char * name) {
+				for (unsigned int i = 0; i < anim->mNumChannels; ++i)
+					if (strcmp(anim->mChannels[i]->mNodeName.data, name) == 0)
+						return anim->mChannels[i];
+				return nullptr;
+			}
 
-			bool firstLoad = false;
+			template<typename T, typename AiKey>
+			static void writeKeys(Writer & writer, const AiKey * keys, unsigned int count) {
+				std::vector<AssImpSkeletonComponent::Key<T>> converted;
+				for (unsigned int i = 0; i < count; ++i)
+					converted.push_back({ (float)keys[i].mTime, toglm(keys[i].mValue) });
+				writer.writeArray(converted);
+			}
 
-			if (model.importer.GetScene() == nullptr) {
-				const auto scene = model.importer.ReadFile(f, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals /*| aiProcess_OptimizeMeshes*/ | aiProcess_JoinIdenticalVertices);
-				if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode == nullptr) {
-					std::cerr << putils::termcolor::red << model.importer.GetErrorString() << '\n' << putils::termcolor::reset;
-					assert(false);
+			static void writeAnim(Writer & writer, const char * animFile, const aiAnimation * anim, const std::vector<const aiNode *> & allNodes, const std::vector<bool> & isBone) {
+				writer.writeString(std::string(animFile) + "/" + anim->mName.data);
+				const auto ticksPerSecond = (float)(anim->mTicksPerSecond != 0 ? anim->mTicksPerSecond : 25.0);
+				writer.write(ticksPerSecond);
+				writer.write((float)anim->mDuration / ticksPerSecond);
+
+				// Only bones are animated
+				for (size_t i = 0; i < allNodes.size(); ++i) {
+					const auto channel = isBone[i] ? findNodeAnim(anim, allNodes[i]->mName.data) : nullptr;
+					writeKeys<glm::vec3>(writer, channel != nullptr ? channel->mPositionKeys : nullptr, channel != nullptr ? channel->mNumPositionKeys : 0);
+					writeKeys<glm::quat>(writer, channel != nullptr ? channel->mRotationKeys : nullptr, channel != nullptr ? channel->mNumRotationKeys : 0);
+					writeKeys<glm::vec3>(writer, channel != nullptr ? channel->mScalingKeys : nullptr, channel != nullptr ? channel->mNumScalingKeys : 0);
 				}
-				firstLoad = true;
 			}
-			const auto scene = model.importer.GetScene();
 
-			const auto dir = putils::get_directory(f);
-			processNode(model, textures, putils::string<64>(dir), scene->mRootNode, scene, firstLoad);
+			// Imports the model and animation files and serializes everything the AssImpSystem needs from them
+			static bool cook(const LoadJob & job, std::uint64_t sourceHash, std::vector<char> & cooked) {
+				const auto f = job.file.c_str();
 
-			std::vector<aiNode *> allNodes;
-			addNode(allNodes, scene->mRootNode);
-			skeleton.rootNode = scene->mRootNode;
+				std::vector<std::string> opened; // Including side files, such as .mtl materials, which are only known once imported
+				Assimp::Importer importer;
+				importer.SetIOHandler(new VFSSystem(opened)); // Owned by the importer
+				const auto scene = importer.ReadFile(f, IMPORT_FLAGS);
+				if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode == nullptr) {
+					std::cerr << putils::termcolor::red << "[AssImp] Failed to load " << f << ": " << importer.GetErrorString() << '\n' << putils::termcolor::reset;
+					return false;
+				}
 
-			for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
-				const auto mesh = scene->mMeshes[i];
+				bool skinned = false;
+				for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+					skinned |= scene->mMeshes[i]->mNumBones > 0;
 
-				ModelSkeletonComponent::Mesh meshNames;
-				AssImpSkeletonComponent::Mesh meshBones;
-				for (unsigned int i = 0; i < mesh->mNumBones; ++i) {
-					const auto aiBone = mesh->mBones[i];
-					const auto name = aiBone->mName.data;
+#ifdef KENGINE_ASSIMP_FULL_VERTICES
+				const auto format = AssImpVertexFormat::Full;
+#else
+				const auto format = skinned ? AssImpVertexFormat::Skinned : AssImpVertexFormat::Static;
+#endif
+
+				Writer writer; // Written after the header and dependencies, which are only known once the animations are imported
+
+				// Meshes, in drawing order
+				std::vector<const aiMesh *> meshes;
+				addMeshes(meshes, scene->mRootNode, scene);
+
+				std::vector<CookedMesh> cookedMeshes;
+				for (const auto mesh : meshes)
+					cookedMeshes.push_back(processMesh(mesh));
+
+				// Bones are posed per mesh, so skinned models keep theirs as they are
+				const auto animated = skinned || scene->mNumAnimations > 0 || !job.animFiles.empty();
+				if (!animated)
+					mergeMeshes(cookedMeshes);
+
+				writer.write((std::uint32_t)cookedMeshes.size());
+				for (auto & mesh : cookedMeshes) {
+					if (job.cancelled)
+						return false;
+					optimizeMesh(mesh);
+					generateLods(mesh);
+					writeMesh(writer, mesh, format);
+				}
+
+				// Materials
+				const auto dir = putils::get_directory(f);
+				const putils::string<64> directory(dir);
+
+				std::vector<std::string> textures;
+				std::vector<std::uint32_t> diffuse, specular;
+				Writer materials;
+				for (const auto & mesh : cookedMeshes) {
+					assert(mesh.material < scene->mNumMaterials);
+					const auto material = scene->mMaterials[mesh.material];
+
+					diffuse.clear();
+					specular.clear();
+					loadMaterialTextures(textures, diffuse, directory, material, aiTextureType_DIFFUSE);
+					loadMaterialTextures(textures, specular, directory, material, aiTextureType_SPECULAR);
+					materials.writeArray(diffuse);
+					materials.writeArray(specular);
+
+					aiColor3D color{ 0.f, 0.f, 0.f };
+					material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+					materials.write(color);
+					material->Get(AI_MATKEY_COLOR_SPECULAR, color);
+					materials.write(color);
+				}
+
+				writer.write((std::uint32_t)textures.size());
+				for (const auto & texture : textures)
+					writer.writeString(texture);
+				// Keep `materials`' alignment relative to the whole file
+				writer.buffer.resize((writer.buffer.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+				writer.buffer.insert(writer.buffer.end(), materials.buffer.begin(), materials.buffer.end());
+
+				// Skeleton
+				std::vector<const aiNode *> allNodes;
+				addNode(allNodes, scene->mRootNode);
+				writer.write((std::uint32_t)allNodes.size());
+				for (const auto node : allNodes) {
+					writer.write(toglmWeird(node->mTransformation));
+
+					std::vector<std::uint32_t> children;
+					for (unsigned int i = 0; i < node->mNumChildren; ++i)
+						children.push_back((std::uint32_t)(std::find(allNodes.begin(), allNodes.end(), node->mChildren[i]) - allNodes.begin()));
+					writer.writeArray(children);
+				}
+
+				std::vector<bool> isBone(allNodes.size(), false);
+				writer.write((std::uint32_t)scene->mNumMeshes);
+				for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
+					const auto mesh = scene->mMeshes[i];
+					writer.write((std::uint32_t)mesh->mNumBones);
+					for (unsigned int j = 0; j < mesh->mNumBones; ++j) {
+						const auto aiBone = mesh->mBones[j];
+						const auto node = findNode(allNodes, aiBone->mName.data);
+						if (node != AssImpSkeletonComponent::INVALID_NODE)
+							isBone[node] = true;
+
+						writer.writeString(aiBone->mName.data);
+						writer.write(node);
+						writer.write(toglmWeird(aiBone->mOffsetMatrix));
+					}
+				}
+
+				writer.write(glm::inverse(toglmWeird(scene->mRootNode->mTransformation)));
 
-					AssImpSkeletonComponent::Mesh::Bone bone;
-					bone.node = findNode(allNodes, name);
-					bone.offset = toglmWeird(aiBone->mOffsetMatrix);
-					meshBones.bones.push_back(bone);
+				// Animations
+				std::vector<std::pair<const char *, const aiAnimation *>> anims;
+				for (unsigned int i = 0; i < scene->mNumAnimations; ++i)
+					anims.emplace_back(f, scene->mAnimations[i]);
 
-					meshNames.boneNames.push_back(name);
+				std::vector<std::unique_ptr<Assimp::Importer>> animImporters; // Keep the animations alive until they're written
+				for (const auto & animFile : job.animFiles) {
+					if (job.cancelled)
+						return false;
+
+					animImporters.push_back(std::make_unique<Assimp::Importer>());
+					auto & animImporter = *animImporters.back();
+					animImporter.SetIOHandler(new VFSSystem(opened));
+
+					const auto animScene = animImporter.ReadFile(animFile.c_str(), IMPORT_FLAGS);
+					if (animScene == nullptr || animScene->mRootNode == nullptr) {
+						std::cerr << putils::termcolor::red << "[AssImp] Failed to load " << animFile << ": " << animImporter.GetErrorString() << '\n' << putils::termcolor::reset;
+						continue;
+					}
+
+					for (unsigned int i = 0; i < animScene->mNumAnimations; ++i)
+						anims.emplace_back(animFile.c_str(), animScene->mAnimations[i]);
 				}
-				skeleton.meshes.emplace_back(std::move(meshBones));
-				skeletonNames.meshes.emplace_back(std::move(meshNames));
+
+				writer.write((std::uint32_t)anims.size());
+				for (const auto & [animFile, anim] : anims)
+					writeAnim(writer, animFile, anim, allNodes, isBone);
+
+				// Dependencies
+				std::vector<std::string> dependencies;
+				for (const auto & file : opened)
+					if (file != job.file.c_str() && std::find(job.animFiles.begin(), job.animFiles.end(), file.c_str()) == job.animFiles.end())
+						dependencies.push_back(file);
+
+				Header header;
+				memcpy(header.magic, MAGIC, sizeof(MAGIC));
+				header.version = VERSION;
+				header.vertexFormat = (std::uint32_t)format;
+				header.boneInfoPerVertex = KENGINE_ASSIMP_BONE_INFO_PER_VERTEX;
+				header.sourceHash = sourceHash;
+				header.dependencyHash = hashDependencies(dependencies);
+
+				Writer out;
+				out.write(header);
+				out.write((std::uint32_t)dependencies.size());
+				for (const auto & dependency : dependencies)
+					out.writeString(dependency);
+				// Keep `writer`'s alignment relative to the whole file
+				out.buffer.resize((out.buffer.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+				out.buffer.insert(out.buffer.end(), writer.buffer.begin(), writer.buffer.end());
+
+				cooked = std::move(out.buffer);
+				return true;
 			}
 
-			skeleton.globalInverseTransform = glm::inverse(toglmWeird(scene->mRootNode->mTransformation));
+			static bool readHeader(Reader & reader, Header & header, std::vector<std::string> & dependencies) {
+				if (!reader.read(header) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+					header.vertexFormat > (std::uint32_t)AssImpVertexFormat::Skinned || header.boneInfoPerVertex != KENGINE_ASSIMP_BONE_INFO_PER_VERTEX)
+					return false;
+
+				std::uint32_t dependencyCount;
+				if (!reader.read(dependencyCount))
+					return false;
+				for (std::uint32_t i = 0; i < dependencyCount; ++i) {
+					dependencies.emplace_back();
+					if (!reader.readString(dependencies.back()))
+						return false;
+				}
+				return reader.align();
+			}
 
-			for (unsigned int i = 0; i < scene->mNumAnimations; ++i)
-				addAnim(f, scene->mAnimations[i], skeletonNames, skeleton, animList);
+			// Returns false if `data` was cooked from other sources or settings, including side files that changed since
+			static bool isUpToDate(const void * data, size_t size, std::uint64_t sourceHash) {
+				Reader reader(data, size);
+				Header header;
+				std::vector<std::string> dependencies;
+				return readHeader(reader, header, dependencies) && header.sourceHash == sourceHash && hashDependencies(dependencies) == header.dependencyHash;
+			}
 
-			if (e.has<AnimFilesComponent>()) {
-				const auto & animFiles = e.get<AnimFilesComponent>();
-				model.animImporters.resize(animFiles.files.size());
+			static bool readIndices(Reader & reader, std::vector<size_t> & indices, size_t textureCount) {
+				const std::uint32_t * data;
+				size_t count;
+				if (!reader.view(data, count))
+					return false;
 
-				size_t i = 0;
-				for (const auto & f : animFiles.files) {
-					auto & importer = model.animImporters[i];
+				for (size_t i = 0; i < count; ++i) {
+					if (data[i] >= textureCount)
+						return false;
+					indices.push_back(data[i]);
+				}
+				return true;
+			}
 
-					const auto scene = importer.ReadFile(f.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals /*| aiProcess_OptimizeMeshes*/ | aiProcess_JoinIdenticalVertices);
-					if (scene == nullptr || scene->mRootNode == nullptr) {
-						std::cerr << '\n' << putils::termcolor::red << importer.GetErrorString() << '\n' << putils::termcolor::reset;
-						assert(false);
+			static bool viewVertices(Reader & reader, AssImpVertexFormat format, AssImpModelComponent::Mesh & mesh) {
+				const auto view = [&](auto type) {
+					const decltype(type) * vertices;
+					if (!reader.view(vertices, mesh.nbVertices))
+						return false;
+					mesh.vertices = vertices;
+					return true;
+				};
+
+				switch (format) {
+					case AssImpVertexFormat::Static: return view(AssImpModelComponent::Mesh::StaticVertex{});
+					case AssImpVertexFormat::Skinned: return view(AssImpModelComponent::Mesh::SkinnedVertex{});
+					default: return view(AssImpModelComponent::Mesh::Vertex{});
+				}
+			}
+
+			static bool readColor(Reader & reader, putils::NormalizedColor & color) {
+				aiColor3D c;
+				if (!reader.read(c))
+					return false;
+				color = { c.r, c.g, c.b };
+				return true;
+			}
+
+			// Fills `loaded` from cooked data, whose meshes are used in place. Returns false if it's corrupt. Staleness is checked by `isUpToDate`
+			static bool parse(const void * data, size_t size, LoadedModel & loaded) {
+				auto & model = loaded.model;
+				auto & skeleton = loaded.skeleton;
+				model.meshes.clear();
+				loaded.meshTextures.clear();
+				loaded.textures.clear();
+				loaded.skeletonNames.meshes.clear();
+				skeleton = AssImpSkeletonComponent{};
+				loaded.animList.anims.clear();
+
+				Reader reader(data, size);
+
+				Header header;
+				std::vector<std::string> dependencies; // Checked by `isUpToDate`
+				if (!readHeader(reader, header, dependencies))
+					return false;
+				model.format = (AssImpVertexFormat)header.vertexFormat;
+
+				// Meshes
+				std::uint32_t meshCount;
+				if (!reader.read(meshCount))
+					return false;
+				for (std::uint32_t i = 0; i < meshCount; ++i) {
+					AssImpModelComponent::Mesh mesh;
+					if (!viewVertices(reader, model.format, mesh))
+						return false;
+
+					std::uint32_t indexSize;
+					if (!reader.read(indexSize))
+						return false;
+
+					mesh.indexSize = indexSize;
+					if (indexSize == sizeof(std::uint16_t)) {
+						const std::uint16_t * indices;
+						if (!reader.view(indices, mesh.nbIndices))
+							return false;
+						mesh.indices = indices;
 					}
+					else if (indexSize == sizeof(std::uint32_t)) {
+						const std::uint32_t * indices;
+						if (!reader.view(indices, mesh.nbIndices))
+							return false;
+						mesh.indices = indices;
+					}
+					else
+						return false;
 
-					for (unsigned int i = 0; i < scene->mNumAnimations; ++i)
-						addAnim(f.c_str(), scene->mAnimations[i], skeletonNames, skeleton, animList);
+					if (!reader.view(mesh.lods, mesh.nbLods) || mesh.nbLods == 0)
+						return false;
+					for (size_t j = 0; j < mesh.nbLods; ++j)
+						if (mesh.lods[j].firstIndex > mesh.nbIndices || mesh.lods[j].nbIndices > mesh.nbIndices - mesh.lods[j].firstIndex)
+							return false;
 
-					++i;
+					model.meshes.push_back(mesh);
 				}
+
+				// Materials
+				std::uint32_t textureCount;
+				if (!reader.read(textureCount))
+					return false;
+				for (std::uint32_t i = 0; i < textureCount; ++i) {
+					std::string file;
+					if (!reader.readString(file))
+						return false;
+					LoadedModel::Texture texture;
+					texture.file = file.c_str();
+					loaded.textures.push_back(texture);
+				}
+
+				if (!reader.align())
+					return false;
+
+				for (std::uint32_t i = 0; i < meshCount; ++i) {
+					LoadedModel::MeshTextures meshTextures;
+					if (!readIndices(reader, meshTextures.diffuse, textureCount) || !readIndices(reader, meshTextures.specular, textureCount) ||
+						!readColor(reader, meshTextures.diffuseColor) || !readColor(reader, meshTextures.specularColor))
+						return false;
+					loaded.meshTextures.push_back(std::move(meshTextures));
+				}
+
+				// Skeleton
+				std::uint32_t nodeCount;
+				if (!reader.read(nodeCount) || nodeCount == 0)
+					return false;
+				skeleton.nodes.resize(nodeCount);
+				for (std::uint32_t i = 0; i < nodeCount; ++i) {
+					auto & node = skeleton.nodes[i];
+					if (!reader.read(node.transform) || !reader.readArray(node.children))
+						return false;
+					for (const auto child : node.children)
+						if (child <= i || child >= nodeCount) // Children come after their parent, which also rules out cycles
+							return false;
+				}
+
+				std::uint32_t skeletonMeshCount;
+				if (!reader.read(skeletonMeshCount))
+					return false;
+				for (std::uint32_t i = 0; i < skeletonMeshCount; ++i) {
+					std::uint32_t boneCount;
+					if (!reader.read(boneCount))
+						return false;
+
+					ModelSkeletonComponent::Mesh meshNames;
+					AssImpSkeletonComponent::Mesh meshBones;
+					for (std::uint32_t j = 0; j < boneCount; ++j) {
+						std::string name;
+						AssImpSkeletonComponent::Mesh::Bone bone;
+						if (!reader.readString(name) || !reader.read(bone.node) || !reader.read(bone.offset))
+							return false;
+
+						if (bone.node != AssImpSkeletonComponent::INVALID_NODE) {
+							if (bone.node >= nodeCount)
+								return false;
+
+							auto & nodeBones = skeleton.nodes[bone.node].bones;
+							const auto alreadyAttached = std::find_if(nodeBones.begin(), nodeBones.end(), [i](const auto & pair) { return pair.first == i; }) != nodeBones.end();
+							if (!alreadyAttached) // Only a mesh's first bone for a given node is posed
+								nodeBones.emplace_back(i, j);
+						}
+
+						meshBones.bones.push_back(bone);
+						meshNames.boneNames.push_back(std::move(name));
+					}
+					skeleton.meshes.emplace_back(std::move(meshBones));
+					loaded.skeletonNames.meshes.emplace_back(std::move(meshNames));
+				}
+
+				if (!reader.read(skeleton.globalInverseTransform))
+					return false;
+
+				// Animations
+				std::uint32_t animCount;
+				if (!reader.read(animCount))
+					return false;
+				for (std::uint32_t i = 0; i < animCount; ++i) {
+					AnimListComponent::Anim anim;
+					if (!reader.readString(anim.name) || !reader.read(anim.ticksPerSecond) || !reader.read(anim.totalTime))
+						return false;
+					loaded.animList.anims.push_back(std::move(anim));
+
+					AssImpSkeletonComponent::Animation animation;
+					animation.channels.resize(nodeCount);
+					for (auto & channel : animation.channels)
+						if (!reader.readArray(channel.positions) || !reader.readArray(channel.rotations) || !reader.readArray(channel.scales))
+							return false;
+					skeleton.animations.push_back(std::move(animation));
+				}
+
+				return true;
 			}
+		}
 
+		// Called once the meshes are uploaded: unmaps the cooked model
+		static auto release(Entity::ID id) {
+			return [id] {
+				auto e = g_em->getEntity(id);
+				if (e.has<AssImpModelComponent>())
+					e.detach<AssImpModelComponent>();
+			};
+		}
+
+		// Runs on a loading thread: only touches `job`, never the EntityManager
+		static bool loadFile(LoadJob & job) {
+			const auto f = job.file.c_str();
+			auto & loaded = job.result;
+			auto & model = loaded.model;
+
+			std::uint64_t sourceHash;
+			const bool hasSource = Cache::hashSources(job, sourceHash); // Builds may only ship the cooked model, which is then used as is
+
+			const putils::string<KENGINE_MODEL_STRING_MAX_LENGTH + 8> cacheFile("%s." KENGINE_ASSIMP_CACHE_EXTENSION, f);
+			if (model.file.open(cacheFile.c_str()) && (!hasSource || Cache::isUpToDate(model.file.data(), model.file.size(), sourceHash)) && Cache::parse(model.file.data(), model.file.size(), loaded)) {
 #ifndef KENGINE_NDEBUG
-			std::cout << putils::termcolor::green << "Done\n" << putils::termcolor::reset;
+				std::cout << putils::termcolor::green << "[AssImp] Using cooked " << putils::termcolor::cyan << cacheFile.c_str() << '\n' << putils::termcolor::reset;
 #endif
+			}
+			else {
+				model.file.close();
+
+				if (!hasSource) {
+					std::cerr << putils::termcolor::red << "[AssImp] Failed to read " << f << '\n' << putils::termcolor::reset;
+					return false;
+				}
+
+				std::vector<char> cooked;
+				if (!Cache::cook(job, sourceHash, cooked) || job.cancelled)
+					return false;
+
+				if (MappedFile::write(cacheFile.c_str(), cooked.data(), cooked.size()) && model.file.openLoose(cacheFile.c_str()))
+					cooked.clear();
+				else {
+					std::cerr << putils::termcolor::red << "[AssImp] Failed to write " << cacheFile.c_str() << ", keeping the cooked model in memory\n" << putils::termcolor::reset;
+					model.file.close();
+					model.buffer = std::move(cooked);
+				}
+
+				const auto parsed = model.file.isOpen() ?
+					Cache::parse(model.file.data(), model.file.size(), loaded) :
+					Cache::parse(model.buffer.data(), model.buffer.size(), loaded);
+				assert(parsed);
+				if (!parsed)
+					return false;
+			}
+
 			return true;
 		}
+
+		// Fans the model's textures out to the TextureCache's decoding threads. The last one to complete marks `job` as done
+		static void loadTextures(const std::shared_ptr<LoadJob> & job) {
+			std::vector<size_t> pending;
+			const auto & textures = job->result.textures;
+			for (size_t i = 0; i < textures.size(); ++i)
+				if (AssetHelper::find<TextureModelComponent>(textures[i].file.c_str()) == Entity::INVALID_ID) // Else, already loaded by another model
+					pending.push_back(i);
+
+			if (pending.empty() || job->cancelled) {
+				job->done = true;
+				return;
+			}
+
+			job->pendingTextures = pending.size();
+			for (const auto index : pending)
+				TextureCache::loadAsync(textures[index].file.c_str(), [job, index](const TextureCache::Texture & decoded) {
+					job->result.textures[index].decoded = decoded; // Each callback writes its own element
+					if (--job->pendingTextures == 0)
+						job->done = true;
+				});
+		}
 	}
 
+	static putils::ThreadPool g_loaders(KENGINE_ASSIMP_LOADING_THREADS); // Separate from the EntityManager's, so that its `completeTasks` never waits for a load
+	static std::unordered_map<Entity::ID, std::shared_ptr<AssImp::LoadJob>> g_jobs;
+	static std::mutex g_jobsMutex;
+
+	// declarations
+	static void commitLoadedModels();
+	//
 	static void execute(float deltaTime) {
+		commitLoadedModels();
+
 		for (auto & [e, graphics, skeleton, anim] : g_em->getEntities<GraphicsComponent, SkeletonComponent, AnimationComponent>())
 			g_em->runTask([&] {
 				if (graphics.model == Entity::INVALID_ID)
@@ -538,7 +1396,7 @@ namespace kengine {
 				if (skeleton.meshes.empty())
 					skeleton.meshes.resize(assimp.meshes.size());
 
-				AssImp::updateBoneMats(assimp.rootNode, anim.currentTime * currentAnim.ticksPerSecond, anim.currentAnim, assimp, skeleton, glm::mat4(1.f));
+				AssImp::updateBoneMats(assimp, 0, anim.currentTime * currentAnim.ticksPerSecond, anim.currentAnim, skeleton, glm::mat4(1.f));
 
 				anim.currentTime += deltaTime * anim.speed;
 				anim.currentTime = fmodf(anim.currentTime, currentAnim.totalTime);
@@ -548,26 +1406,166 @@ namespace kengine {
 	}
 
 	static void loadModel(Entity & e) {
-		if (!AssImp::loadFile(e))
+		const auto & file = e.get<ModelComponent>().file;
+		if (!g_importer.IsExtensionSupported(putils::file_extension(file.c_str()).data()))
+			return;
+
+		AssetHelper::add<ModelComponent>(file.c_str(), e.id);
+		AssetHelper::setReloader(e.id, loadModel);
+
+		auto job = std::make_shared<AssImp::LoadJob>();
+		job->id = e.id;
+		job->file = file.c_str();
+		if (e.has<AnimFilesComponent>())
+			job->animFiles = e.get<AnimFilesComponent>().files;
+
+		e += ModelLoadingComponent{};
+		{
+			std::lock_guard<std::mutex> lock(g_jobsMutex);
+			g_jobs[e.id] = job;
+		}
+
+#ifndef KENGINE_NDEBUG
+		std::cout << putils::termcolor::green << "[AssImp] Loading " << putils::termcolor::cyan << job->file.c_str() << putils::termcolor::green << "...\n" << putils::termcolor::reset;
+#endif
+
+		g_loaders.runTask([job] {
+			if (!job->cancelled)
+				job->succeeded = AssImp::loadFile(*job);
+
+			if (job->succeeded)
+				AssImp::loadTextures(job);
+			else
+				job->done = true;
+		});
+	}
+
+	static void onEntityRemoved(Entity & e) {
+		if (!e.has<ModelLoadingComponent>())
 			return;
 
+		std::lock_guard<std::mutex> lock(g_jobsMutex);
+		const auto it = g_jobs.find(e.id);
+		if (it == g_jobs.end())
+			return;
+		it->second->cancelled = true; // The loading thread drops its result
+		g_jobs.erase(it);
+	}
+
+	static Entity::ID getTextureEntity(AssImp::LoadedModel::Texture & texture) {
+		const auto existing = AssetHelper::find<TextureModelComponent>(texture.file.c_str());
+		if (existing != Entity::INVALID_ID) {
+			if (texture.decoded.data != nullptr)
+				TextureCache::release(texture.decoded.data);
+			texture.decoded.data = nullptr;
+			return existing;
+		}
+
+		if (texture.decoded.data == nullptr) // Failed to load
+			return Entity::INVALID_ID;
+
+		return AssetHelper::findOrCreate<TextureModelComponent>(*g_em, texture.file.c_str(), [&](Entity & e) {
+			auto & comp = e.attach<TextureModelComponent>();
+			comp.file = texture.file.c_str();
+
+			TextureDataComponent textureLoader; {
+				textureLoader.textureID = &comp.texture;
+
+				textureLoader.data = texture.decoded.data;
+				textureLoader.width = texture.decoded.width;
+				textureLoader.height = texture.decoded.height;
+				textureLoader.components = 4;
+				textureLoader.levels = texture.decoded.levels;
+
+				textureLoader.free = TextureCache::release;
+			} e += textureLoader;
+
+			texture.decoded.data = nullptr; // Now owned by the TextureDataComponent
+		});
+	}
+
+	static void commitModel(Entity & e, AssImp::LoadedModel & loaded) {
+		std::vector<Entity::ID> textureIDs;
+		for (auto & texture : loaded.textures) {
+			const auto id = getTextureEntity(texture);
+			if (id != Entity::INVALID_ID)
+				AssetHelper::addDependency(e.id, id);
+			textureIDs.push_back(id);
+		}
+
+		const auto addTextures = [&](std::vector<Entity::ID> & ids, const std::vector<size_t> & indices) {
+			for (const auto index : indices)
+				if (textureIDs[index] != Entity::INVALID_ID)
+					ids.push_back(textureIDs[index]);
+		};
+
+		AssImpTexturesModelComponent textures;
+		for (const auto & mesh : loaded.meshTextures) {
+			AssImpTexturesModelComponent::MeshTextures meshTextures;
+			addTextures(meshTextures.diffuse, mesh.diffuse);
+			addTextures(meshTextures.specular, mesh.specular);
+			meshTextures.diffuseColor = mesh.diffuseColor;
+			meshTextures.specularColor = mesh.specularColor;
+			textures.meshes.push_back(std::move(meshTextures));
+		}
+
+		e += std::move(textures);
+		e += std::move(loaded.skeletonNames);
+		e += std::move(loaded.skeleton);
+		e += std::move(loaded.animList);
+		e += AssImpVertexFormatComponent{ loaded.model.format };
+		e += std::move(loaded.model);
+
 		ModelDataComponent modelData;
 
-		auto & model = e.get<AssImp::AssImpModelComponent>();
+		const auto & model = e.get<AssImp::AssImpModelComponent>();
 		for (const auto & mesh : model.meshes) {
 			ModelDataComponent::Mesh meshData;
-			meshData.vertices = { mesh.vertices.size(), sizeof(AssImp::AssImpModelComponent::Mesh::Vertex), mesh.vertices.data() };
-			meshData.indices = { mesh.indices.size(), sizeof(mesh.indices[0]), mesh.indices.data() };
-			meshData.indexType = GL_UNSIGNED_INT;
+			meshData.vertices = { mesh.nbVertices, AssImp::getVertexSize(model.format), mesh.vertices };
+			meshData.indices = { mesh.nbIndices, mesh.indexSize, mesh.indices };
+			meshData.indexType = mesh.indexSize == sizeof(std::uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+			if (mesh.nbLods > 1)
+				for (size_t i = 0; i < mesh.nbLods; ++i)
+					meshData.lods.push_back({ mesh.lods[i].firstIndex, mesh.lods[i].nbIndices });
 			modelData.meshes.push_back(meshData);
 		}
-		
+
 		modelData.free = AssImp::release(e.id);
-		modelData.vertexRegisterFunc = putils::gl::setVertexType<AssImp::AssImpModelComponent::Mesh::Vertex>;
+		modelData.vertexRegisterFunc = AssImp::getVertexRegisterFunc(model.format);
 
 		e += std::move(modelData);
 	}
 
+	// Sync point: attaches the results of completed loads to their model Entities
+	static void commitLoadedModels() {
+		std::vector<std::shared_ptr<AssImp::LoadJob>> completed;
+		{
+			std::lock_guard<std::mutex> lock(g_jobsMutex);
+			for (auto it = g_jobs.begin(); it != g_jobs.end();)
+				if (it->second->done) {
+					completed.push_back(it->second);
+					it = g_jobs.erase(it);
+				}
+				else
+					++it;
+		}
+
+		for (const auto & job : completed) {
+			auto e = g_em->getEntity(job->id);
+			if (!job->succeeded) {
+				e.get<ModelLoadingComponent>().state = ModelLoadingComponent::Failed;
+				continue;
+			}
+
+			commitModel(e, job->result);
+			e.detach<ModelLoadingComponent>();
+
+#ifndef KENGINE_NDEBUG
+			std::cout << putils::termcolor::green << "[AssImp] Loaded " << putils::termcolor::cyan << job->file.c_str() << '\n' << putils::termcolor::reset;
+#endif
+		}
+	}
+
 	static void setModel(Entity & e) {
 		auto & graphics = e.get<GraphicsComponent>();
 
@@ -577,16 +1575,8 @@ namespace kengine {
 		e += AssImpObjectComponent{};
 		e += SkeletonComponent{};
 
-		graphics.model = Entity::INVALID_ID;
-		for (const auto &[e, model] : g_em->getEntities<ModelComponent>())
-			if (model.file == graphics.appearance) {
-				graphics.model = e.id;
-				return;
-			}
-
-		*g_em += [&](Entity & e) {
+		graphics.model = AssetHelper::findOrCreate<ModelComponent>(*g_em, graphics.appearance.c_str(), [&](Entity & e) {
 			e += ModelComponent{ graphics.appearance.c_str() };
-			graphics.model = e.id;
-		};
+		});
 	}
 }
\ No newline at end of file
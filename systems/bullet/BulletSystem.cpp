@@ -287,6 +287,7 @@ namespace kengine {
 				transform.pitch = xRotation;
 				transform.yaw = yRotation;
 				transform.roll = zRotation;
+				transform.markDirty();
 			}
 
 			TransformComponent & transform;
@@ -0,0 +1,295 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "HierarchySystem.hpp"
+#include "EntityManager.hpp"
+
+#include "data/HierarchyComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/GraphicsComponent.hpp"
+#include "data/ModelComponent.hpp"
+#include "data/ModelSkeletonComponent.hpp"
+#include "data/SkeletonComponent.hpp"
+
+#include "functions/Execute.hpp"
+
+#include "helpers/MatrixHelper.hpp"
+
+#ifndef KENGINE_HIERARCHY_NODES_PER_TASK
+# define KENGINE_HIERARCHY_NODES_PER_TASK 256
+#endif
+
+namespace kengine {
+	static EntityManager * g_em;
+
+	// declarations
+	static void execute(float deltaTime);
+	//
+	EntityCreatorFunctor<64> HierarchySystem(EntityManager & em) {
+		return [&](Entity & e) {
+			g_em = &em;
+			e += functions::Execute{ execute };
+		};
+	}
+
+	static constexpr auto NO_PARENT = (size_t)-1;
+	static constexpr auto INPUT_COUNT = 9;
+
+	struct Node {
+		Entity::ID id;
+		size_t parent; // Index in g_nodes, NO_PARENT for roots
+		HierarchyComponent * hierarchy; // nullptr for roots which aren't attached to anything
+		TransformComponent * transform;
+
+		Entity::ID builtParent;
+		HierarchyComponent::string builtBone;
+		bool boneResolved = false;
+		Entity::ID boneModel = Entity::INVALID_ID; // Model `boneResolved` was computed for
+		size_t boneVersion = (size_t)-1; // ModelSkeletonComponent version `boneResolved` was computed for
+		unsigned int meshIndex = 0;
+		unsigned int boneIndex = 0;
+
+		glm::mat4 world{ 1.f };
+		float inputs[INPUT_COUNT];
+		bool dirty = true;
+	};
+
+	// Nodes are stored breadth-first, one contiguous range per tree, so a parent is always processed before its children
+	struct Tree {
+		size_t begin;
+		size_t end;
+	};
+
+	static std::vector<Node> g_nodes;
+	static std::vector<Tree> g_trees;
+	static std::vector<Entity::ID> g_missingTransforms; // Hierarchy members and parents which had no TransformComponent at the last rebuild
+	static size_t g_hierarchyVersion = (size_t)-1;
+
+	static void fillInputs(float (&inputs)[INPUT_COUNT], const TransformComponent & transform) {
+		const auto & box = transform.boundingBox;
+		inputs[0] = box.position.x; inputs[1] = box.position.y; inputs[2] = box.position.z;
+		inputs[3] = box.size.x; inputs[4] = box.size.y; inputs[5] = box.size.z;
+		inputs[6] = transform.yaw; inputs[7] = transform.pitch; inputs[8] = transform.roll;
+	}
+
+	static Node makeNode(Entity::ID id, size_t parent, HierarchyComponent * hierarchy, TransformComponent & transform) {
+		Node node;
+		node.id = id;
+		node.parent = parent;
+		node.hierarchy = hierarchy;
+		node.transform = &transform;
+		node.builtParent = hierarchy != nullptr ? hierarchy->parent : Entity::INVALID_ID;
+		if (hierarchy != nullptr)
+			node.builtBone = hierarchy->bone;
+		std::fill(std::begin(node.inputs), std::end(node.inputs), NAN); // Forces a first update
+		return node;
+	}
+
+	static void rebuild() {
+		g_nodes.clear();
+		g_trees.clear();
+		g_missingTransforms.clear();
+
+		struct Link {
+			Entity::ID parent;
+			Entity::ID child;
+			HierarchyComponent * hierarchy;
+			TransformComponent * transform;
+		};
+		std::vector<Link> links;
+		for (auto & [e, hierarchy] : g_em->getEntities<HierarchyComponent>()) {
+			if (e.has<TransformComponent>())
+				links.push_back({ hierarchy.parent, e.id, &hierarchy, &e.get<TransformComponent>() });
+			else
+				g_missingTransforms.push_back(e.id);
+		}
+
+		// Sorted by parent so each node's children can be found with a binary search
+		std::sort(links.begin(), links.end(), [](const Link & lhs, const Link & rhs) { return lhs.parent < rhs.parent; });
+
+		const auto isChild = [&](Entity::ID id) {
+			const auto e = g_em->getEntity(id);
+			if (!e.has<HierarchyComponent>() || !e.has<TransformComponent>())
+				return false;
+			const auto parent = e.get<HierarchyComponent>().parent;
+			return parent != Entity::INVALID_ID && g_em->getEntity(parent).has<TransformComponent>();
+		};
+
+		const auto addTree = [&](Node && root) {
+			Tree tree;
+			tree.begin = g_nodes.size();
+			g_nodes.push_back(std::move(root));
+
+			for (size_t i = tree.begin; i < g_nodes.size(); ++i) {
+				const auto id = g_nodes[i].id;
+				auto it = std::lower_bound(links.begin(), links.end(), id, [](const Link & link, Entity::ID id) { return link.parent < id; });
+				for (; it != links.end() && it->parent == id; ++it)
+					g_nodes.push_back(makeNode(it->child, i, it->hierarchy, *it->transform));
+			}
+
+			tree.end = g_nodes.size();
+			g_trees.push_back(tree);
+		};
+
+		for (size_t i = 0; i < links.size(); ++i) {
+			const auto & link = links[i];
+			if (!isChild(link.child)) // Parent is invalid or has no transform: treat `local` as world-space
+				addTree(makeNode(link.child, NO_PARENT, link.hierarchy, *link.transform));
+
+			if (i > 0 && links[i - 1].parent == link.parent)
+				continue;
+			if (link.parent == Entity::INVALID_ID || isChild(link.parent))
+				continue;
+
+			auto parent = g_em->getEntity(link.parent);
+			if (parent.has<HierarchyComponent>()) // Already added as a root by its own link
+				continue;
+			if (parent.has<TransformComponent>())
+				addTree(makeNode(link.parent, NO_PARENT, nullptr, parent.get<TransformComponent>()));
+			else
+				g_missingTransforms.push_back(link.parent);
+		}
+		// Entities caught in a cycle are never reached from a root and are left untouched
+	}
+
+	static bool needsRebuild() {
+		const auto hierarchyVersion = g_em->getComponentVersion(Component<HierarchyComponent>::id());
+		if (hierarchyVersion != g_hierarchyVersion) {
+			g_hierarchyVersion = hierarchyVersion;
+			return true;
+		}
+
+		// TransformComponents come and go on Entities outside the hierarchy all the time, so only those of its members are checked
+		for (const auto id : g_missingTransforms)
+			if (g_em->getEntity(id).has<TransformComponent>())
+				return true;
+
+		for (const auto & node : g_nodes) {
+			if (!g_em->getEntity(node.id).has<TransformComponent>())
+				return true;
+			if (node.hierarchy != nullptr && (node.hierarchy->parent != node.builtParent || std::strcmp(node.hierarchy->bone.c_str(), node.builtBone.c_str()) != 0))
+				return true;
+		}
+		return false;
+	}
+
+	static bool resolveBone(Node & node) {
+		const auto parent = g_em->getEntity(node.builtParent);
+		if (!parent.has<GraphicsComponent>())
+			return false;
+
+		const auto model = parent.get<GraphicsComponent>().model;
+		if (model == Entity::INVALID_ID)
+			return false;
+
+		// Found or not, the bone is only looked up again once the model's skeleton has changed
+		const auto version = g_em->getComponentVersion(Component<ModelSkeletonComponent>::id());
+		if (node.boneModel == model && node.boneVersion == version)
+			return node.boneResolved;
+		node.boneModel = model;
+		node.boneVersion = version;
+		node.boneResolved = false;
+
+		const auto modelEntity = g_em->getEntity(model);
+		if (!modelEntity.has<ModelSkeletonComponent>())
+			return false; // Model may not be loaded yet. Attaching its skeleton will change `version`
+
+		const auto & meshes = modelEntity.get<ModelSkeletonComponent>().meshes;
+		for (unsigned int meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+			const auto & names = meshes[meshIndex].boneNames;
+			const auto it = std::find(names.begin(), names.end(), node.builtBone.c_str());
+			if (it != names.end()) {
+				const auto boneIndex = (unsigned int)(it - names.begin());
+				if (boneIndex >= KENGINE_SKELETON_MAX_BONES) // Not posed by the SkeletonComponent
+					return false;
+				node.meshIndex = meshIndex;
+				node.boneIndex = boneIndex;
+				node.boneResolved = true;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Returns false if the bone's information isn't available yet
+	static bool getBoneMatrix(const Node & node, glm::mat4 & out) {
+		const auto parent = g_em->getEntity(node.builtParent);
+		if (!parent.has<SkeletonComponent>())
+			return false;
+
+		const auto & skeleton = parent.get<SkeletonComponent>();
+		if (node.meshIndex >= skeleton.meshes.size() || node.boneIndex >= KENGINE_SKELETON_MAX_BONES)
+			return false;
+
+		const auto modelEntity = g_em->getEntity(parent.get<GraphicsComponent>().model);
+		if (!modelEntity.has<ModelComponent>())
+			return false;
+
+		out = MatrixHelper::getModelMatrix(modelEntity.get<ModelComponent>(), parent.get<TransformComponent>()) * skeleton.meshes[node.meshIndex].boneMatsMeshSpace[node.boneIndex];
+		return true;
+	}
+
+	static void updateNode(Node & node) {
+		const auto & source = node.hierarchy != nullptr ? node.hierarchy->local : *node.transform;
+
+		float inputs[INPUT_COUNT];
+		fillInputs(inputs, source);
+		const bool changed = !std::equal(std::begin(inputs), std::end(inputs), std::begin(node.inputs));
+		if (changed)
+			std::copy(std::begin(inputs), std::end(inputs), std::begin(node.inputs));
+
+		if (node.parent == NO_PARENT) {
+			node.dirty = changed;
+			if (!node.dirty)
+				return;
+			node.world = MatrixHelper::getTransformMatrix(source);
+			if (node.hierarchy != nullptr)
+				*node.transform = source;
+			return;
+		}
+
+		const auto & parent = g_nodes[node.parent];
+		const bool attachedToBone = !node.builtBone.empty();
+
+		node.dirty = changed || parent.dirty || attachedToBone; // Bones may be animated, so can't be skipped
+		if (!node.dirty)
+			return;
+
+		glm::mat4 parentMatrix = parent.world;
+		if (attachedToBone) {
+			glm::mat4 bone;
+			if (!resolveBone(node) || !getBoneMatrix(node, bone)) {
+				node.inputs[0] = NAN; // Try again next frame
+				return;
+			}
+			parentMatrix = bone;
+		}
+
+		node.world = parentMatrix * MatrixHelper::getTransformMatrix(source);
+		MatrixHelper::toTransform(node.world, *node.transform);
+	}
+
+	static void execute(float deltaTime) {
+		if (needsRebuild())
+			rebuild();
+
+		// Trees are independent, so they're grouped into tasks of roughly KENGINE_HIERARCHY_NODES_PER_TASK nodes
+		size_t taskBegin = 0;
+		size_t taskNodes = 0;
+		for (size_t i = 0; i < g_trees.size(); ++i) {
+			taskNodes += g_trees[i].end - g_trees[i].begin;
+			if (taskNodes < KENGINE_HIERARCHY_NODES_PER_TASK && i + 1 < g_trees.size())
+				continue;
+
+			g_em->runTask([begin = g_trees[taskBegin].begin, end = g_trees[i].end] {
+				for (size_t node = begin; node < end; ++node)
+					updateNode(g_nodes[node]);
+			});
+			taskBegin = i + 1;
+			taskNodes = 0;
+		}
+		g_em->completeTasks();
+	}
+}
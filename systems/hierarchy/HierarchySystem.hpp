@@ -0,0 +1,9 @@
+#pragma once
+
+#include "EntityCreator.hpp"
+
+namespace kengine {
+	class EntityManager;
+
+	EntityCreatorFunctor<64> HierarchySystem(EntityManager & em);
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cassert>
+
+#include "AABBTree.hpp"
+
+namespace kengine {
+	static AABB enlarge(const AABB & box) {
+		const auto margin = (box.max - box.min) * KENGINE_AABB_TREE_MARGIN;
+		return { box.min - margin, box.max + margin };
+	}
+
+	int AABBTree::insert(Entity::ID id, const AABB & box) {
+		const auto proxy = allocateNode();
+		auto & node = _nodes[proxy];
+		node.box = enlarge(box);
+		node.id = id;
+		node.height = 0;
+		insertLeaf(proxy);
+		++_proxyCount;
+		return proxy;
+	}
+
+	void AABBTree::remove(int proxy) {
+		assert(proxy >= 0 && proxy < (int)_nodes.size() && _nodes[proxy].isLeaf());
+		removeLeaf(proxy);
+		freeNode(proxy);
+		--_proxyCount;
+	}
+
+	bool AABBTree::move(int proxy, const AABB & box) {
+		assert(proxy >= 0 && proxy < (int)_nodes.size() && _nodes[proxy].isLeaf());
+		if (_nodes[proxy].box.contains(box))
+			return false;
+
+		removeLeaf(proxy);
+		_nodes[proxy].box = enlarge(box);
+		insertLeaf(proxy);
+		return true;
+	}
+
+	int AABBTree::allocateNode() {
+		if (_freeList == NULL_NODE) {
+			_nodes.emplace_back();
+			return (int)_nodes.size() - 1;
+		}
+
+		const auto ret = _freeList;
+		_freeList = _nodes[ret].parent;
+		_nodes[ret] = Node{};
+		return ret;
+	}
+
+	void AABBTree::freeNode(int node) {
+		_nodes[node].parent = _freeList;
+		_nodes[node].height = -1;
+		_freeList = node;
+	}
+
+	// Descends towards the sibling which minimizes the increase in surface area
+	void AABBTree::insertLeaf(int leaf) {
+		if (_root == NULL_NODE) {
+			_root = leaf;
+			_nodes[leaf].parent = NULL_NODE;
+			return;
+		}
+
+		const auto leafBox = _nodes[leaf].box;
+		auto index = _root;
+		while (!_nodes[index].isLeaf()) {
+			const auto & node = _nodes[index];
+			const auto area = node.box.area();
+			const auto combinedArea = node.box.merge(leafBox).area();
+
+			const auto cost = 2.f * combinedArea; // Cost of creating a new parent for this node and the leaf
+			const auto inheritanceCost = 2.f * (combinedArea - area); // Minimum cost of pushing the leaf further down
+
+			const auto childCost = [&](int child) {
+				const auto & childBox = _nodes[child].box;
+				const auto merged = leafBox.merge(childBox).area();
+				if (_nodes[child].isLeaf())
+					return merged + inheritanceCost;
+				return merged - childBox.area() + inheritanceCost;
+			};
+
+			const auto leftCost = childCost(node.left);
+			const auto rightCost = childCost(node.right);
+			if (cost < leftCost && cost < rightCost)
+				break;
+			index = leftCost < rightCost ? node.left : node.right;
+		}
+
+		const auto sibling = index;
+		const auto oldParent = _nodes[sibling].parent;
+		const auto newParent = allocateNode();
+
+		auto & parent = _nodes[newParent];
+		parent.parent = oldParent;
+		parent.box = leafBox.merge(_nodes[sibling].box);
+		parent.height = _nodes[sibling].height + 1;
+		parent.left = sibling;
+		parent.right = leaf;
+
+		if (oldParent == NULL_NODE)
+			_root = newParent;
+		else if (_nodes[oldParent].left == sibling)
+			_nodes[oldParent].left = newParent;
+		else
+			_nodes[oldParent].right = newParent;
+
+		_nodes[sibling].parent = newParent;
+		_nodes[leaf].parent = newParent;
+
+		refit(newParent);
+	}
+
+	void AABBTree::removeLeaf(int leaf) {
+		if (leaf == _root) {
+			_root = NULL_NODE;
+			return;
+		}
+
+		const auto parent = _nodes[leaf].parent;
+		const auto grandParent = _nodes[parent].parent;
+		const auto sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+		freeNode(parent);
+		_nodes[sibling].parent = grandParent;
+
+		if (grandParent == NULL_NODE) {
+			_root = sibling;
+			return;
+		}
+
+		if (_nodes[grandParent].left == parent)
+			_nodes[grandParent].left = sibling;
+		else
+			_nodes[grandParent].right = sibling;
+		refit(grandParent);
+	}
+
+	void AABBTree::refit(int index) {
+		while (index != NULL_NODE) {
+			index = balance(index);
+
+			auto & node = _nodes[index];
+			const auto & left = _nodes[node.left];
+			const auto & right = _nodes[node.right];
+			node.height = 1 + std::max(left.height, right.height);
+			node.box = left.box.merge(right.box);
+
+			index = node.parent;
+		}
+	}
+
+	// Rotates the taller child up if the subtree rooted at `iA` is unbalanced. Returns the subtree's new root
+	int AABBTree::balance(int iA) {
+		auto & a = _nodes[iA];
+		if (a.isLeaf() || a.height < 2)
+			return iA;
+
+		const auto iB = a.left;
+		const auto iC = a.right;
+		auto & b = _nodes[iB];
+		auto & c = _nodes[iC];
+
+		const auto replaceInParent = [&](int oldChild, int newChild) {
+			const auto parent = _nodes[newChild].parent;
+			if (parent == NULL_NODE)
+				_root = newChild;
+			else if (_nodes[parent].left == oldChild)
+				_nodes[parent].left = newChild;
+			else
+				_nodes[parent].right = newChild;
+		};
+
+		const auto diff = c.height - b.height;
+
+		if (diff > 1) { // Rotate C up
+			const auto iF = c.left;
+			const auto iG = c.right;
+			auto & f = _nodes[iF];
+			auto & g = _nodes[iG];
+
+			c.left = iA;
+			c.parent = a.parent;
+			a.parent = iC;
+			replaceInParent(iA, iC);
+
+			if (f.height > g.height) {
+				c.right = iF;
+				a.right = iG;
+				g.parent = iA;
+				a.box = b.box.merge(g.box);
+				c.box = a.box.merge(f.box);
+				a.height = 1 + std::max(b.height, g.height);
+				c.height = 1 + std::max(a.height, f.height);
+			}
+			else {
+				c.right = iG;
+				a.right = iF;
+				f.parent = iA;
+				a.box = b.box.merge(f.box);
+				c.box = a.box.merge(g.box);
+				a.height = 1 + std::max(b.height, f.height);
+				c.height = 1 + std::max(a.height, g.height);
+			}
+			return iC;
+		}
+
+		if (diff < -1) { // Rotate B up
+			const auto iD = b.left;
+			const auto iE = b.right;
+			auto & d = _nodes[iD];
+			auto & e = _nodes[iE];
+
+			b.left = iA;
+			b.parent = a.parent;
+			a.parent = iB;
+			replaceInParent(iA, iB);
+
+			if (d.height > e.height) {
+				b.right = iD;
+				a.left = iE;
+				e.parent = iA;
+				a.box = c.box.merge(e.box);
+				b.box = a.box.merge(d.box);
+				a.height = 1 + std::max(c.height, e.height);
+				b.height = 1 + std::max(a.height, d.height);
+			}
+			else {
+				b.right = iE;
+				a.left = iD;
+				d.parent = iA;
+				a.box = c.box.merge(d.box);
+				b.box = a.box.merge(e.box);
+				a.height = 1 + std::max(c.height, d.height);
+				b.height = 1 + std::max(a.height, e.height);
+			}
+			return iB;
+		}
+
+		return iA;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Entity.hpp"
+
+#ifndef KENGINE_AABB_TREE_MARGIN
+# define KENGINE_AABB_TREE_MARGIN .1f // Fraction of a box's size by which it is enlarged when stored
+#endif
+
+namespace kengine {
+	struct AABB {
+		glm::vec3 min;
+		glm::vec3 max;
+
+		bool contains(const AABB & other) const {
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+		}
+
+		AABB merge(const AABB & other) const { return { glm::min(min, other.min), glm::max(max, other.max) }; }
+
+		float area() const {
+			const auto d = max - min;
+			return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+	};
+
+	enum class CullResult {
+		Outside,
+		Intersect,
+		Inside
+	};
+
+	// Dynamic bounding volume hierarchy. Boxes are stored enlarged, so that small movements don't require updating the tree
+	class AABBTree {
+	public:
+		static constexpr int NULL_NODE = -1;
+
+		int insert(Entity::ID id, const AABB & box);
+		void remove(int proxy);
+		bool move(int proxy, const AABB & box); // Returns false if the stored box still contains `box`
+
+		// test: CullResult(const AABB &), func: void(Entity::ID)
+		// Subtrees fully inside the volume are accepted without testing their children
+		// Returns the number of boxes tested
+		template<typename Test, typename Func>
+		size_t query(Test && test, Func && func) const;
+
+		size_t getProxyCount() const { return _proxyCount; }
+		int getHeight() const { return _root == NULL_NODE ? 0 : _nodes[_root].height; }
+
+	private:
+		struct Node {
+			AABB box;
+			int parent = NULL_NODE; // Next free node when not in use
+			int left = NULL_NODE;
+			int right = NULL_NODE;
+			int height = 0; // -1 when not in use
+			Entity::ID id = Entity::INVALID_ID;
+
+			bool isLeaf() const { return left == NULL_NODE; }
+		};
+
+		int allocateNode();
+		void freeNode(int node);
+		void insertLeaf(int leaf);
+		void removeLeaf(int leaf);
+		void refit(int node);
+		int balance(int node);
+
+		template<typename Func>
+		void acceptSubtree(int node, std::vector<int> & stack, Func && func) const;
+
+	private:
+		std::vector<Node> _nodes;
+		int _root = NULL_NODE;
+		int _freeList = NULL_NODE;
+		size_t _proxyCount = 0;
+	};
+
+	template<typename Func>
+	void AABBTree::acceptSubtree(int node, std::vector<int> & stack, Func && func) const {
+		const auto base = stack.size();
+		stack.push_back(node);
+		while (stack.size() > base) {
+			const auto & current = _nodes[stack.back()];
+			stack.pop_back();
+			if (current.isLeaf())
+				func(current.id);
+			else {
+				stack.push_back(current.left);
+				stack.push_back(current.right);
+			}
+		}
+	}
+
+	template<typename Test, typename Func>
+	size_t AABBTree::query(Test && test, Func && func) const {
+		if (_root == NULL_NODE)
+			return 0;
+
+		thread_local std::vector<int> stack;
+		stack.clear();
+		stack.push_back(_root);
+
+		size_t tested = 0;
+		while (!stack.empty()) {
+			const auto index = stack.back();
+			stack.pop_back();
+			const auto & node = _nodes[index];
+
+			++tested;
+			const auto result = test(node.box);
+			if (result == CullResult::Outside)
+				continue;
+
+			if (node.isLeaf())
+				func(node.id);
+			else if (result == CullResult::Inside)
+				acceptSubtree(index, stack, func);
+			else {
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+
+		return tested;
+	}
+}
@@ -6,6 +6,14 @@
 #include "data/ImGuiToolComponent.hpp"
 #include "data/NameComponent.hpp"
 #include "functions/InitGBuffer.hpp"
+#include "Culling.hpp"
+#include "ShadowCache.hpp"
+#include "Instancing.hpp"
+#include "LevelOfDetail.hpp"
+#include "RenderQueue.hpp"
+#include "Residency.hpp"
+#include "TextureStreaming.hpp"
+#include "Uploader.hpp"
 
 namespace kengine {
 	namespace Controllers {
@@ -87,5 +95,64 @@ namespace kengine {
 				});
 			};
 		}
+
+		static auto CullingDebugger(EntityManager & em) {
+			return [&](Entity & e) {
+				e += NameComponent{ "Culling debugger" };
+
+				auto & tool = e.attach<ImGuiToolComponent>();
+				tool.enabled = false;
+
+				e += ImGuiComponent([&] {
+					if (!tool.enabled)
+						return;
+
+					if (ImGui::Begin("Culling", &tool.enabled)) {
+						const auto & stats = Culling::getStats();
+						ImGui::Text("Tracked entities: %zu", stats.proxies);
+						ImGui::Text("Tree height: %d", stats.treeHeight);
+						ImGui::Text("Cameras: %zu", stats.cameras);
+						ImGui::Text("Nodes tested: %zu", stats.nodesTested);
+						ImGui::Text("Visible: %zu", stats.visible);
+						ImGui::Text("Culled: %zu", stats.culled);
+						ImGui::Separator();
+						ImGui::Text("Shadow caster queries: %zu (%zu cached)", stats.casterQueries, stats.casterCacheHits);
+						ImGui::Text("Shadow casters: %zu", stats.casters);
+						ImGui::Separator();
+						const auto & cache = ShadowCache::getStats();
+						ImGui::Text("Shadow map updates: %zu", cache.updates);
+						ImGui::Text("Shadow map cache hits: %zu", cache.hits);
+						ImGui::Text("Shadow map updates delayed: %zu", cache.delayed);
+						ImGui::Separator();
+						const auto & instancing = Instancing::getStats();
+						ImGui::Text("Instanced draws: %zu", instancing.batches);
+						ImGui::Text("Instances: %zu", instancing.instances);
+						ImGui::Separator();
+						const auto & queue = RenderQueue::getStats();
+						ImGui::Text("Sorted draws: %zu", queue.draws);
+						ImGui::Text("Texture binds: %zu", queue.textureBinds);
+						ImGui::Text("Vertex array binds: %zu", queue.vertexArrayBinds);
+						ImGui::Text("Elided binds: %zu", queue.elidedBinds);
+						ImGui::Separator();
+						const auto & uploads = Uploader::getStats();
+						ImGui::Text("Pending uploads: %zu", uploads.pending);
+						ImGui::Text("Bytes uploaded: %zu", uploads.bytes);
+						ImGui::Separator();
+						const auto & residency = Residency::getStats();
+						ImGui::Text("Resident assets: %zu (%zu / %zu bytes)", residency.resident, residency.bytes, residency.budget);
+						ImGui::Text("Evicted assets: %zu", residency.evicted);
+						ImGui::Separator();
+						const auto & streaming = TextureStreaming::getStats();
+						ImGui::Text("Streamed textures: %zu (%zu pending)", streaming.textures, streaming.pending);
+						ImGui::Text("Streamed texture bytes: %zu / %zu (%zu wanted)", streaming.bytes, streaming.budget, streaming.wanted);
+						ImGui::Separator();
+						const auto & lod = LevelOfDetail::getStats();
+						ImGui::Text("Simplified entities: %zu / %zu (%zu cameras)", lod.simplified, lod.entities, lod.cameras);
+						ImGui::Text("Level of detail switches: %zu", lod.switches);
+					}
+					ImGui::End();
+				});
+			};
+		}
 	}
 }
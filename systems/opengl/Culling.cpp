@@ -0,0 +1,251 @@
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <memory>
+#include <iterator>
+
+#include "Culling.hpp"
+#include "EntityManager.hpp"
+
+#include "data/GraphicsComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/WorldMatrixComponent.hpp"
+#include "data/OpenGLModelComponent.hpp"
+#include "data/SpriteComponent.hpp"
+#include "data/SkeletonComponent.hpp"
+
+namespace kengine::Culling {
+	static AABBTree g_tree;
+	static std::vector<int> g_proxies; // Indexed by Entity::ID
+	static std::vector<size_t> g_lastSeen; // Frame in which each Entity was last found
+	static std::vector<Entity::ID> g_tracked;
+	static std::vector<size_t> g_lastChange; // Frame in which each Entity last moved
+	static std::vector<size_t> g_worldVersions; // Last WorldMatrixComponent::version seen for each Entity
+	static std::vector<AABB> g_boxes; // Exact boxes, for Entities without a WorldMatrixComponent
+	static size_t g_frame = 0;
+
+	static std::vector<size_t> g_visibleStamp; // Camera for which each Entity was last found visible
+	static size_t g_camera = 0;
+	static std::vector<Entity::ID> g_visible;
+
+	struct CasterList {
+		float key[16]; // Light-space matrix, or position and radius
+		size_t keySize;
+		std::vector<Entity::ID> casters;
+	};
+	static std::vector<std::unique_ptr<CasterList>> g_casterLists; // Allocations are kept across frames
+	static size_t g_casterListCount = 0;
+
+	static Stats g_stats;
+
+	Frustum Frustum::fromMatrix(const glm::mat4 & m) {
+		Frustum ret;
+
+		const auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+		const glm::vec4 planes[] = {
+			row(3) + row(0), row(3) - row(0), // Left, right
+			row(3) + row(1), row(3) - row(1), // Bottom, top
+			row(3) + row(2), row(3) - row(2) // Near, far
+		};
+
+		for (int i = 0; i < 8; ++i) {
+			if (i < 6) {
+				ret.nx[i] = planes[i].x;
+				ret.ny[i] = planes[i].y;
+				ret.nz[i] = planes[i].z;
+				ret.d[i] = planes[i].w;
+			}
+			else { // Padding: every box is inside
+				ret.nx[i] = ret.ny[i] = ret.nz[i] = 0.f;
+				ret.d[i] = 1.f;
+			}
+		}
+
+		return ret;
+	}
+
+	CullResult Frustum::test(const AABB & box) const {
+		const auto c = (box.min + box.max) * .5f;
+		const auto e = (box.max - box.min) * .5f;
+
+		float dist[8];
+		float radius[8];
+		for (int i = 0; i < 8; ++i) {
+			dist[i] = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + d[i];
+			radius[i] = std::abs(nx[i]) * e.x + std::abs(ny[i]) * e.y + std::abs(nz[i]) * e.z;
+		}
+
+		bool outside = false;
+		bool inside = true;
+		for (int i = 0; i < 8; ++i) {
+			outside |= dist[i] < -radius[i];
+			inside &= dist[i] >= radius[i];
+		}
+
+		if (outside)
+			return CullResult::Outside;
+		return inside ? CullResult::Inside : CullResult::Intersect;
+	}
+
+	static glm::vec3 toVec(const putils::Point3f & p) { return { p.x, p.y, p.z }; }
+
+	static AABB transformBox(const AABB & local, const glm::mat4 & m) {
+		const auto c = (local.min + local.max) * .5f;
+		const auto e = (local.max - local.min) * .5f;
+
+		const glm::vec3 worldCentre(m * glm::vec4(c, 1.f));
+		glm::vec3 worldExtent;
+		for (int i = 0; i < 3; ++i)
+			worldExtent[i] = std::abs(m[0][i]) * e.x + std::abs(m[1][i]) * e.y + std::abs(m[2][i]) * e.z;
+
+		return { worldCentre - worldExtent, worldCentre + worldExtent };
+	}
+
+	static AABB getBox(EntityManager & em, const Entity & e, const GraphicsComponent & graphics, const TransformComponent & transform) {
+		if (graphics.model != Entity::INVALID_ID && e.has<WorldMatrixComponent>()) {
+			const auto & world = e.get<WorldMatrixComponent>();
+			const auto model = em.getEntity(graphics.model);
+			if (world.modelEntity == graphics.model && model.has<OpenGLModelComponent>()) {
+				const auto & box = model.get<OpenGLModelComponent>().boundingBox;
+				const auto min = toVec(box.position);
+				return transformBox({ min, min + toVec(box.size) }, world.model);
+			}
+		}
+
+		// Anything else drawn from its TransformComponent (such as 3D sprites) is assumed to fit in a sphere of radius `size`
+		const auto centre = toVec(transform.boundingBox.position);
+		const auto radius = glm::length(toVec(transform.boundingBox.size));
+		return { centre - radius, centre + radius };
+	}
+
+	void update(EntityManager & em) {
+		++g_frame;
+		g_stats = Stats{};
+		g_casterListCount = 0;
+
+		for (const auto & [e, graphics, transform, no2D] : em.getEntities<GraphicsComponent, TransformComponent, no<SpriteComponent2D>>()) {
+			if (e.id >= g_proxies.size()) {
+				g_proxies.resize(e.id + 1, AABBTree::NULL_NODE);
+				g_lastSeen.resize(e.id + 1, 0);
+				g_visibleStamp.resize(e.id + 1, 0);
+				g_lastChange.resize(e.id + 1, 0);
+				g_worldVersions.resize(e.id + 1, 0);
+				g_boxes.resize(e.id + 1);
+			}
+
+			g_lastSeen[e.id] = g_frame;
+			const auto box = getBox(em, e, graphics, transform);
+
+			auto & proxy = g_proxies[e.id];
+			bool changed = e.has<SkeletonComponent>(); // May be animated
+			if (e.has<WorldMatrixComponent>()) {
+				const auto version = e.get<WorldMatrixComponent>().version;
+				changed |= version != g_worldVersions[e.id];
+				g_worldVersions[e.id] = version;
+			}
+			else
+				changed |= box.min != g_boxes[e.id].min || box.max != g_boxes[e.id].max;
+			g_boxes[e.id] = box;
+
+			if (proxy == AABBTree::NULL_NODE) {
+				proxy = g_tree.insert(e.id, box);
+				g_tracked.push_back(e.id);
+				changed = true;
+			}
+			else
+				g_tree.move(proxy, box);
+
+			if (changed)
+				g_lastChange[e.id] = g_frame;
+		}
+
+		// Forget Entities that were removed or are no longer drawn
+		g_tracked.erase(std::remove_if(g_tracked.begin(), g_tracked.end(), [](Entity::ID id) {
+			if (g_lastSeen[id] == g_frame)
+				return false;
+			g_tree.remove(g_proxies[id]);
+			g_proxies[id] = AABBTree::NULL_NODE;
+			return true;
+		}), g_tracked.end());
+
+		g_stats.proxies = g_tree.getProxyCount();
+		g_stats.treeHeight = g_tree.getHeight();
+	}
+
+	void setCamera(const glm::mat4 & viewProj) {
+		++g_camera;
+		g_visible.clear();
+
+		const auto frustum = Frustum::fromMatrix(viewProj);
+		const auto tested = g_tree.query(
+			[&](const AABB & box) { return frustum.test(box); },
+			[](Entity::ID id) {
+				g_visibleStamp[id] = g_camera;
+				g_visible.push_back(id);
+			}
+		);
+
+		++g_stats.cameras;
+		g_stats.nodesTested += tested;
+		g_stats.visible += g_visible.size();
+		g_stats.culled += g_stats.proxies - g_visible.size();
+	}
+
+	template<typename Test>
+	static const std::vector<Entity::ID> & queryCasters(const float * key, size_t keySize, Test && test) {
+		++g_stats.casterQueries;
+
+		for (size_t i = 0; i < g_casterListCount; ++i) {
+			const auto & list = *g_casterLists[i];
+			if (list.keySize == keySize && std::equal(key, key + keySize, list.key)) {
+				++g_stats.casterCacheHits;
+				return list.casters;
+			}
+		}
+
+		if (g_casterListCount == g_casterLists.size())
+			g_casterLists.push_back(std::make_unique<CasterList>());
+		auto & list = *g_casterLists[g_casterListCount++];
+		std::copy(key, key + keySize, list.key);
+		list.keySize = keySize;
+		list.casters.clear();
+
+		g_tree.query(test, [&](Entity::ID id) { list.casters.push_back(id); });
+		g_stats.casters += list.casters.size();
+		return list.casters;
+	}
+
+	const std::vector<Entity::ID> & getCasters(const glm::mat4 & lightSpaceMatrix) {
+		const auto frustum = Frustum::fromMatrix(lightSpaceMatrix);
+		return queryCasters(&lightSpaceMatrix[0][0], 16, [&](const AABB & box) { return frustum.test(box); });
+	}
+
+	const std::vector<Entity::ID> & getCasters(const glm::vec3 & pos, float radius) {
+		const float key[] = { pos.x, pos.y, pos.z, radius };
+		return queryCasters(key, std::size(key), [&](const AABB & box) {
+			const auto closest = glm::clamp(pos, box.min, box.max);
+			const auto toClosest = closest - pos;
+			if (glm::dot(toClosest, toClosest) > radius * radius)
+				return CullResult::Outside;
+
+			const auto toFarthest = glm::max(glm::abs(box.min - pos), glm::abs(box.max - pos));
+			return glm::dot(toFarthest, toFarthest) <= radius * radius ? CullResult::Inside : CullResult::Intersect;
+		});
+	}
+
+	bool isVisible(Entity::ID id) {
+		if (id >= g_proxies.size() || g_proxies[id] == AABBTree::NULL_NODE)
+			return true;
+		return g_visibleStamp[id] == g_camera;
+	}
+
+	size_t getLastChange(Entity::ID id) {
+		if (id >= g_lastChange.size())
+			return 0;
+		return g_lastChange[id];
+	}
+
+	const std::vector<Entity::ID> & getVisibleEntities() { return g_visible; }
+	const AABBTree & getTree() { return g_tree; }
+	const Stats & getStats() { return g_stats; }
+}
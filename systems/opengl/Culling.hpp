@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AABBTree.hpp"
+
+namespace kengine {
+	class EntityManager;
+
+	namespace Culling {
+		struct Frustum {
+			// Planes are stored as a structure of arrays, padded to 8 so the tests vectorize
+			alignas(32) float nx[8];
+			alignas(32) float ny[8];
+			alignas(32) float nz[8];
+			alignas(32) float d[8];
+
+			static Frustum fromMatrix(const glm::mat4 & viewProj);
+			CullResult test(const AABB & box) const;
+		};
+
+		struct Stats {
+			size_t cameras = 0;
+			size_t proxies = 0;
+			size_t nodesTested = 0; // Summed over all cameras
+			size_t visible = 0; // Summed over all cameras
+			size_t culled = 0; // Summed over all cameras
+			int treeHeight = 0;
+
+			size_t casterQueries = 0;
+			size_t casterCacheHits = 0;
+			size_t casters = 0; // Summed over all caster queries
+		};
+
+		// Called once per frame by the OpenGLSystem, after WorldMatrixComponents have been updated
+		void update(EntityManager & em);
+
+		// Computes the visible set for the camera about to be rendered
+		void setCamera(const glm::mat4 & viewProj);
+
+		// Entities that aren't tracked (e.g. 2D sprites, debug elements) are always considered visible
+		bool isVisible(Entity::ID id);
+		const std::vector<Entity::ID> & getVisibleEntities();
+
+		// Entities inside a light's volume. Results are cached for the rest of the frame, so all shadow shaders share them
+		const std::vector<Entity::ID> & getCasters(const glm::mat4 & lightSpaceMatrix);
+		const std::vector<Entity::ID> & getCasters(const glm::vec3 & pos, float radius);
+
+		// Frame in which an Entity last moved (skinned Entities are considered to move every frame)
+		size_t getLastChange(Entity::ID id);
+
+		const AABBTree & getTree();
+		const Stats & getStats();
+	}
+}
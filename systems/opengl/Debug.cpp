@@ -3,8 +3,11 @@
 
 #include "data/DebugGraphicsComponent.hpp"
 #include "data/TransformComponent.hpp"
+#include "data/ModelLoadingComponent.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
+#include "systems/opengl/Culling.hpp"
 #include "shaders/ApplyTransparencySrc.hpp"
 
 static const char * vert = R"(
@@ -110,5 +113,18 @@ namespace kengine::Shaders {
 			else
 				assert(!"Unsupported DebugGraphicsComponent type"); // Unsupported type
 		}
+
+		// Placeholders for Entities whose model is still being loaded
+		for (const auto & drawable : RenderSnapshot::get().drawables) {
+			if (drawable.model == Entity::INVALID_ID || !Culling::isVisible(drawable.entity.id))
+				continue;
+			if (!_em.getEntity(drawable.model).has<ModelLoadingComponent>())
+				continue;
+
+			_color = drawable.color;
+			_entityID = (float)drawable.entity.id;
+			_model = drawable.world;
+			ShaderHelper::shapes::drawCube();
+		}
 	}
 }
\ No newline at end of file
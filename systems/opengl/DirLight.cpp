@@ -10,6 +10,8 @@
 #include "systems/opengl/ShaderHelper.hpp"
 #include "shaders/QuadSrc.hpp"
 #include "shaders/ShadowMapShader.hpp"
+#include "ShadowCache.hpp"
+#include "Culling.hpp"
 
 namespace kengine {
 	static bool DEBUG_CSM = false;
@@ -41,6 +43,21 @@ namespace kengine::Shaders {
 			_shadowMap[i] = _shadowMapTextureID + i;
 	}
 
+	static bool needsShadowUpdate(Entity & e, const DirLightComponent & light, const putils::gl::Program::Parameters & params) {
+		if (!e.has<CSMComponent>())
+			ShadowCache::invalidate(e);
+
+		ShadowCache::Hasher lightHash;
+		ShadowCache::Hasher casterHash;
+		lightHash.add(&light.shadowMapSize, sizeof(light.shadowMapSize));
+		for (size_t i = 0; i < KENGINE_CSM_COUNT; ++i) {
+			const auto lightSpaceMatrix = LightHelper::getCSMLightSpaceMatrix(light, params, i);
+			lightHash.add(lightSpaceMatrix);
+			casterHash.addCasters(Culling::getCasters(lightSpaceMatrix));
+		}
+		return ShadowCache::needsUpdate(e, lightHash.get(), casterHash.get());
+	}
+
 	void DirLight::run(const Parameters & params) {
 		ShaderHelper::Enable __b(GL_BLEND);
 		glBlendEquation(GL_FUNC_ADD);
@@ -58,7 +75,7 @@ namespace kengine::Shaders {
 		for (auto &[e, light] : _em.getEntities<DirLightComponent>()) {
 			const putils::Point3f pos = { params.camPos.x, params.camPos.y, params.camPos.z };
 
-			if (light.castShadows) {
+			if (light.castShadows && needsShadowUpdate(e, light, params)) {
 				if (e.has<CSMComponent>()) {
 					const auto & depthMap = e.get<CSMComponent>();
 					ShaderHelper::BindFramebuffer b(depthMap.fbo);
@@ -0,0 +1,125 @@
+#include <cstddef>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Instancing.hpp"
+#include "LevelOfDetail.hpp"
+#include "EntityManager.hpp"
+
+#include "data/ModelComponent.hpp"
+
+namespace kengine::Instancing {
+	static GLuint g_buffer = 0;
+	static size_t g_capacity = 0; // In bytes
+	static size_t g_count = 0; // Instances in the last upload
+	static std::unordered_map<GLuint, size_t> g_vaos; // First instance each VAO's instance attributes point to
+	static Stats g_stats;
+
+	bool Batcher::add(EntityManager & em, const RenderSnapshot::Drawable & drawable, size_t lod) {
+		if (drawable.model == Entity::INVALID_ID)
+			return false;
+
+		const auto & modelInfoEntity = em.getEntity(drawable.model);
+		if (!modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<ModelComponent>())
+			return false;
+
+		add(drawable.model, InstanceData{ drawable.world, drawable.color, (float)drawable.entity.id }, lod);
+		return true;
+	}
+
+	void Batcher::add(Entity::ID model, const InstanceData & instance, size_t lod) {
+		auto & lods = _batches[model];
+		if (lods.size() <= lod)
+			lods.resize(lod + 1);
+		lods[lod].push_back(instance);
+	}
+
+	void Batcher::merge(const Batcher & other) {
+		for (const auto & [model, otherLods] : other._batches) {
+			auto & lods = _batches[model];
+			if (lods.size() < otherLods.size())
+				lods.resize(otherLods.size());
+			for (size_t lod = 0; lod < otherLods.size(); ++lod)
+				lods[lod].insert(lods[lod].end(), otherLods[lod].begin(), otherLods[lod].end());
+		}
+	}
+
+	void Batcher::clear() {
+		for (auto & [model, lods] : _batches)
+			for (auto & instances : lods)
+				instances.clear();
+	}
+
+	static void reserve(size_t size) {
+		if (g_buffer == 0)
+			glGenBuffers(1, &g_buffer);
+
+		glBindBuffer(GL_ARRAY_BUFFER, g_buffer);
+		// Never left empty, as meshes drawn without instancing still have the instance attributes enabled
+		g_capacity = std::max(g_capacity, std::max(size, sizeof(InstanceData)));
+		glBufferData(GL_ARRAY_BUFFER, g_capacity, nullptr, GL_STREAM_DRAW); // Orphans the previous storage
+	}
+
+	// Points the bound VAO's instance attributes to g_buffer, starting at `firstInstance`
+	static void setupAttributes(GLuint vao, size_t firstInstance) {
+		const auto it = g_vaos.find(vao);
+		if (it != g_vaos.end() && it->second == firstInstance)
+			return;
+		g_vaos[vao] = firstInstance;
+
+		glBindBuffer(GL_ARRAY_BUFFER, g_buffer);
+		const auto base = firstInstance * sizeof(InstanceData);
+
+		for (GLuint i = 0; i < 4; ++i) {
+			const auto location = MODEL_LOCATION + i;
+			glEnableVertexAttribArray(location);
+			glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void *)(base + offsetof(InstanceData, model) + i * sizeof(glm::vec4)));
+			glVertexAttribDivisor(location, 1);
+		}
+
+		glEnableVertexAttribArray(COLOR_LOCATION);
+		glVertexAttribPointer(COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void *)(base + offsetof(InstanceData, color)));
+		glVertexAttribDivisor(COLOR_LOCATION, 1);
+
+		glEnableVertexAttribArray(ENTITY_ID_LOCATION);
+		glVertexAttribPointer(ENTITY_ID_LOCATION, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void *)(base + offsetof(InstanceData, entityID)));
+		glVertexAttribDivisor(ENTITY_ID_LOCATION, 1);
+	}
+
+	void beginFrame() {
+		g_stats = Stats{};
+	}
+
+	void upload(const std::vector<InstanceData> & instances) {
+		const auto size = instances.size() * sizeof(InstanceData);
+		reserve(size);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances.data());
+		g_count = instances.size();
+	}
+
+	void drawMesh(const OpenGLModelComponent::Mesh & mesh, size_t lod) {
+		glBindVertexArray(mesh.vertexArrayObject);
+		drawInstances(mesh, 0, g_count, lod);
+	}
+
+	void drawInstances(const OpenGLModelComponent::Mesh & mesh, size_t firstInstance, size_t count, size_t lod) {
+		setupAttributes(mesh.vertexArrayObject, firstInstance);
+		const auto range = LevelOfDetail::getRange(mesh, lod);
+		glDrawElementsInstanced(GL_TRIANGLES, range.count, mesh.indexType, range.offset, (GLsizei)count);
+
+		++g_stats.batches;
+		g_stats.instances += count;
+	}
+
+	void drawModel(const OpenGLModelComponent & openGL, const std::vector<InstanceData> & instances, size_t lod) {
+		upload(instances);
+		for (const auto & mesh : openGL.meshes)
+			drawMesh(mesh, lod);
+	}
+
+	void forget(GLuint vertexArrayObject) {
+		g_vaos.erase(vertexArrayObject);
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
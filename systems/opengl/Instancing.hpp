@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "Entity.hpp"
+#include "Color.hpp"
+
+#include "data/OpenGLModelComponent.hpp"
+#include "RenderSnapshot.hpp"
+
+namespace kengine {
+	class EntityManager;
+
+	namespace Instancing {
+		// Per-instance vertex attributes. Shaders read them when their `instanced` uniform is set:
+		//	layout (location = 5) in mat4 instanceModel;
+		//	layout (location = 9) in vec4 instanceColor;
+		//	layout (location = 10) in float instanceEntityID;
+		struct InstanceData {
+			glm::mat4 model;
+			putils::NormalizedColor color;
+			float entityID = 0.f;
+		};
+
+		static constexpr GLuint MODEL_LOCATION = 5;
+		static constexpr GLuint COLOR_LOCATION = 9;
+		static constexpr GLuint ENTITY_ID_LOCATION = 10;
+
+		// Groups instances by model Entity and level of detail. Storage is kept across frames to avoid reallocations
+		class Batcher {
+		public:
+			// Returns false if `drawable.model` isn't ready to be drawn
+			bool add(EntityManager & em, const RenderSnapshot::Drawable & drawable, size_t lod = 0);
+			void add(Entity::ID model, const InstanceData & instance, size_t lod = 0);
+			// Appends all of `other`'s instances, e.g. to gather batches built by different tasks
+			void merge(const Batcher & other);
+
+			// Func: void(Entity::ID model, size_t lod, const std::vector<InstanceData> & instances)
+			template<typename Func>
+			void forEach(Func && func) const {
+				for (const auto & [model, lods] : _batches)
+					for (size_t lod = 0; lod < lods.size(); ++lod)
+						if (!lods[lod].empty())
+							func(model, lod, lods[lod]);
+			}
+
+			void clear();
+
+		private:
+			std::unordered_map<Entity::ID, std::vector<std::vector<InstanceData>>> _batches; // Instances of each level of detail
+		};
+
+		struct Stats {
+			size_t batches = 0; // Instanced draw calls
+			size_t instances = 0; // Summed over all instanced draw calls
+		};
+
+		// Called once per frame by the OpenGLSystem
+		void beginFrame();
+
+		// Uploads `instances` to the shared instance buffer, to be drawn by the following calls to `drawMesh` and `drawInstances`
+		void upload(const std::vector<InstanceData> & instances);
+		// Draws the last uploaded instances of `mesh`, at level of detail `lod` (see LevelOfDetail::getRange)
+		void drawMesh(const OpenGLModelComponent::Mesh & mesh, size_t lod = 0);
+		// Draws `count` of the last uploaded instances, starting at `firstInstance`. `mesh`'s vertex array must already be bound
+		void drawInstances(const OpenGLModelComponent::Mesh & mesh, size_t firstInstance, size_t count, size_t lod = 0);
+		// Uploads `instances` and draws all of `openGL`'s meshes
+		void drawModel(const OpenGLModelComponent & openGL, const std::vector<InstanceData> & instances, size_t lod = 0);
+
+		// Must be called before deleting a vertex array that may have been drawn with instancing, as GL may hand its name out again
+		void forget(GLuint vertexArrayObject);
+
+		const Stats & getStats();
+	}
+}
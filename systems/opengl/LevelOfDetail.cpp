@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "LevelOfDetail.hpp"
+#include "RenderSnapshot.hpp"
+
+namespace kengine::LevelOfDetail {
+	float screenSize = KENGINE_LOD_SCREEN_SIZE;
+	float hysteresis = KENGINE_LOD_HYSTERESIS;
+	int shadowBias = KENGINE_LOD_SHADOW_BIAS;
+
+	static Stats g_stats;
+
+	static constexpr std::uint8_t UNKNOWN = 0xff; // Entity that wasn't drawable in the previous frame
+	static constexpr std::uint8_t MAX_LEVEL = 15;
+
+	struct CameraLevels {
+		Entity::ID camera;
+		std::vector<std::uint8_t> levels; // Indexed by Entity::ID
+	};
+	static std::vector<CameraLevels> g_cameras;
+	static const std::vector<std::uint8_t> * g_current = nullptr;
+
+	// Level 0 down to `screenSize` pixels, then one more level each time the size halves
+	static std::uint8_t getLevel(float pixels) {
+		if (pixels >= screenSize)
+			return 0;
+		if (pixels <= 0.f)
+			return MAX_LEVEL;
+		return (std::uint8_t)std::min(1.f + std::floor(std::log2(screenSize / pixels)), (float)MAX_LEVEL);
+	}
+
+	static void updateCamera(CameraLevels & camera, const RenderSnapshot::Camera & snapshotCamera, const RenderSnapshot::Snapshot & snapshot) {
+		static std::vector<std::uint8_t> previous;
+		std::swap(previous, camera.levels);
+		camera.levels.assign(snapshot.indices.size(), UNKNOWN);
+
+		for (const auto & drawable : snapshot.drawables) {
+			if (drawable.model == Entity::INVALID_ID)
+				continue;
+
+			const auto pixels = RenderSnapshot::getScreenSize(drawable, snapshotCamera);
+			const auto id = drawable.entity.id;
+
+			auto level = id < previous.size() ? previous[id] : UNKNOWN;
+			if (level == UNKNOWN)
+				level = getLevel(pixels);
+			else {
+				// An Entity hovering around a threshold keeps its level instead of switching every frame
+				const auto margin = std::clamp(hysteresis, 0.f, .9f);
+				const auto coarser = getLevel(pixels * (1.f + margin));
+				const auto finer = getLevel(pixels * (1.f - margin));
+				const auto old = level;
+				if (coarser > level)
+					level = coarser;
+				else if (finer < level)
+					level = finer;
+				if (level != old)
+					++g_stats.switches;
+			}
+
+			camera.levels[id] = level;
+			++g_stats.entities;
+			if (level > 0)
+				++g_stats.simplified;
+		}
+	}
+
+	void update(const RenderSnapshot::Snapshot & snapshot) {
+		g_stats = Stats{};
+		g_stats.cameras = snapshot.cameras.size();
+		g_current = nullptr;
+
+		// Cameras that are gone release their levels
+		g_cameras.erase(std::remove_if(g_cameras.begin(), g_cameras.end(), [&](const CameraLevels & camera) {
+			return std::find_if(snapshot.cameras.begin(), snapshot.cameras.end(), [&](const RenderSnapshot::Camera & c) { return c.id == camera.camera; }) == snapshot.cameras.end();
+		}), g_cameras.end());
+
+		for (const auto & snapshotCamera : snapshot.cameras) {
+			auto it = std::find_if(g_cameras.begin(), g_cameras.end(), [&](const CameraLevels & camera) { return camera.camera == snapshotCamera.id; });
+			if (it == g_cameras.end()) {
+				g_cameras.push_back({ snapshotCamera.id, {} });
+				it = g_cameras.end() - 1;
+			}
+			updateCamera(*it, snapshotCamera, snapshot);
+		}
+	}
+
+	void setCamera(Entity::ID camera) {
+		g_current = nullptr;
+		for (const auto & levels : g_cameras)
+			if (levels.camera == camera)
+				g_current = &levels.levels;
+	}
+
+	size_t get(Entity::ID id) {
+		if (g_current == nullptr || id >= g_current->size() || (*g_current)[id] == UNKNOWN)
+			return 0;
+		return (*g_current)[id];
+	}
+
+	size_t getShadow(Entity::ID id) {
+		return get(id) + std::max(shadowBias, 0);
+	}
+
+	Range getRange(const OpenGLModelComponent::Mesh & mesh, size_t level) {
+		if (mesh.lods.empty())
+			return { (GLsizei)mesh.nbIndices, nullptr };
+
+		const auto & lod = mesh.lods[std::min(level, mesh.lods.size() - 1)];
+		const size_t indexSize = mesh.indexType == GL_UNSIGNED_BYTE ? 1 : mesh.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+		return { (GLsizei)lod.nbIndices, (const void *)(lod.firstIndex * indexSize) };
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <gl/glew.h>
+#include <GL/GL.h>
+
+#include "Entity.hpp"
+#include "data/OpenGLModelComponent.hpp"
+
+#ifndef KENGINE_LOD_SCREEN_SIZE
+# define KENGINE_LOD_SCREEN_SIZE 256.f // Pixels under which Entities are drawn with their first simplified level. Each following level halves it
+#endif
+
+#ifndef KENGINE_LOD_HYSTERESIS
+# define KENGINE_LOD_HYSTERESIS .15f // Fraction of a level's threshold an Entity's screen size must go past before it switches levels
+#endif
+
+#ifndef KENGINE_LOD_SHADOW_BIAS
+# define KENGINE_LOD_SHADOW_BIAS 1 // Shadow maps are drawn with levels this much coarser than the camera's
+#endif
+
+namespace kengine {
+	namespace RenderSnapshot {
+		struct Snapshot;
+	}
+
+	// Picks the level of detail each Entity's meshes are drawn with, from its size on screen
+	namespace LevelOfDetail {
+		struct Stats {
+			size_t cameras = 0;
+			size_t entities = 0; // Summed over all cameras
+			size_t simplified = 0; // Entities given a coarser level than their full mesh, summed over all cameras
+			size_t switches = 0; // Level changes, summed over all cameras
+		};
+
+		// Adjustable at runtime, under "Render/Level of detail"
+		extern float screenSize;
+		extern float hysteresis;
+		extern int shadowBias;
+
+		// Called once per frame by the OpenGLSystem, after Culling::update
+		// Computes each Entity's level for each camera in `snapshot`. Entities only switch levels once their screen size is past the threshold by `hysteresis`
+		void update(const RenderSnapshot::Snapshot & snapshot);
+
+		// Selects the levels of the camera about to be rendered
+		void setCamera(Entity::ID camera);
+
+		// Level for the current camera. Coarser than what meshes may have: see getRange
+		size_t get(Entity::ID id);
+		// Level for shadow maps rendered for the current camera
+		size_t getShadow(Entity::ID id);
+
+		struct Range {
+			GLsizei count;
+			const void * offset; // Into the index buffer, as expected by glDrawElements
+		};
+		// Indices to draw for `level`, clamped to `mesh`'s coarsest level
+		Range getRange(const OpenGLModelComponent::Mesh & mesh, size_t level);
+
+		const Stats & getStats();
+	}
+}
@@ -1,5 +1,9 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
 
 #include "opengl/Program.hpp"
 
@@ -24,6 +28,9 @@
 #include "data/WindowComponent.hpp"
 #include "data/ShaderComponent.hpp"
 #include "data/GBufferComponent.hpp"
+#include "data/GraphicsComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/WorldMatrixComponent.hpp"
 
 #include "functions/Execute.hpp"
 #include "functions/OnTerminate.hpp"
@@ -36,12 +43,23 @@
 
 #include "systems/opengl/ShaderHelper.hpp"
 
+#include "helpers/AssetHelper.hpp"
 #include "helpers/CameraHelper.hpp"
+#include "helpers/MatrixHelper.hpp"
 #include "rotate.hpp"
 
 #include "OpenGLSystem.hpp"
 #include "Controllers.hpp"
 
+#include "Culling.hpp"
+#include "ShadowCache.hpp"
+#include "Instancing.hpp"
+#include "LevelOfDetail.hpp"
+#include "RenderQueue.hpp"
+#include "RenderSnapshot.hpp"
+#include "Residency.hpp"
+#include "TextureStreaming.hpp"
+#include "Uploader.hpp"
 #include "ShadowMap.hpp"
 #include "ShadowCube.hpp"
 #include "SpotLight.hpp"
@@ -62,6 +80,10 @@
 # define KENGINE_MAX_VIEWPORTS 8
 #endif
 
+#ifndef KENGINE_WORLD_MATRICES_PER_TASK
+# define KENGINE_WORLD_MATRICES_PER_TASK 256
+#endif
+
 namespace kengine {
 	namespace Input {
 		static InputBufferComponent * g_buffer;
@@ -76,6 +98,8 @@ namespace kengine {
 
 	// declarations
 	static void execute(float deltaTime);
+	static void extractRenderData();
+	static void render(float deltaTime);
 	static void onEntityCreated(Entity & e);
 	static void onEntityRemoved(Entity & e);
 	static void terminate();
@@ -99,9 +123,36 @@ namespace kengine {
 			};
 		};
 
+		em += [](Entity & e) {
+			e += AdjustableComponent{
+				"Render/Residency", {
+					{ "Budget (MB)", &Residency::budget }
+				}
+			};
+		};
+
+		em += [](Entity & e) {
+			e += AdjustableComponent{
+				"Render/Texture streaming", {
+					{ "Budget (MB)", &TextureStreaming::budget }
+				}
+			};
+		};
+
+		em += [](Entity & e) {
+			e += AdjustableComponent{
+				"Render/Level of detail", {
+					{ "Screen size (pixels)", &LevelOfDetail::screenSize },
+					{ "Hysteresis", &LevelOfDetail::hysteresis },
+					{ "Shadow bias", &LevelOfDetail::shadowBias }
+				}
+			};
+		};
+
 #ifndef KENGINE_NDEBUG
 		em += Controllers::ShaderController(em);
 		em += Controllers::GBufferDebugger(em, g_gBufferIterator);
+		em += Controllers::CullingDebugger(em);
 #endif
 
 		g_params.nearPlane = 1.f;
@@ -379,6 +430,12 @@ namespace kengine {
 	}
 
 	static void onEntityRemoved(Entity & e) {
+		if (e.has<ModelDataComponent>() || e.has<TextureDataComponent>())
+			Uploader::cancel(e.id);
+		Residency::remove(e.id);
+		TextureStreaming::remove(e.id);
+		AssetHelper::remove(e.id);
+
 		if (!e.has<WindowComponent>() || e.id != g_window.id)
 			return;
 		g_window.id = Entity::INVALID_ID;
@@ -411,78 +468,47 @@ namespace kengine {
 	}
 
 	static void createObject(Entity & e, const ModelDataComponent & modelData) {
-		auto & modelInfo = e.attach<OpenGLModelComponent>();
-		modelInfo.meshes.clear();
-		modelInfo.vertexRegisterFunc = modelData.vertexRegisterFunc;
-
-		for (const auto & meshData : modelData.meshes) {
-			OpenGLModelComponent::Mesh meshInfo;
-			glGenVertexArrays(1, &meshInfo.vertexArrayObject);
-			glBindVertexArray(meshInfo.vertexArrayObject);
-
-			glGenBuffers(1, &meshInfo.vertexBuffer);
-			glBindBuffer(GL_ARRAY_BUFFER, meshInfo.vertexBuffer);
-			glBufferData(GL_ARRAY_BUFFER, meshData.vertices.nbElements * meshData.vertices.elementSize, meshData.vertices.data, GL_STATIC_DRAW);
-
-			glGenBuffers(1, &meshInfo.indexBuffer);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshInfo.indexBuffer);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshData.indices.nbElements * meshData.indices.elementSize, meshData.indices.data, GL_STATIC_DRAW);
-
-			modelData.vertexRegisterFunc();
-
-			meshInfo.nbIndices = meshData.indices.nbElements;
-			meshInfo.indexType = meshData.indexType;
-
-			modelInfo.meshes.push_back(meshInfo);
-		}
+		OpenGLModelComponent openGL;
+		if (!Uploader::uploadModel(e.id, modelData, openGL))
+			return;
 
+		e += std::move(openGL);
+		Residency::addModel(e.id, modelData);
 		modelData.free();
 		e.detach<ModelDataComponent>();
 	}
 
 	static void loadTexture(Entity & e, TextureDataComponent & textureData) {
-		if (*textureData.textureID == -1)
-			glGenTextures(1, textureData.textureID);
-
-		if (textureData.data != nullptr) {
-			GLenum format;
-
-			switch (textureData.components) {
-			case 1:
-				format = GL_RED;
-				break;
-			case 3:
-				format = GL_RGB;
-				break;
-			case 4:
-				format = GL_RGBA;
-				break;
-			default:
-				assert(false);
-			}
+		const auto firstLevel = TextureStreaming::getFirstLevel(e.id, textureData);
 
-			glBindTexture(GL_TEXTURE_2D, *textureData.textureID);
-			glTexImage2D(GL_TEXTURE_2D, 0, format, textureData.width, textureData.height, 0, format, GL_UNSIGNED_BYTE, textureData.data);
-			glGenerateMipmap(GL_TEXTURE_2D);
-
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		GLuint texture;
+		if (!Uploader::uploadTexture(e.id, textureData, texture, firstLevel))
+			return;
 
-			if (textureData.free != nullptr)
-				textureData.free(textureData.data);
-		}
+		*textureData.textureID = texture;
+		Residency::addTexture(e.id, textureData, firstLevel);
+		if (firstLevel > 0)
+			TextureStreaming::add(e.id, textureData, texture, firstLevel); // Keeps the data to stream larger levels
+		else if (textureData.data != nullptr && textureData.free != nullptr)
+			textureData.free(textureData.data);
 
 		e.detach<TextureDataComponent>();
 	}
 
 	// declarations
 	static void updateWindowProperties();
+	static void updateWorldMatrices();
 	static void doOpenGL();
-	static void doImGui();
+	static void buildImGui();
+	static void drawImGui();
 	//
 	static void execute(float deltaTime) {
+		extractRenderData();
+		render(deltaTime);
+	}
+
+	// Runs while nothing else accesses the EntityManager: reads all it needs from Components into the RenderSnapshot, the Culling structures and ImGui's draw data
+	static void extractRenderData() {
 		static bool first = true;
 		if (first) {
 			init();
@@ -499,6 +525,7 @@ namespace kengine {
 		glfwPollEvents();
 		updateWindowProperties();
 
+		Uploader::beginFrame();
 		for (auto &[e, modelData] : g_em->getEntities<ModelDataComponent>()) {
 			createObject(e, modelData);
 			if (e.componentMask == 0)
@@ -511,11 +538,81 @@ namespace kengine {
 				g_em->removeEntity(e);
 		}
 
+		updateWorldMatrices();
+		RenderSnapshot::extract(*g_em);
+		Residency::update(*g_em, RenderSnapshot::get());
+		TextureStreaming::update(RenderSnapshot::get());
+		Culling::update(*g_em);
+		LevelOfDetail::update(RenderSnapshot::get());
+
+		for (auto & [e, cam, viewport] : g_em->getEntities<CameraComponent, ViewportComponent>())
+			if (viewport.window == Entity::INVALID_ID)
+				viewport.window = g_window.id;
+
+		buildImGui();
+	}
+
+	static void render(float deltaTime) {
+		if (g_window.id == Entity::INVALID_ID)
+			return;
+
+		ShadowCache::beginFrame();
+		Instancing::beginFrame();
+		RenderQueue::beginFrame();
 		doOpenGL();
-		doImGui();
+		drawImGui();
 		glfwSwapBuffers(g_window.window);
 	}
 
+	static void updateWorldMatrix(const GraphicsComponent & graphics, const TransformComponent & transform, WorldMatrixComponent & world) {
+		const ModelComponent * model = nullptr; // Without one, the matrix is computed without the model's offset
+		if (graphics.model != Entity::INVALID_ID) {
+			const auto modelEntity = g_em->getEntity(graphics.model);
+			if (modelEntity.has<ModelComponent>())
+				model = &modelEntity.get<ModelComponent>();
+		}
+		const auto modelVersion = model != nullptr ? model->version : WorldMatrixComponent::NO_VERSION;
+
+		if (world.transformVersion == transform.version && world.modelEntity == graphics.model && world.modelVersion == modelVersion)
+			return;
+
+		world.model = model != nullptr ? ShaderHelper::getModelMatrix(*model, transform) : MatrixHelper::getTransformMatrix(transform);
+		++world.version;
+		world.modelEntity = graphics.model;
+		world.transformVersion = transform.version;
+		world.modelVersion = modelVersion;
+	}
+
+	static void updateWorldMatrices() {
+		struct Work {
+			const GraphicsComponent * graphics;
+			const TransformComponent * transform;
+			WorldMatrixComponent * world;
+		};
+		static std::vector<Work> work;
+		work.clear();
+
+		static std::vector<Entity::ID> missing;
+		missing.clear();
+		for (const auto & [e, graphics, transform, noWorld] : g_em->getEntities<GraphicsComponent, TransformComponent, no<WorldMatrixComponent>>())
+			missing.push_back(e.id);
+		for (const auto id : missing)
+			g_em->getEntity(id).attach<WorldMatrixComponent>();
+
+		for (auto & [e, graphics, transform, world] : g_em->getEntities<GraphicsComponent, TransformComponent, WorldMatrixComponent>())
+			work.push_back({ &graphics, &transform, &world });
+
+		// Each Entity only writes to its own WorldMatrixComponent, so chunks can be processed concurrently
+		for (size_t start = 0; start < work.size(); start += KENGINE_WORLD_MATRICES_PER_TASK) {
+			const auto end = std::min(work.size(), start + KENGINE_WORLD_MATRICES_PER_TASK);
+			g_em->runTask([start, end] {
+				for (size_t i = start; i < end; ++i)
+					updateWorldMatrix(*work[i].graphics, *work[i].transform, *work[i].world);
+			});
+		}
+		g_em->completeTasks();
+	}
+
 	static void updateWindowProperties() {
 		if (glfwGetWindowAttrib(g_window.window, GLFW_ICONIFIED)) {
 			glfwSwapBuffers(g_window.window);
@@ -584,13 +681,17 @@ namespace kengine {
 		};
 		putils::vector<ToBlit, KENGINE_MAX_VIEWPORTS> toBlit;
 
-		for (auto &[e, cam, viewport] : g_em->getEntities<CameraComponent, ViewportComponent>()) {
-			if (viewport.window == Entity::INVALID_ID)
-				viewport.window = g_window.id;
-			else if (viewport.window != g_window.id)
+		for (const auto & snapshotCam : RenderSnapshot::get().cameras) {
+			auto e = g_em->getEntity(snapshotCam.id);
+			if (!e.has<ViewportComponent>())
+				continue;
+			const auto & viewport = e.get<ViewportComponent>();
+			if (viewport.window != g_window.id)
 				return;
 
-			setupParams(cam, viewport);
+			setupParams(snapshotCam.camera, viewport);
+			Culling::setCamera(g_params.proj * g_params.view);
+			LevelOfDetail::setCamera(snapshotCam.id);
 			fillGBuffer(*g_em, e, viewport);
 
 			if (!e.has<CameraFramebufferComponent>() || e.get<CameraFramebufferComponent>().resolution != viewport.resolution)
@@ -744,7 +845,7 @@ namespace kengine {
 		);
 	}
 
-	static void doImGui() {
+	static void buildImGui() {
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
@@ -752,6 +853,9 @@ namespace kengine {
 		for (const auto &[e, comp] : g_em->getEntities<ImGuiComponent>())
 			comp.display(GImGui);
 		ImGui::Render();
+	}
+
+	static void drawImGui() {
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 		if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -1,6 +1,8 @@
 #include "PointLight.hpp"
 
 #include "ShadowCube.hpp"
+#include "ShadowCache.hpp"
+#include "Culling.hpp"
 #include "EntityManager.hpp"
 
 #include "data/TransformComponent.hpp"
@@ -23,6 +25,23 @@ namespace kengine::Shaders {
 		_shadowMap = _shadowMapTextureID;
 	}
 
+	static bool needsShadowUpdate(Entity & e, const PointLightComponent & light, const putils::Point3f & pos, float radius) {
+		if (!e.has<DepthCubeComponent>())
+			ShadowCache::invalidate(e);
+
+		const auto vPos = ShaderHelper::toVec(pos);
+
+		ShadowCache::Hasher lightHash;
+		lightHash.add(&light.shadowMapSize, sizeof(light.shadowMapSize));
+		lightHash.add(vPos);
+		lightHash.add(radius);
+
+		ShadowCache::Hasher casterHash;
+		casterHash.addCasters(Culling::getCasters(vPos, radius));
+
+		return ShadowCache::needsUpdate(e, lightHash.get(), casterHash.get());
+	}
+
 	void PointLight::run(const Parameters & params) {
 		ShaderHelper::Enable __c(GL_CULL_FACE);
 		ShaderHelper::Enable __b(GL_BLEND);
@@ -40,7 +59,7 @@ namespace kengine::Shaders {
 			const auto radius = LightHelper::getRadius(light);
 			const auto & centre = transform.boundingBox.position;
 
-			if (light.castShadows) {
+			if (light.castShadows && needsShadowUpdate(e, light, centre, radius)) {
 				if (e.has<DepthCubeComponent>()) {
 					ShaderHelper::BindFramebuffer b(e.get<DepthCubeComponent>().fbo);
 					glClear(GL_DEPTH_BUFFER_BIT);
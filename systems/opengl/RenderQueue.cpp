@@ -0,0 +1,98 @@
+#include <algorithm>
+
+#include "RenderQueue.hpp"
+#include "Instancing.hpp"
+#include "LevelOfDetail.hpp"
+
+namespace kengine::RenderQueue {
+	static Stats g_stats;
+
+	static constexpr std::uint64_t TEXTURE_BITS = 24;
+	static constexpr std::uint64_t VERTEX_ARRAY_BITS = 20;
+	static constexpr std::uint64_t DEPTH_BITS = 20;
+
+	std::uint64_t makeKey(GLuint texture, GLuint vertexArrayObject, float depth) {
+		static constexpr auto maxDepth = (1ull << DEPTH_BITS) - 1;
+		const auto normalized = std::min(std::max(depth / KENGINE_RENDER_QUEUE_MAX_DEPTH, 0.f), 1.f);
+
+		// IDs that overflow their bits only cost sort quality, as binds compare the actual IDs
+		return ((std::uint64_t)texture & ((1ull << TEXTURE_BITS) - 1)) << (VERTEX_ARRAY_BITS + DEPTH_BITS)
+			| ((std::uint64_t)vertexArrayObject & ((1ull << VERTEX_ARRAY_BITS) - 1)) << DEPTH_BITS
+			| (std::uint64_t)(normalized * maxDepth);
+	}
+
+	void DrawList::append(const DrawList & other, size_t userDataOffset) {
+		const auto first = _items.size();
+		_items.insert(_items.end(), other._items.begin(), other._items.end());
+		for (auto i = first; i < _items.size(); ++i)
+			_items[i].userData += userDataOffset;
+	}
+
+	void DrawList::sort() { // LSD radix sort, one byte per pass
+		const auto count = _items.size();
+		_order.resize(count);
+		_scratch.resize(count);
+
+		std::uint64_t differing = 0; // Bits that aren't shared by all keys
+		for (std::uint32_t i = 0; i < count; ++i) {
+			_order[i] = { _items[i].key, i };
+			differing |= _items[i].key ^ _items[0].key;
+		}
+
+		for (unsigned int shift = 0; shift < 64; shift += 8) {
+			if (((differing >> shift) & 0xff) == 0) // All keys share this byte
+				continue;
+
+			size_t offsets[256] = {};
+			for (const auto & entry : _order)
+				++offsets[(entry.first >> shift) & 0xff];
+
+			size_t total = 0;
+			for (auto & offset : offsets) {
+				const auto bucketSize = offset;
+				offset = total;
+				total += bucketSize;
+			}
+
+			for (const auto & entry : _order)
+				_scratch[offsets[(entry.first >> shift) & 0xff]++] = entry;
+			std::swap(_order, _scratch);
+		}
+	}
+
+	void DrawList::bind(State & state, const DrawItem & item, GLenum textureUnit) {
+		if (item.texture != state.texture) {
+			glActiveTexture(textureUnit);
+			glBindTexture(GL_TEXTURE_2D, item.texture);
+			state.texture = item.texture;
+			++g_stats.textureBinds;
+		}
+		else
+			++g_stats.elidedBinds;
+
+		if (item.mesh->vertexArrayObject != state.vertexArrayObject) {
+			glBindVertexArray(item.mesh->vertexArrayObject);
+			state.vertexArrayObject = item.mesh->vertexArrayObject;
+			++g_stats.vertexArrayBinds;
+		}
+		else
+			++g_stats.elidedBinds;
+	}
+
+	void DrawList::draw(const DrawItem & item) {
+		const auto & mesh = *item.mesh;
+		if (item.instanceCount > 0)
+			Instancing::drawInstances(mesh, item.firstInstance, item.instanceCount, item.lod);
+		else {
+			const auto range = LevelOfDetail::getRange(mesh, item.lod);
+			glDrawElements(GL_TRIANGLES, range.count, mesh.indexType, range.offset);
+		}
+		++g_stats.draws;
+	}
+
+	void beginFrame() {
+		g_stats = Stats{};
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
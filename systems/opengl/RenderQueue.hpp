@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "data/OpenGLModelComponent.hpp"
+
+#ifndef KENGINE_RENDER_QUEUE_MAX_DEPTH
+# define KENGINE_RENDER_QUEUE_MAX_DEPTH 1000.f // Distance at which sort key depths saturate
+#endif
+
+namespace kengine::RenderQueue {
+	struct DrawItem {
+		std::uint64_t key = 0; // See makeKey
+		const OpenGLModelComponent::Mesh * mesh = nullptr;
+		GLuint texture = 0; // Bound to the DrawList's texture unit, 0 if none
+		std::uint32_t firstInstance = 0; // Into the instances uploaded through Instancing::upload
+		std::uint32_t instanceCount = 0; // 0 for non-instanced draws
+		size_t lod = 0; // Level of detail of `mesh`, see LevelOfDetail::getRange
+		size_t userData = 0; // Passed back to the setup function, e.g. an index into per-draw uniforms
+	};
+
+	// Orders draws by texture, then vertex array, then front to back
+	// Each shader is a single program and submits its own DrawList, so the program needs no bits of its own
+	std::uint64_t makeKey(GLuint texture, GLuint vertexArrayObject, float depth);
+
+	class DrawList {
+	public:
+		void clear() { _items.clear(); }
+		void push(const DrawItem & item) { _items.push_back(item); }
+		bool empty() const { return _items.empty(); }
+		// Appends all of `other`'s items, offsetting their userData by `userDataOffset`, e.g. to gather lists built by different tasks
+		void append(const DrawList & other, size_t userDataOffset);
+
+		// Radix-sorts items by key, then binds state and draws them, skipping redundant binds
+		// Func: void(const DrawItem & item), called before each draw to set per-item uniforms
+		template<typename Func>
+		void submit(GLenum textureUnit, Func && setup) {
+			sort();
+
+			State state;
+			for (const auto & [key, index] : _order) {
+				const auto & item = _items[index];
+				bind(state, item, textureUnit);
+				setup(item);
+				draw(item);
+			}
+			glBindVertexArray(0);
+		}
+
+	private:
+		struct State {
+			GLuint vertexArrayObject = (GLuint)-1;
+			GLuint texture = (GLuint)-1;
+		};
+
+		void sort();
+		static void bind(State & state, const DrawItem & item, GLenum textureUnit);
+		static void draw(const DrawItem & item);
+
+	private:
+		using SortEntry = std::pair<std::uint64_t, std::uint32_t>; // Key, index into _items
+
+		std::vector<DrawItem> _items;
+		std::vector<SortEntry> _order;
+		std::vector<SortEntry> _scratch;
+	};
+
+	struct Stats {
+		size_t draws = 0;
+		size_t textureBinds = 0;
+		size_t vertexArrayBinds = 0;
+		size_t elidedBinds = 0; // Binds skipped because the state was already set
+	};
+
+	// Called once per frame by the OpenGLSystem
+	void beginFrame();
+
+	const Stats & getStats();
+}
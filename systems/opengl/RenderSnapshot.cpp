@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "RenderSnapshot.hpp"
+#include "EntityManager.hpp"
+#include "ThreadPool.hpp"
+
+#include "data/GraphicsComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/WorldMatrixComponent.hpp"
+#include "data/SkeletonComponent.hpp"
+#include "data/ViewportComponent.hpp"
+#include "data/SpriteComponent.hpp"
+
+namespace kengine::RenderSnapshot {
+	static Snapshot g_snapshot;
+	static putils::ThreadPool g_workers(KENGINE_RENDER_SNAPSHOT_THREADS); // Separate from the EntityManager's, so that rendering and the simulation never wait on each other's tasks
+
+	const Drawable * Snapshot::find(Entity::ID id) const {
+		if (id >= indices.size() || indices[id] == detail::INVALID)
+			return nullptr;
+		return &drawables[indices[id]];
+	}
+
+	const glm::mat4 * Snapshot::getBones(const Drawable & drawable, size_t mesh) const {
+		if (mesh >= drawable.boneMeshes)
+			return nullptr;
+		return &bones[drawable.firstBone + mesh * KENGINE_SKELETON_MAX_BONES];
+	}
+
+	void extract(EntityManager & em) {
+		auto & snapshot = g_snapshot;
+		++snapshot.frame;
+
+		for (const auto & drawable : snapshot.drawables)
+			snapshot.indices[drawable.entity.id] = detail::INVALID;
+		snapshot.drawables.clear();
+		snapshot.cameras.clear();
+
+		struct Work {
+			const GraphicsComponent * graphics;
+			const TransformComponent * transform;
+			const WorldMatrixComponent * world;
+			const SkeletonComponent * skeleton;
+		};
+		static std::vector<Work> work;
+		work.clear();
+
+		// Serial pass: lay the snapshot out, so Drawables can then be filled concurrently
+		size_t boneCount = 0;
+		for (const auto & [e, graphics, transform] : em.getEntities<GraphicsComponent, TransformComponent>()) {
+			Drawable drawable;
+			drawable.entity = EntityView(e.id, e.componentMask);
+			drawable.model = graphics.model;
+
+			const SkeletonComponent * skeleton = nullptr;
+			if (e.has<SkeletonComponent>()) {
+				skeleton = &e.get<SkeletonComponent>();
+				drawable.firstBone = boneCount;
+				drawable.boneMeshes = skeleton->meshes.size();
+				boneCount += drawable.boneMeshes * KENGINE_SKELETON_MAX_BONES;
+			}
+
+			if (e.id >= snapshot.indices.size())
+				snapshot.indices.resize(e.id + 1, detail::INVALID);
+			snapshot.indices[e.id] = snapshot.drawables.size();
+
+			snapshot.drawables.push_back(drawable);
+			work.push_back({ &graphics, &transform, e.has<WorldMatrixComponent>() ? &e.get<WorldMatrixComponent>() : nullptr, skeleton });
+		}
+		snapshot.bones.resize(boneCount);
+
+		runTasks(work.size(), [&snapshot](size_t task, size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				auto & drawable = snapshot.drawables[i];
+				const auto & w = work[i];
+
+				drawable.color = w.graphics->color;
+				drawable.boundingBox = w.transform->boundingBox;
+				if (w.world != nullptr)
+					drawable.world = w.world->model;
+
+				for (size_t mesh = 0; mesh < drawable.boneMeshes; ++mesh) {
+					const auto & bones = w.skeleton->meshes[mesh].boneMatsBoneSpace;
+					std::copy(std::begin(bones), std::end(bones), snapshot.bones.begin() + drawable.firstBone + mesh * KENGINE_SKELETON_MAX_BONES);
+				}
+			}
+		});
+
+		for (const auto & [e, cam, viewport] : em.getEntities<CameraComponent, ViewportComponent>())
+			snapshot.cameras.push_back({ e.id, cam, viewport.resolution });
+	}
+
+	const Snapshot & get() { return g_snapshot; }
+
+	float getScreenSize(const Drawable & drawable, const Camera & camera) {
+		const auto & box = drawable.boundingBox;
+		const auto & resolution = camera.resolution;
+		const auto maxSize = (float)std::max(resolution.x, resolution.y);
+
+		if (drawable.entity.has<SpriteComponent2D>()) // Drawn in normalized device coordinates
+			return std::min(maxSize, std::max(box.size.x * resolution.x, box.size.y * resolution.y) / 2.f);
+
+		const auto & pos = camera.camera.frustum.position;
+		const auto dx = box.position.x - pos.x;
+		const auto dy = box.position.y - pos.y;
+		const auto dz = box.position.z - pos.z;
+		const auto radius = std::sqrt(box.size.x * box.size.x + box.size.y * box.size.y + box.size.z * box.size.z) / 2.f;
+		const auto distance = std::sqrt(dx * dx + dy * dy + dz * dz) - radius;
+		if (distance <= 0.f)
+			return maxSize;
+
+		const auto fov = camera.camera.frustum.size.y;
+		return std::min(maxSize, radius / (distance * std::tan(fov / 2.f)) * resolution.y);
+	}
+
+	size_t getTaskCount(size_t count) {
+		return (count + KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK - 1) / KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK;
+	}
+
+	void runTasks(size_t count, const std::function<void(size_t task, size_t begin, size_t end)> & func) {
+		const auto tasks = getTaskCount(count);
+		if (tasks <= 1) { // Not worth waking the thread pool
+			if (tasks == 1)
+				func(0, 0, count);
+			return;
+		}
+
+		for (size_t task = 0; task < tasks; ++task) {
+			const auto begin = task * KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK;
+			const auto end = std::min(count, begin + KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK);
+			g_workers.runTask([&func, task, begin, end] { func(task, begin, end); });
+		}
+		g_workers.completeTasks();
+	}
+}
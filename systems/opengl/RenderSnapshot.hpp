@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <glm/glm.hpp>
+
+#include "Entity.hpp"
+#include "Color.hpp"
+#include "Point.hpp"
+
+#include "data/CameraComponent.hpp"
+
+#ifndef KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK
+# define KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK 256
+#endif
+
+#ifndef KENGINE_RENDER_SNAPSHOT_THREADS
+# define KENGINE_RENDER_SNAPSHOT_THREADS 4
+#endif
+
+namespace kengine {
+	class EntityManager;
+
+	namespace RenderSnapshot {
+		namespace detail {
+			static constexpr size_t INVALID = (size_t)-1;
+		}
+
+		struct Drawable {
+			EntityView entity; // Only use `has`: Components are read when the snapshot is taken
+			Entity::ID model = Entity::INVALID_ID; // GraphicsComponent::model
+			glm::mat4 world{ 1.f }; // WorldMatrixComponent::model
+			putils::NormalizedColor color; // GraphicsComponent::color
+			putils::Rect3f boundingBox; // TransformComponent::boundingBox
+			size_t firstBone = 0; // Index into Snapshot::bones
+			size_t boneMeshes = 0; // Meshes posed by the Entity's SkeletonComponent, with KENGINE_SKELETON_MAX_BONES matrices each
+		};
+
+		struct Camera {
+			Entity::ID id = Entity::INVALID_ID;
+			CameraComponent camera;
+			putils::Point2i resolution; // ViewportComponent::resolution
+		};
+
+		// Copy of the render-relevant state of a frame
+		struct Snapshot {
+			size_t frame = 0;
+			std::vector<Drawable> drawables;
+			std::vector<glm::mat4> bones; // SkeletonComponent::Mesh::boneMatsBoneSpace of all posed Drawables
+			std::vector<Camera> cameras;
+			std::vector<size_t> indices; // Index of each Entity's Drawable, indexed by Entity::ID
+
+			// Returns nullptr if `id` wasn't drawable when the snapshot was taken
+			const Drawable * find(Entity::ID id) const;
+			// Returns nullptr if `drawable` has no pose for `mesh`
+			const glm::mat4 * getBones(const Drawable & drawable, size_t mesh) const;
+		};
+
+		// Copies the current state of all Entities with a GraphicsComponent and a TransformComponent, and of all cameras
+		// Must be called while no other thread modifies the EntityManager. Called once per frame by the OpenGLSystem
+		void extract(EntityManager & em);
+
+		// Snapshot taken by the last call to `extract`
+		const Snapshot & get();
+
+		// Largest side of `drawable`'s bounding box, in pixels, as seen by `camera`. Doesn't account for the camera's direction
+		float getScreenSize(const Drawable & drawable, const Camera & camera);
+
+		// Number of tasks `runTasks` splits `count` elements into
+		size_t getTaskCount(size_t count);
+		// Splits [0, count) into ranges of KENGINE_RENDER_SNAPSHOT_ENTITIES_PER_TASK, runs `func` for each of them on the renderer's thread pool and waits for them
+		// `task` is in [0, getTaskCount(count)), so that each task can write to its own buffer, e.g. to build draw lists over `get().drawables`
+		void runTasks(size_t count, const std::function<void(size_t task, size_t begin, size_t end)> & func);
+	}
+}
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Residency.hpp"
+#include "Instancing.hpp"
+#include "RenderSnapshot.hpp"
+#include "TextureCache.hpp"
+#include "TextureStreaming.hpp"
+#include "EntityManager.hpp"
+
+#include "data/ModelComponent.hpp"
+#include "data/ModelDataComponent.hpp"
+#include "data/TextureDataComponent.hpp"
+#include "data/TextureModelComponent.hpp"
+#include "data/OpenGLModelComponent.hpp"
+#include "data/GraphicsComponent.hpp"
+#include "data/TransformComponent.hpp"
+
+#include "helpers/AssetHelper.hpp"
+
+namespace kengine::Residency {
+	int budget = KENGINE_GPU_MEMORY_BUDGET;
+
+	static Stats g_stats;
+
+	struct Resident {
+		size_t bytes = 0;
+		size_t lastUsed = 0; // Last frame the asset was referenced
+	};
+	static std::unordered_map<Entity::ID, Resident> g_residents;
+	static std::unordered_set<Entity::ID> g_evicted;
+
+	// Textures are decoded by the TextureCache's threads, then attached by `update`
+	static std::unordered_set<Entity::ID> g_reloading;
+	static std::vector<std::pair<Entity::ID, TextureCache::Texture>> g_decoded;
+	static std::mutex g_decodedMutex;
+
+	static std::vector<Entity::ID> g_references; // Asset referenced by each Entity's GraphicsComponent, indexed by Entity::ID
+	static size_t g_graphicsVersion = 0;
+
+	static void reference(Entity::ID id, Entity::ID model) {
+		if (id >= g_references.size())
+			g_references.resize(id + 1, Entity::INVALID_ID);
+
+		auto & current = g_references[id];
+		if (current == model)
+			return;
+
+		if (current != Entity::INVALID_ID)
+			AssetHelper::removeRef(current);
+		if (model != Entity::INVALID_ID)
+			AssetHelper::addRef(model);
+		current = model;
+	}
+
+	static void updateReferences(EntityManager & em, const RenderSnapshot::Snapshot & snapshot) {
+		for (const auto & drawable : snapshot.drawables)
+			reference(drawable.entity.id, drawable.model);
+
+		// Entities only stop being drawable when they lose their GraphicsComponent or TransformComponent, or are removed or deactivated
+		const auto version = em.getComponentVersion(Component<GraphicsComponent>::id()) + em.getComponentVersion(Component<TransformComponent>::id());
+		if (version == g_graphicsVersion)
+			return;
+		g_graphicsVersion = version;
+
+		for (Entity::ID id = 0; id < g_references.size(); ++id)
+			if (g_references[id] != Entity::INVALID_ID && snapshot.find(id) == nullptr)
+				reference(id, Entity::INVALID_ID);
+	}
+
+	static void reloadTexture(Entity::ID id, const char * file) {
+		g_reloading.insert(id);
+		TextureCache::loadAsync(file, [id](const TextureCache::Texture & texture) {
+			std::lock_guard<std::mutex> lock(g_decodedMutex);
+			g_decoded.emplace_back(id, texture);
+		});
+	}
+
+	static void attachDecodedTextures(EntityManager & em) {
+		std::vector<std::pair<Entity::ID, TextureCache::Texture>> decoded;
+		{
+			std::lock_guard<std::mutex> lock(g_decodedMutex);
+			decoded.swap(g_decoded);
+		}
+
+		for (const auto & [id, texture] : decoded) {
+			if (g_reloading.erase(id) == 0) { // Removed while decoding
+				if (texture.data != nullptr)
+					TextureCache::release(texture.data);
+				continue;
+			}
+
+			if (texture.data == nullptr)
+				continue;
+
+			auto e = em.getEntity(id);
+			TextureDataComponent textureLoader; {
+				textureLoader.textureID = &e.get<TextureModelComponent>().texture;
+				textureLoader.data = texture.data;
+				textureLoader.width = texture.width;
+				textureLoader.height = texture.height;
+				textureLoader.components = 4;
+				textureLoader.levels = texture.levels;
+				textureLoader.free = TextureCache::release;
+			} e += textureLoader;
+		}
+	}
+
+	static void reload(EntityManager & em) {
+		for (auto it = g_evicted.begin(); it != g_evicted.end();) {
+			if (AssetHelper::getRefCount(*it) == 0) {
+				++it;
+				continue;
+			}
+
+			auto e = em.getEntity(*it);
+			if (e.has<ModelComponent>()) {
+				if (const auto reloader = AssetHelper::getReloader(e.id)) // Attaches a new ModelDataComponent
+					reloader(e);
+			}
+			else if (e.has<TextureModelComponent>())
+				if (const auto file = AssetHelper::getAssetPath(e.id))
+					reloadTexture(e.id, file);
+			it = g_evicted.erase(it);
+		}
+	}
+
+	static void evict(EntityManager & em, Entity::ID id) {
+		auto e = em.getEntity(id);
+
+		if (e.has<OpenGLModelComponent>()) {
+			for (const auto & mesh : e.get<OpenGLModelComponent>().meshes) {
+				Instancing::forget(mesh.vertexArrayObject);
+				glDeleteVertexArrays(1, &mesh.vertexArrayObject);
+				glDeleteBuffers(1, &mesh.vertexBuffer);
+				glDeleteBuffers(1, &mesh.indexBuffer);
+			}
+			e.detach<OpenGLModelComponent>();
+		}
+
+		if (e.has<TextureModelComponent>()) {
+			TextureStreaming::remove(id);
+			auto & texture = e.get<TextureModelComponent>().texture;
+			glDeleteTextures(1, &texture);
+			texture = (GLuint)-1;
+		}
+
+		g_stats.bytes -= g_residents[id].bytes;
+		g_residents.erase(id);
+		g_evicted.insert(id);
+	}
+
+	void update(EntityManager & em, const RenderSnapshot::Snapshot & snapshot) {
+		updateReferences(em, snapshot);
+		attachDecodedTextures(em);
+		reload(em);
+
+		for (auto & [id, resident] : g_residents)
+			if (AssetHelper::getRefCount(id) > 0)
+				resident.lastUsed = snapshot.frame;
+
+		const auto budgetBytes = (size_t)std::max(budget, 0) * 1024 * 1024;
+		if (g_stats.bytes > budgetBytes) {
+			static std::vector<std::pair<size_t, Entity::ID>> candidates; // Last use and ID of unreferenced assets
+			candidates.clear();
+			for (const auto & [id, resident] : g_residents)
+				if (AssetHelper::getRefCount(id) == 0)
+					candidates.emplace_back(resident.lastUsed, id);
+			std::sort(candidates.begin(), candidates.end());
+
+			for (const auto & [lastUsed, id] : candidates) {
+				if (g_stats.bytes <= budgetBytes)
+					break;
+				evict(em, id);
+			}
+		}
+
+		g_stats.resident = g_residents.size();
+		g_stats.evicted = g_evicted.size();
+		g_stats.budget = budgetBytes;
+	}
+
+	static void add(Entity::ID id, size_t bytes) {
+		if (AssetHelper::getAssetPath(id) == nullptr)
+			return;
+
+		auto & resident = g_residents[id];
+		g_stats.bytes += bytes - resident.bytes;
+		resident.bytes = bytes;
+		g_evicted.erase(id);
+	}
+
+	void addModel(Entity::ID id, const ModelDataComponent & modelData) {
+		if (AssetHelper::getReloader(id) == nullptr) // Its loader couldn't bring it back
+			return;
+
+		size_t bytes = 0;
+		for (const auto & mesh : modelData.meshes)
+			bytes += mesh.vertices.nbElements * mesh.vertices.elementSize + mesh.indices.nbElements * mesh.indices.elementSize;
+		add(id, bytes);
+	}
+
+	void addTexture(Entity::ID id, const TextureDataComponent & textureData, int baseLevel) {
+		if (textureData.levels <= 1) {
+			const size_t bytes = (size_t)textureData.width * textureData.height * textureData.components;
+			add(id, bytes + bytes / 3); // Mipmaps generated by the GPU
+			return;
+		}
+
+		size_t bytes = 0;
+		for (int level = baseLevel; level < textureData.levels; ++level)
+			bytes += (size_t)std::max(1, textureData.width >> level) * std::max(1, textureData.height >> level) * textureData.components;
+		add(id, bytes);
+	}
+
+	void remove(Entity::ID id) {
+		if (id < g_references.size())
+			reference(id, Entity::INVALID_ID);
+
+		const auto it = g_residents.find(id);
+		if (it != g_residents.end()) {
+			g_stats.bytes -= it->second.bytes;
+			g_residents.erase(it);
+		}
+		g_evicted.erase(id);
+		g_reloading.erase(id);
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
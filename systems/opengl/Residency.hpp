@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Entity.hpp"
+
+#ifndef KENGINE_GPU_MEMORY_BUDGET
+# define KENGINE_GPU_MEMORY_BUDGET 512 // Megabytes of model and texture assets kept on the GPU
+#endif
+
+namespace kengine {
+	class EntityManager;
+	struct ModelDataComponent;
+	struct TextureDataComponent;
+
+	namespace RenderSnapshot {
+		struct Snapshot;
+	}
+
+	// Evicts unreferenced model and texture assets from the GPU, least recently used first, once they exceed a budget
+	namespace Residency {
+		struct Stats {
+			size_t bytes = 0; // Resident
+			size_t resident = 0;
+			size_t evicted = 0; // Evicted and not referenced since
+			size_t budget = 0;
+		};
+
+		// Megabytes. Adjustable at runtime, under "Render/Residency"
+		extern int budget;
+
+		// Called once per frame by the OpenGLSystem, after extracting `snapshot`
+		// Updates asset reference counts from the snapshot's Drawables, reloads referenced assets that were evicted, then evicts unreferenced ones until the budget is met
+		void update(EntityManager & em, const RenderSnapshot::Snapshot & snapshot);
+
+		// Called by the OpenGLSystem once an asset's data is resident. Entities that aren't registered in the AssetHelper are ignored, as they couldn't be reloaded
+		void addModel(Entity::ID id, const ModelDataComponent & modelData);
+		// `baseLevel` is the largest of the texture's levels that is resident, which TextureStreaming updates as it streams them
+		void addTexture(Entity::ID id, const TextureDataComponent & textureData, int baseLevel = 0);
+
+		// Called by the OpenGLSystem when an Entity is removed
+		void remove(Entity::ID id);
+
+		const Stats & getStats();
+	}
+}
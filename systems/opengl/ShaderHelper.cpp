@@ -2,58 +2,27 @@
 #include <vector>
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/LevelOfDetail.hpp"
+#include "helpers/MatrixHelper.hpp"
 
 namespace kengine::ShaderHelper {
-	void drawModel(const OpenGLModelComponent & openGL) {
+	void drawModel(const OpenGLModelComponent & openGL, size_t lod) {
 		for (const auto & meshInfo : openGL.meshes) {
 			glBindVertexArray(meshInfo.vertexArrayObject);
 			glBindBuffer(GL_ARRAY_BUFFER, meshInfo.vertexBuffer);
-			glDrawElements(GL_TRIANGLES, (GLsizei)meshInfo.nbIndices, meshInfo.indexType, nullptr);
+			const auto range = LevelOfDetail::getRange(meshInfo, lod);
+			glDrawElements(GL_TRIANGLES, range.count, meshInfo.indexType, range.offset);
 		}
 	}
 
 	glm::mat4 getModelMatrix(const ModelComponent & modelInfo, const TransformComponent & transform) {
-		glm::mat4 model(1.f);
-		const auto & centre = transform.boundingBox.position;
-
-		{ // TransformComponent
-			model = glm::translate(model, toVec(centre));
-
-			model = glm::rotate(model,
-				transform.yaw,
-				{ 0.f, 1.f, 0.f }
-			);
-			model = glm::rotate(model,
-				transform.pitch,
-				{ 1.f, 0.f, 0.f }
-			);
-			model = glm::rotate(model,
-				transform.roll,
-				{ 0.f, 0.f, 1.f }
-			);
-
-			model = glm::scale(model, toVec(transform.boundingBox.size));
-		}
-
-		{ // GraphicsComponent
-			model = glm::rotate(model,
-				modelInfo.yaw,
-				{ 0.f, 1.f, 0.f }
-			);
-			model = glm::rotate(model,
-				modelInfo.pitch,
-				{ 1.f, 0.f, 0.f }
-			);
-			model = glm::rotate(model,
-				modelInfo.roll,
-				{ 0.f, 0.f, 1.f }
-			);
-
-			model = glm::translate(model, -toVec(modelInfo.boundingBox.position)); // Re-center
-			model = glm::scale(model, toVec(modelInfo.boundingBox.size));
-		}
+		return MatrixHelper::getModelMatrix(modelInfo, transform);
+	}
 
-		return model;
+	glm::mat4 getModelMatrix(const Entity & e, const ModelComponent & modelInfo, const TransformComponent & transform) {
+		if (e.has<WorldMatrixComponent>())
+			return e.get<WorldMatrixComponent>().model;
+		return getModelMatrix(modelInfo, transform);
 	}
 
 	namespace shapes {
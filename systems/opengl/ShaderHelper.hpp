@@ -11,6 +11,7 @@
 #include "data/ModelComponent.hpp"
 #include "data/OpenGLModelComponent.hpp"
 #include "data/TransformComponent.hpp"
+#include "data/WorldMatrixComponent.hpp"
 
 namespace kengine {
 	namespace ShaderHelper {
@@ -42,7 +43,9 @@ namespace kengine {
 		};
 
 		static glm::vec3 toVec(const putils::Point3f & p) { return { p.x, p.y, p.z }; }
-		void drawModel(const OpenGLModelComponent & openGL);
+		void drawModel(const OpenGLModelComponent & openGL, size_t lod = 0);
 		glm::mat4 getModelMatrix(const ModelComponent & modelInfo, const TransformComponent & transform);
+		// Returns the cached WorldMatrixComponent if `e` has one, falls back to computing the matrix otherwise
+		glm::mat4 getModelMatrix(const Entity & e, const ModelComponent & modelInfo, const TransformComponent & transform);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "ShadowCache.hpp"
+#include "EntityManager.hpp"
+
+#include "data/ShaderComponent.hpp"
+
+#include "Culling.hpp"
+
+namespace kengine::ShadowCache {
+	static Stats g_stats;
+	static size_t g_casterUpdates = 0;
+
+	void Hasher::add(const void * data, size_t size) { // FNV-1a
+		const auto bytes = (const unsigned char *)data;
+		for (size_t i = 0; i < size; ++i) {
+			_hash ^= bytes[i];
+			_hash *= 1099511628211ull;
+		}
+	}
+
+	void Hasher::addCasters(const std::vector<Entity::ID> & casters) {
+		const auto count = casters.size();
+		add(&count, sizeof(count));
+		for (const auto id : casters) {
+			const auto lastChange = Culling::getLastChange(id);
+			add(&id, sizeof(id));
+			add(&lastChange, sizeof(lastChange));
+		}
+	}
+
+	void beginFrame() {
+		g_stats = Stats{};
+		g_casterUpdates = 0;
+	}
+
+	bool needsUpdate(Entity & light, size_t lightHash, size_t casterHash) {
+		if (!light.has<ShadowMapCacheComponent>()) {
+			auto & cache = light.attach<ShadowMapCacheComponent>();
+			cache.lightHash = lightHash;
+			cache.casterHash = casterHash;
+			++g_stats.updates;
+			return true;
+		}
+
+		auto & cache = light.get<ShadowMapCacheComponent>();
+		if (cache.lightHash == lightHash && cache.casterHash == casterHash) {
+			++g_stats.hits;
+			return false;
+		}
+
+		if (cache.lightHash == lightHash) { // Only casters moved
+			// Lights that were delayed last frame go through regardless, so none is starved
+			if (g_casterUpdates >= KENGINE_SHADOW_MAP_UPDATE_BUDGET && !cache.delayed) {
+				cache.delayed = true;
+				++g_stats.delayed;
+				return false;
+			}
+			++g_casterUpdates;
+		}
+
+		cache.lightHash = lightHash;
+		cache.casterHash = casterHash;
+		cache.delayed = false;
+		++g_stats.updates;
+		return true;
+	}
+
+	void invalidate(Entity & light) {
+		if (light.has<ShadowMapCacheComponent>())
+			light.get<ShadowMapCacheComponent>() = ShadowMapCacheComponent{};
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
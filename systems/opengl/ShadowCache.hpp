@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Entity.hpp"
+
+#ifndef KENGINE_SHADOW_MAP_UPDATE_BUDGET
+# define KENGINE_SHADOW_MAP_UPDATE_BUDGET 4 // Shadow map re-renders per frame caused by moving casters
+#endif
+
+namespace kengine::ShadowCache {
+	class Hasher {
+	public:
+		void add(const void * data, size_t size);
+		void add(float f) { add(&f, sizeof(f)); }
+		void add(const glm::mat4 & m) { add(&m[0][0], sizeof(m)); }
+		void add(const glm::vec3 & v) { add(&v[0], sizeof(v)); }
+		void addCasters(const std::vector<Entity::ID> & casters); // Hashes their IDs and the frame each last moved
+
+		size_t get() const { return _hash; }
+
+	private:
+		size_t _hash = 14695981039346656037ull;
+	};
+
+	struct Stats {
+		size_t updates = 0;
+		size_t hits = 0;
+		size_t delayed = 0;
+	};
+
+	// Called once per frame by the OpenGLSystem
+	void beginFrame();
+
+	// Returns whether `light`'s shadow map must be re-rendered, and if so records the new hashes
+	// A change in `lightHash` always triggers a re-render, while changes in `casterHash` are subject to KENGINE_SHADOW_MAP_UPDATE_BUDGET
+	bool needsUpdate(Entity & light, size_t lightHash, size_t casterHash);
+
+	// Forces `light`'s shadow map to be re-rendered
+	void invalidate(Entity & light);
+
+	const Stats & getStats();
+}
@@ -6,6 +6,9 @@
 #include "data/GraphicsComponent.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Instancing.hpp"
+#include "systems/opengl/LevelOfDetail.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
 #include "helpers/LightHelper.hpp"
 
 namespace kengine::Shaders {
@@ -21,19 +24,18 @@ namespace kengine::Shaders {
 	}
 
 	void ShadowCube::drawObjects() {
-		for (const auto &[e, graphics, transform, shadow] : _em.getEntities<GraphicsComponent, TransformComponent, DefaultShadowComponent>()) {
-			if (graphics.model == Entity::INVALID_ID)
-				continue;
+		const auto & snapshot = RenderSnapshot::get();
 
-			const auto & modelInfoEntity = _em.getEntity(graphics.model);
-			if (!modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<ModelComponent>())
-				continue;
-
-			const auto & modelInfo = modelInfoEntity.get<ModelComponent>();
-			const auto & openGL = modelInfoEntity.get<OpenGLModelComponent>();
-
-			_model = ShaderHelper::getModelMatrix(modelInfo, transform);
-			ShaderHelper::drawModel(openGL);
+		_batcher.clear();
+		for (const auto id : getCasters()) {
+			const auto drawable = snapshot.find(id);
+			if (drawable != nullptr && drawable->entity.has<DefaultShadowComponent>())
+				_batcher.add(_em, *drawable, LevelOfDetail::getShadow(id));
 		}
+
+		_instanced = true;
+		_batcher.forEach([this](Entity::ID model, size_t lod, const auto & instances) {
+			Instancing::drawModel(_em.getEntity(model).get<OpenGLModelComponent>(), instances, lod);
+		});
 	}
 }
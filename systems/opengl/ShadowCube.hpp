@@ -4,6 +4,7 @@
 #include "shaders/ProjViewModelSrc.hpp"
 #include "shaders/DepthCubeSrc.hpp"
 #include "shaders/ShadowMapShader.hpp"
+#include "Instancing.hpp"
 #include "Entity.hpp"
 
 #include "data/ShaderComponent.hpp"
@@ -24,6 +25,7 @@ namespace kengine::Shaders {
 
 	private:
 		EntityManager & _em;
+		Instancing::Batcher _batcher;
 
 	public:
 		putils_reflection_parents(
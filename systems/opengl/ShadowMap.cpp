@@ -8,6 +8,10 @@
 #include "data/DefaultShadowComponent.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Culling.hpp"
+#include "systems/opengl/Instancing.hpp"
+#include "systems/opengl/LevelOfDetail.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
 #include "helpers/LightHelper.hpp"
 
 namespace kengine {
@@ -40,19 +44,18 @@ namespace kengine::Shaders {
 
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
 
-		for (const auto & [e, graphics, transform, shadow] : _em.getEntities<GraphicsComponent, TransformComponent, DefaultShadowComponent>()) {
-			if (graphics.model == Entity::INVALID_ID)
-				continue;
+		const auto & snapshot = RenderSnapshot::get();
 
-			const auto & modelInfoEntity = _em.getEntity(graphics.model);
-			if (!modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<ModelComponent>())
-				continue;
-
-			const auto & modelInfo = modelInfoEntity.get<ModelComponent>();
-			const auto & openGL = modelInfoEntity.get<OpenGLModelComponent>();
-
-			_model = ShaderHelper::getModelMatrix(modelInfo, transform);
-			ShaderHelper::drawModel(openGL);
+		_batcher.clear();
+		for (const auto id : Culling::getCasters(lightSpaceMatrix)) {
+			const auto drawable = snapshot.find(id);
+			if (drawable != nullptr && drawable->entity.has<DefaultShadowComponent>())
+				_batcher.add(_em, *drawable, LevelOfDetail::getShadow(id));
 		}
+
+		_instanced = true;
+		_batcher.forEach([this](Entity::ID model, size_t lod, const auto & instances) {
+			Instancing::drawModel(_em.getEntity(model).get<OpenGLModelComponent>(), instances, lod);
+		});
 	}
 }
\ No newline at end of file
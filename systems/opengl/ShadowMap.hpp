@@ -6,6 +6,7 @@
 #include "data/ShaderComponent.hpp"
 #include "shaders/ProjViewModelSrc.hpp"
 #include "shaders/ShadowMapShader.hpp"
+#include "Instancing.hpp"
 
 namespace kengine {
 	class EntityManager;
@@ -25,6 +26,7 @@ namespace kengine::Shaders {
 
 	private:
 		EntityManager & _em;
+		Instancing::Batcher _batcher;
 
 	public:
 		putils_reflection_parents(
@@ -4,6 +4,7 @@
 #include "data/SkyBoxComponent.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "helpers/VFS.hpp"
 #include "stb_image.h"
 
 struct SkyBoxOpenGLComponent {
@@ -68,7 +69,8 @@ namespace kengine::Shaders {
 			using MemberType = std::decay_t<decltype(SkyBoxComponent{}.*member) > ;
 			if constexpr (std::is_same<MemberType, SkyBoxComponent::string>()) {
 				int width, height, nrChannels;
-				const auto data = stbi_load((comp.*member).c_str(), &width, &height, &nrChannels, 0);
+				const VFS::File file((comp.*member).c_str());
+				const auto data = stbi_load_from_memory((const stbi_uc *)file.data(), (int)file.size(), &width, &height, &nrChannels, 0);
 				assert(data != nullptr);
 				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
 				stbi_image_free(data);
@@ -10,6 +10,8 @@
 #include "systems/opengl/ShaderHelper.hpp"
 
 #include "shaders/ShadowMapShader.hpp"
+#include "ShadowCache.hpp"
+#include "Culling.hpp"
 
 namespace kengine::Shaders {
 	void SpotLight::init(size_t firstTextureID) {
@@ -23,6 +25,22 @@ namespace kengine::Shaders {
 		_shadowMap = _shadowMapTextureID;
 	}
 
+	static bool needsShadowUpdate(Entity & e, const SpotLightComponent & light, const putils::Point3f & pos, const putils::gl::Program::Parameters & params) {
+		if (!e.has<DepthMapComponent>())
+			ShadowCache::invalidate(e);
+
+		const auto lightSpaceMatrix = LightHelper::getLightSpaceMatrix(light, ShaderHelper::toVec(pos), params);
+
+		ShadowCache::Hasher lightHash;
+		lightHash.add(&light.shadowMapSize, sizeof(light.shadowMapSize));
+		lightHash.add(lightSpaceMatrix);
+
+		ShadowCache::Hasher casterHash;
+		casterHash.addCasters(Culling::getCasters(lightSpaceMatrix));
+
+		return ShadowCache::needsUpdate(e, lightHash.get(), casterHash.get());
+	}
+
 	void SpotLight::run(const Parameters & params) {
 		ShaderHelper::Enable __c(GL_CULL_FACE);
 		ShaderHelper::Enable __b(GL_BLEND);
@@ -40,7 +58,7 @@ namespace kengine::Shaders {
 			const auto & centre = transform.boundingBox.position;
 			setLight(light, centre);
 
-			if (light.castShadows) {
+			if (light.castShadows && needsShadowUpdate(e, light, centre, params)) {
 				if (e.has<DepthMapComponent>()) {
 					ShaderHelper::BindFramebuffer b(e.get<DepthMapComponent>().fbo);
 					glClear(GL_DEPTH_BUFFER_BIT);
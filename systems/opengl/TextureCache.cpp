@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TextureCache.hpp"
+
+#include "ThreadPool.hpp"
+#include "termcolor.hpp"
+#include "stb_image.h"
+
+#include "helpers/MappedFile.hpp"
+#include "helpers/VFS.hpp"
+
+#if defined(__SSSE3__) || defined(__AVX__) // MSVC only defines the latter
+# define KENGINE_TEXTURE_SSSE3
+# include <tmmintrin.h>
+#endif
+
+namespace kengine::TextureCache {
+	static constexpr char MAGIC[] = { 'K', 'T', 'E', 'X' };
+	static constexpr std::uint32_t VERSION = 2;
+	static constexpr size_t COMPONENTS = 4;
+#ifdef KENGINE_TEXTURE_KAISER_MIPS
+	static constexpr std::uint64_t MIP_FILTER = 1;
+#else
+	static constexpr std::uint64_t MIP_FILTER = 0;
+#endif
+
+	struct Header {
+		char magic[sizeof(MAGIC)];
+		std::uint32_t version;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levels;
+		std::uint32_t padding = 0; // Keeps the pixels 8-byte aligned
+		std::uint64_t sourceHash; // Of the source image's VFS stamp
+	};
+
+	// Backs the `data` of loaded textures, until they are released
+	struct Storage {
+		VFS::File file; // Cooked texture, mapped from its cache file
+		std::vector<unsigned char> buffer; // Cooked texture, if its cache file couldn't be written
+	};
+	static std::unordered_map<const void *, Storage> g_storages;
+	static std::mutex g_storagesMutex;
+
+	static putils::ThreadPool g_decoders(KENGINE_TEXTURE_DECODING_THREADS);
+
+	static std::uint64_t hashBytes(const void * data, size_t size) { // FNV-1a
+		std::uint64_t hash = 14695981039346656037ull;
+		const auto bytes = (const unsigned char *)data;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static size_t getLevelCount(int width, int height) {
+		size_t levels = 1;
+		while (width > 1 || height > 1) {
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+			++levels;
+		}
+		return levels;
+	}
+
+	static size_t getChainSize(int width, int height, size_t levels) {
+		size_t size = 0;
+		for (size_t i = 0; i < levels; ++i) {
+			size += (size_t)width * height * COMPONENTS;
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+		return size;
+	}
+
+	// Expands `count` pixels of `components` channels to RGBA. Grey becomes RGB, missing alpha becomes opaque
+	// Each case is a flat loop with a constant stride, which compilers vectorize. RGB, the most common, is shuffled by hand when SSSE3 is available
+	static void expandToRGBA(const unsigned char * src, unsigned char * dest, size_t count, int components) {
+		switch (components) {
+		case 4:
+			memcpy(dest, src, count * 4);
+			break;
+		case 3: {
+			size_t i = 0;
+#ifdef KENGINE_TEXTURE_SSSE3
+			// 4 pixels per iteration. 16 bytes are loaded for 12, so the last pixels are left to the scalar loop
+			const auto shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			const auto alpha = _mm_set1_epi32((int)0xff000000);
+			for (; i + 6 <= count; i += 4) {
+				const auto rgb = _mm_loadu_si128((const __m128i *)(src + i * 3));
+				_mm_storeu_si128((__m128i *)(dest + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+			}
+#endif
+			for (; i < count; ++i) {
+				dest[i * 4 + 0] = src[i * 3 + 0];
+				dest[i * 4 + 1] = src[i * 3 + 1];
+				dest[i * 4 + 2] = src[i * 3 + 2];
+				dest[i * 4 + 3] = 255;
+			}
+			break;
+		}
+		case 2:
+			for (size_t i = 0; i < count; ++i) {
+				dest[i * 4 + 0] = dest[i * 4 + 1] = dest[i * 4 + 2] = src[i * 2 + 0];
+				dest[i * 4 + 3] = src[i * 2 + 1];
+			}
+			break;
+		case 1:
+			for (size_t i = 0; i < count; ++i) {
+				dest[i * 4 + 0] = dest[i * 4 + 1] = dest[i * 4 + 2] = src[i];
+				dest[i * 4 + 3] = 255;
+			}
+			break;
+		default:
+			assert(false);
+		}
+	}
+
+#ifdef KENGINE_TEXTURE_KAISER_MIPS
+	// Kaiser-windowed sinc, halving the resolution. Taps are at +-0.5, 1.5, 2.5 and 3.5 source pixels from each destination pixel's center
+	static constexpr int KAISER_TAPS = 8;
+
+	static const float * getKaiserWeights() {
+		static const auto weights = [] {
+			const auto bessel0 = [](double x) { // Modified Bessel function of the first kind, order 0
+				double sum = 1, term = 1;
+				for (int k = 1; k < 16; ++k) {
+					term *= (x / (2 * k)) * (x / (2 * k));
+					sum += term;
+				}
+				return sum;
+			};
+
+			static constexpr double alpha = 4;
+			static constexpr double pi = 3.14159265358979323846;
+
+			std::array<float, KAISER_TAPS> ret;
+			double total = 0;
+			for (int i = 0; i < KAISER_TAPS; ++i) {
+				const auto x = i - KAISER_TAPS / 2 + .5; // In source pixels
+				const auto sinc = std::sin(pi * x / 2) / (pi * x / 2);
+				const auto r = x / (KAISER_TAPS / 2);
+				const auto window = bessel0(alpha * std::sqrt(1 - r * r)) / bessel0(alpha);
+				ret[i] = (float)(sinc * window);
+				total += ret[i];
+			}
+			for (auto & w : ret)
+				w = (float)(w / total);
+			return ret;
+		}();
+		return weights.data();
+	}
+
+	// Separable Kaiser filter: horizontally into `tmp`, then vertically. Edges are clamped
+	static void downsample(const unsigned char * src, int width, int height, unsigned char * dest) {
+		const auto destWidth = std::max(1, width / 2);
+		const auto destHeight = std::max(1, height / 2);
+		const auto weights = getKaiserWeights();
+
+		std::vector<float> tmp((size_t)destWidth * height * COMPONENTS);
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < destWidth; ++x) {
+				float sum[COMPONENTS] = {};
+				for (int i = 0; i < KAISER_TAPS; ++i) {
+					const auto srcX = std::clamp(x * 2 - KAISER_TAPS / 2 + 1 + i, 0, width - 1);
+					for (size_t c = 0; c < COMPONENTS; ++c)
+						sum[c] += weights[i] * src[((size_t)y * width + srcX) * COMPONENTS + c];
+				}
+				for (size_t c = 0; c < COMPONENTS; ++c)
+					tmp[((size_t)y * destWidth + x) * COMPONENTS + c] = sum[c];
+			}
+
+		for (int y = 0; y < destHeight; ++y)
+			for (int x = 0; x < destWidth; ++x) {
+				float sum[COMPONENTS] = {};
+				for (int i = 0; i < KAISER_TAPS; ++i) {
+					const auto srcY = std::clamp(y * 2 - KAISER_TAPS / 2 + 1 + i, 0, height - 1);
+					for (size_t c = 0; c < COMPONENTS; ++c)
+						sum[c] += weights[i] * tmp[((size_t)srcY * destWidth + x) * COMPONENTS + c];
+				}
+				for (size_t c = 0; c < COMPONENTS; ++c) // Negative lobes may overshoot
+					dest[((size_t)y * destWidth + x) * COMPONENTS + c] = (unsigned char)std::clamp(sum[c] + .5f, 0.f, 255.f);
+			}
+	}
+#else
+	// 2x2 box filter. Odd sizes clamp the last row and column
+	static void downsample(const unsigned char * src, int width, int height, unsigned char * dest) {
+		const auto destWidth = std::max(1, width / 2);
+		const auto destHeight = std::max(1, height / 2);
+
+		for (int y = 0; y < destHeight; ++y) {
+			const auto y0 = std::min(y * 2, height - 1);
+			const auto y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < destWidth; ++x) {
+				const auto x0 = std::min(x * 2, width - 1);
+				const auto x1 = std::min(x * 2 + 1, width - 1);
+				for (size_t c = 0; c < COMPONENTS; ++c) {
+					const unsigned sum =
+						src[((size_t)y0 * width + x0) * COMPONENTS + c] + src[((size_t)y0 * width + x1) * COMPONENTS + c] +
+						src[((size_t)y1 * width + x0) * COMPONENTS + c] + src[((size_t)y1 * width + x1) * COMPONENTS + c];
+					dest[((size_t)y * destWidth + x) * COMPONENTS + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+#endif
+
+	// Returns the header followed by all levels, or an empty vector if the source couldn't be decoded
+	static std::vector<unsigned char> cook(const VFS::File & source, std::uint64_t sourceHash) {
+		int width, height, components;
+		const auto pixels = stbi_load_from_memory((const stbi_uc *)source.data(), (int)source.size(), &width, &height, &components, 0);
+		if (pixels == nullptr)
+			return {};
+
+		Header header;
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.width = width;
+		header.height = height;
+		header.levels = (std::uint32_t)getLevelCount(width, height);
+		header.sourceHash = sourceHash;
+
+		std::vector<unsigned char> cooked(sizeof(Header) + getChainSize(width, height, header.levels));
+		memcpy(cooked.data(), &header, sizeof(header));
+
+		auto level = cooked.data() + sizeof(Header);
+		expandToRGBA(pixels, level, (size_t)width * height, components);
+		stbi_image_free(pixels);
+
+		for (size_t i = 1; i < header.levels; ++i) {
+			const auto next = level + (size_t)width * height * COMPONENTS;
+			downsample(level, width, height, next);
+			level = next;
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		return cooked;
+	}
+
+	// Returns false if `data` was cooked from another version of the source
+	static bool isUpToDate(const void * data, size_t size, std::uint64_t sourceHash) {
+		Header header;
+		if (size < sizeof(header))
+			return false;
+		memcpy(&header, data, sizeof(header));
+		return header.sourceHash == sourceHash;
+	}
+
+	// Fills `texture` from cooked data, used in place. Returns false if it's corrupt. Staleness is checked by `isUpToDate`
+	static bool parse(const void * data, size_t size, Texture & texture) {
+		Header header;
+		if (size < sizeof(header))
+			return false;
+		memcpy(&header, data, sizeof(header));
+
+		if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+			header.width == 0 || header.height == 0 || header.levels != getLevelCount(header.width, header.height) ||
+			size - sizeof(header) < getChainSize(header.width, header.height, header.levels))
+			return false;
+
+		texture.data = (unsigned char *)data + sizeof(header); // Never written to, despite TextureDataComponent's non-const pointer
+		texture.width = header.width;
+		texture.height = header.height;
+		texture.levels = header.levels;
+		return true;
+	}
+
+	bool load(const char * file, Texture & texture) {
+		// Only the source's stamp is checked, so that up to date textures never read their source
+		// Builds may only ship the cooked texture, which is then used as is
+		std::uint64_t stamp = 0;
+		const bool hasSource = VFS::stamp(file, stamp);
+		const std::uint64_t settings[] = { VERSION, MIP_FILTER, stamp };
+		const auto sourceHash = hashBytes(settings, sizeof(settings));
+
+		Storage storage;
+		const auto cacheFile = std::string(file) + "." KENGINE_TEXTURE_CACHE_EXTENSION;
+		if (!storage.file.open(cacheFile.c_str()) || (hasSource && !isUpToDate(storage.file.data(), storage.file.size(), sourceHash)) || !parse(storage.file.data(), storage.file.size(), texture)) {
+			storage.file.close();
+
+			const VFS::File source(file);
+			if (!source.isOpen()) {
+				std::cerr << putils::termcolor::red << "[TextureCache] Failed to read " << file << '\n' << putils::termcolor::reset;
+				return false;
+			}
+
+			auto cooked = cook(source, sourceHash);
+			if (cooked.empty()) {
+				std::cerr << putils::termcolor::red << "[TextureCache] Failed to decode " << file << '\n' << putils::termcolor::reset;
+				return false;
+			}
+
+			if (!MappedFile::write(cacheFile.c_str(), cooked.data(), cooked.size()) || !storage.file.openLoose(cacheFile.c_str())) {
+				storage.file.close();
+				storage.buffer = std::move(cooked);
+			}
+
+			const auto parsed = storage.file.isOpen() ?
+				parse(storage.file.data(), storage.file.size(), texture) :
+				parse(storage.buffer.data(), storage.buffer.size(), texture);
+			assert(parsed);
+			if (!parsed)
+				return false;
+		}
+
+		std::lock_guard<std::mutex> lock(g_storagesMutex);
+		g_storages.emplace(texture.data, std::move(storage)); // Moving the mapping or buffer keeps `texture.data` valid
+		return true;
+	}
+
+	void loadAsync(const char * file, const std::function<void(const Texture & texture)> & onLoaded) {
+		g_decoders.runTask([file = std::string(file), onLoaded] {
+			Texture texture;
+			if (!load(file.c_str(), texture))
+				texture = Texture{};
+			onLoaded(texture);
+		});
+	}
+
+	void release(void * data) {
+		std::lock_guard<std::mutex> lock(g_storagesMutex);
+		g_storages.erase(data);
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+
+#ifndef KENGINE_TEXTURE_DECODING_THREADS
+# define KENGINE_TEXTURE_DECODING_THREADS 4
+#endif
+
+#ifndef KENGINE_TEXTURE_CACHE_EXTENSION
+# define KENGINE_TEXTURE_CACHE_EXTENSION "ktex"
+#endif
+
+namespace kengine {
+	// Decodes image files into RGBA textures with a full mip chain, cooked into a mappable file next to the source so later runs skip decoding
+	namespace TextureCache {
+		struct Texture {
+			void * data = nullptr; // RGBA, `levels` mip levels stored consecutively from the largest. Release with `release`
+			int width = 0;
+			int height = 0;
+			int levels = 0;
+		};
+
+		// Thread-safe. Returns false if `file` couldn't be decoded
+		bool load(const char * file, Texture & texture);
+
+		// Loads `file` on one of KENGINE_TEXTURE_DECODING_THREADS background threads, then calls `onLoaded` from that thread
+		// `onLoaded` takes ownership of the texture, whose `data` is nullptr if it couldn't be decoded
+		void loadAsync(const char * file, const std::function<void(const Texture & texture)> & onLoaded);
+
+		// Usable as TextureDataComponent::free
+		void release(void * data);
+	}
+}
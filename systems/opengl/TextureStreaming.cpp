@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "TextureStreaming.hpp"
+#include "RenderSnapshot.hpp"
+#include "Residency.hpp"
+#include "Uploader.hpp"
+
+#include "data/TextureDataComponent.hpp"
+
+#include "helpers/AssetHelper.hpp"
+
+namespace kengine::TextureStreaming {
+	int budget = KENGINE_TEXTURE_STREAMING_BUDGET;
+
+	static Stats g_stats;
+
+	struct Texture {
+		Entity::ID id;
+		TextureDataComponent data; // `data.textureID` points to `texture`
+		GLuint texture;
+		int firstLevel; // Uploaded first, and always resident
+		int baseLevel; // Largest resident level
+		int uploading = -1; // Level being uploaded, if any
+		int target = 0; // Largest level granted by the budget
+		float pixels = 0.f; // Largest screen size of the Entities drawn with the texture
+	};
+	static std::unordered_map<Entity::ID, Texture> g_textures; // Nodes never move, so `data.textureID` stays valid
+
+	// Bytes of levels [level, data.levels)
+	static size_t getBytes(const TextureDataComponent & data, int level) {
+		size_t bytes = 0;
+		for (; level < data.levels; ++level)
+			bytes += (size_t)std::max(1, data.width >> level) * std::max(1, data.height >> level) * data.components;
+		return bytes;
+	}
+
+	int getFirstLevel(Entity::ID id, const TextureDataComponent & textureData) {
+		if (textureData.levels <= 1 || textureData.data == nullptr)
+			return 0;
+		if (AssetHelper::getAssetPath(id) == nullptr)
+			return 0; // Only assets have their screen size tracked
+
+		int level = 0;
+		while (level < textureData.levels - 1 && std::max(textureData.width >> level, textureData.height >> level) > KENGINE_TEXTURE_STREAMING_MIN_SIZE)
+			++level;
+		return level;
+	}
+
+	void add(Entity::ID id, const TextureDataComponent & textureData, GLuint texture, int firstLevel) {
+		auto & streamed = g_textures[id];
+		streamed.id = id;
+		streamed.data = textureData;
+		streamed.texture = texture;
+		streamed.data.textureID = &streamed.texture;
+		streamed.firstLevel = streamed.baseLevel = streamed.target = firstLevel;
+	}
+
+	static void updateScreenSizes(const RenderSnapshot::Snapshot & snapshot) {
+		for (auto & [id, texture] : g_textures)
+			texture.pixels = 0.f;
+
+		static std::unordered_map<Entity::ID, float> modelSizes;
+		modelSizes.clear();
+		for (const auto & drawable : snapshot.drawables) {
+			if (drawable.model == Entity::INVALID_ID)
+				continue;
+
+			// Doesn't account for the cameras' directions, so textures are already sharp when they turn
+			auto & size = modelSizes[drawable.model];
+			for (const auto & camera : snapshot.cameras)
+				size = std::max(size, RenderSnapshot::getScreenSize(drawable, camera));
+		}
+
+		static std::vector<Entity::ID> textures;
+		for (const auto & [model, size] : modelSizes) {
+			textures.clear();
+			textures.push_back(model); // Sprites are drawn with their model's texture
+			AssetHelper::getDependencies(model, textures);
+
+			for (const auto id : textures) {
+				const auto it = g_textures.find(id);
+				if (it != g_textures.end())
+					it->second.pixels = std::max(it->second.pixels, size);
+			}
+		}
+	}
+
+	// Largest level worth sampling for the texture's screen size
+	static int getWantedLevel(const Texture & texture) {
+		if (texture.pixels <= 0.f)
+			return texture.firstLevel;
+
+		const auto size = (float)std::max(texture.data.width, texture.data.height);
+		const auto level = (int)std::floor(std::log2(size / texture.pixels));
+		return std::clamp(level, 0, texture.firstLevel);
+	}
+
+	// Grants wanted levels to the textures taking up the most pixels first, then lets others keep levels they no longer need while the budget allows
+	static void updateTargets(std::vector<Texture *> & sorted) {
+		const auto budgetBytes = (size_t)std::max(budget, 0) * 1024 * 1024;
+
+		size_t spent = 0;
+		for (const auto texture : sorted)
+			spent += getBytes(texture->data, texture->firstLevel);
+
+		for (const auto texture : sorted) {
+			const auto wanted = getWantedLevel(*texture);
+			g_stats.wanted += getBytes(texture->data, wanted);
+
+			const auto firstBytes = getBytes(texture->data, texture->firstLevel);
+			texture->target = texture->firstLevel;
+			for (int level = wanted; level < texture->firstLevel; ++level) {
+				const auto extra = getBytes(texture->data, level) - firstBytes;
+				if (spent + extra <= budgetBytes) {
+					texture->target = level;
+					spent += extra;
+					break;
+				}
+			}
+		}
+
+		// Avoids dropping and uploading levels again when an Entity moves back and forth around a level's threshold
+		for (const auto texture : sorted) {
+			if (texture->baseLevel >= texture->target)
+				continue;
+
+			const auto extra = getBytes(texture->data, texture->baseLevel) - getBytes(texture->data, texture->target);
+			if (spent + extra <= budgetBytes) {
+				texture->target = texture->baseLevel;
+				spent += extra;
+			}
+		}
+	}
+
+	// Releases the levels larger than `target`
+	static void drop(Texture & texture) {
+		glBindTexture(GL_TEXTURE_2D, texture.texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.target);
+		for (int level = texture.baseLevel; level < texture.target; ++level)
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+		texture.baseLevel = texture.target;
+		Residency::addTexture(texture.id, texture.data, texture.baseLevel);
+	}
+
+	void update(const RenderSnapshot::Snapshot & snapshot) {
+		g_stats = Stats{};
+		g_stats.textures = g_textures.size();
+		g_stats.budget = (size_t)std::max(budget, 0) * 1024 * 1024;
+		if (g_textures.empty())
+			return;
+
+		updateScreenSizes(snapshot);
+
+		static std::vector<Texture *> sorted;
+		sorted.clear();
+		for (auto & [id, texture] : g_textures)
+			sorted.push_back(&texture);
+		std::sort(sorted.begin(), sorted.end(), [](const Texture * lhs, const Texture * rhs) { return lhs->pixels > rhs->pixels; });
+
+		updateTargets(sorted);
+
+		// In order of screen size, so the largest textures on screen get the Uploader's budget first
+		for (const auto texture : sorted) {
+			if (texture->uploading < 0 && texture->target < texture->baseLevel)
+				texture->uploading = texture->baseLevel - 1; // One level at a time, so textures sharpen progressively
+
+			if (texture->uploading >= 0) {
+				GLuint unused;
+				if (Uploader::uploadTexture(texture->id, texture->data, unused, texture->uploading, texture->uploading + 1)) {
+					texture->baseLevel = texture->uploading;
+					texture->uploading = -1;
+					Residency::addTexture(texture->id, texture->data, texture->baseLevel);
+				}
+				else
+					++g_stats.pending;
+			}
+			else if (texture->target > texture->baseLevel)
+				drop(*texture);
+
+			g_stats.bytes += getBytes(texture->data, texture->baseLevel);
+		}
+	}
+
+	void remove(Entity::ID id) {
+		const auto it = g_textures.find(id);
+		if (it == g_textures.end())
+			return;
+
+		auto & texture = it->second;
+		if (texture.uploading >= 0)
+			Uploader::cancel(id);
+		if (texture.data.data != nullptr && texture.data.free != nullptr)
+			texture.data.free(texture.data.data);
+		g_textures.erase(it);
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
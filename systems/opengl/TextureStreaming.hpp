@@ -0,0 +1,52 @@
+#pragma once
+
+#include <gl/glew.h>
+#include <GL/GL.h>
+
+#include "Entity.hpp"
+
+#ifndef KENGINE_TEXTURE_STREAMING_BUDGET
+# define KENGINE_TEXTURE_STREAMING_BUDGET 256 // Megabytes of streamed texture levels kept on the GPU
+#endif
+
+#ifndef KENGINE_TEXTURE_STREAMING_MIN_SIZE
+# define KENGINE_TEXTURE_STREAMING_MIN_SIZE 64 // Textures are first uploaded from their largest level no larger than this, in pixels
+#endif
+
+namespace kengine {
+	struct TextureDataComponent;
+
+	namespace RenderSnapshot {
+		struct Snapshot;
+	}
+
+	// Uploads the small levels of mip-mapped textures first, then streams larger ones in as the Entities using them take up more of the screen
+	namespace TextureStreaming {
+		struct Stats {
+			size_t textures = 0; // Streamed
+			size_t pending = 0; // Textures with a level being uploaded
+			size_t bytes = 0; // Resident levels of streamed textures
+			size_t wanted = 0; // Levels streamed textures would need to match their screen size
+			size_t budget = 0;
+		};
+
+		// Megabytes. Adjustable at runtime, under "Render/Texture streaming"
+		extern int budget;
+
+		// Returns the level `id`'s `textureData` should first be uploaded from, or 0 if it isn't streamed (single level, or not an AssetHelper asset)
+		int getFirstLevel(Entity::ID id, const TextureDataComponent & textureData);
+
+		// Called by the OpenGLSystem once `textureData`'s levels from `firstLevel` are resident in `texture`
+		// Takes ownership of `textureData.data`, which is kept to upload larger levels
+		void add(Entity::ID id, const TextureDataComponent & textureData, GLuint texture, int firstLevel);
+
+		// Called once per frame by the OpenGLSystem, after Residency::update
+		// Computes each streamed texture's screen size from `snapshot`, then uploads the levels it needs, or drops those it doesn't, within the budget
+		void update(const RenderSnapshot::Snapshot & snapshot);
+
+		// Called when the texture is removed or evicted. Releases its data
+		void remove(Entity::ID id);
+
+		const Stats & getStats();
+	}
+}
@@ -0,0 +1,324 @@
+#include <cfloat>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "Uploader.hpp"
+#include "Instancing.hpp"
+
+#include "data/ModelDataComponent.hpp"
+#include "data/TextureDataComponent.hpp"
+#include "data/OpenGLModelComponent.hpp"
+
+namespace kengine::Uploader {
+	static Stats g_stats;
+
+	// Orphaned at the start of each frame, so staging never waits for the previous frame's copies
+	static GLuint g_staging = 0;
+	static size_t g_stagingCapacity = 0;
+	static size_t g_stagingOffset = 0;
+
+	struct Job {
+		bool started = false;
+		OpenGLModelComponent model;
+		GLuint texture = 0;
+		bool ownsTexture = false; // Generated by the Uploader, rather than provided by the TextureDataComponent
+		size_t mesh = 0; // Mesh being copied
+		size_t progress = 0; // Bytes of the current mesh (vertices then indices) or rows of the current texture level already copied
+		int level = 0; // Texture level being copied
+		int firstLevel = 0; // Texture levels being uploaded, [firstLevel, endLevel)
+		int endLevel = 0;
+		size_t levelOffset = 0; // Offset of the current texture level in the TextureDataComponent's data
+		GLsync fence = nullptr; // Set once all copies have been issued
+	};
+	static std::unordered_map<Entity::ID, Job> g_jobs;
+
+	static void release(Job & job) {
+		if (job.fence != nullptr)
+			glDeleteSync(job.fence);
+
+		for (const auto & mesh : job.model.meshes) {
+			Instancing::forget(mesh.vertexArrayObject);
+			glDeleteVertexArrays(1, &mesh.vertexArrayObject);
+			glDeleteBuffers(1, &mesh.vertexBuffer);
+			glDeleteBuffers(1, &mesh.indexBuffer);
+		}
+
+		if (job.ownsTexture)
+			glDeleteTextures(1, &job.texture);
+	}
+
+	void beginFrame() {
+		g_stats.bytes = 0;
+		g_stats.pending = g_jobs.size();
+
+		if (g_staging == 0)
+			glGenBuffers(1, &g_staging);
+		else if (g_stagingOffset == 0)
+			return;
+
+		g_stagingCapacity = std::max(g_stagingCapacity, (size_t)KENGINE_UPLOAD_BUDGET);
+		glBindBuffer(GL_COPY_READ_BUFFER, g_staging);
+		glBufferData(GL_COPY_READ_BUFFER, g_stagingCapacity, nullptr, GL_STREAM_DRAW);
+		g_stagingOffset = 0;
+	}
+
+	static size_t getBudgetLeft() {
+		return g_stagingOffset < KENGINE_UPLOAD_BUDGET ? KENGINE_UPLOAD_BUDGET - g_stagingOffset : 0;
+	}
+
+	// Copies `size` bytes to the staging buffer, which is left bound to GL_COPY_READ_BUFFER, and returns their offset in it
+	static size_t stage(const void * data, size_t size) {
+		glBindBuffer(GL_COPY_READ_BUFFER, g_staging);
+		if (g_stagingOffset + size > g_stagingCapacity) { // Only happens for a chunk larger than the whole budget, staged alone
+			assert(g_stagingOffset == 0);
+			g_stagingCapacity = size;
+			glBufferData(GL_COPY_READ_BUFFER, g_stagingCapacity, nullptr, GL_STREAM_DRAW);
+		}
+
+		const auto offset = g_stagingOffset;
+		// The range was orphaned at the start of the frame and hasn't been written since, so no synchronization is needed
+		const auto dest = glMapBufferRange(GL_COPY_READ_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		memcpy(dest, data, size);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+		g_stagingOffset += size;
+		g_stats.bytes += size;
+		return offset;
+	}
+
+	static bool isComplete(Job & job) {
+		if (job.fence == nullptr)
+			job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		if (glClientWaitSync(job.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+			return false;
+
+		glDeleteSync(job.fence);
+		job.fence = nullptr;
+		return true;
+	}
+
+	static void createModel(Job & job, const ModelDataComponent & modelData) {
+		auto & openGL = job.model;
+		openGL.vertexRegisterFunc = modelData.vertexRegisterFunc;
+
+		putils::Point3f min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		putils::Point3f max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (const auto & meshData : modelData.meshes) {
+			const auto vertices = (const char *)meshData.vertices.data;
+			for (size_t i = 0; i < meshData.vertices.nbElements; ++i) {
+				float pos[3];
+				memcpy(pos, vertices + i * meshData.vertices.elementSize, sizeof(pos));
+				min = { std::min(min.x, pos[0]), std::min(min.y, pos[1]), std::min(min.z, pos[2]) };
+				max = { std::max(max.x, pos[0]), std::max(max.y, pos[1]), std::max(max.z, pos[2]) };
+			}
+
+			// Storage is allocated now and filled by copies from the staging buffer over the following frames
+			OpenGLModelComponent::Mesh meshInfo;
+			glGenVertexArrays(1, &meshInfo.vertexArrayObject);
+			Instancing::forget(meshInfo.vertexArrayObject); // In case the name was recycled without going through Instancing::forget
+			glBindVertexArray(meshInfo.vertexArrayObject);
+
+			glGenBuffers(1, &meshInfo.vertexBuffer);
+			glBindBuffer(GL_ARRAY_BUFFER, meshInfo.vertexBuffer);
+			glBufferData(GL_ARRAY_BUFFER, meshData.vertices.nbElements * meshData.vertices.elementSize, nullptr, GL_STATIC_DRAW);
+
+			glGenBuffers(1, &meshInfo.indexBuffer);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshInfo.indexBuffer);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshData.indices.nbElements * meshData.indices.elementSize, nullptr, GL_STATIC_DRAW);
+
+			modelData.vertexRegisterFunc();
+
+			meshInfo.nbIndices = meshData.indices.nbElements;
+			meshInfo.indexType = meshData.indexType;
+
+			for (const auto & lod : meshData.lods)
+				meshInfo.lods.push_back({ lod.firstIndex, lod.nbIndices });
+			if (!meshInfo.lods.empty()) // The index buffer also holds the coarser levels
+				meshInfo.nbIndices = meshInfo.lods[0].nbIndices;
+
+			openGL.meshes.push_back(meshInfo);
+		}
+		glBindVertexArray(0);
+
+		if (min.x <= max.x)
+			openGL.boundingBox = { min, { max.x - min.x, max.y - min.y, max.z - min.z } };
+	}
+
+	static void copyModel(Job & job, const ModelDataComponent & modelData) {
+		while (job.mesh < modelData.meshes.size()) {
+			const auto & meshData = modelData.meshes[job.mesh];
+			const auto & meshInfo = job.model.meshes[job.mesh];
+
+			const auto vertexBytes = meshData.vertices.nbElements * meshData.vertices.elementSize;
+			const auto indexBytes = meshData.indices.nbElements * meshData.indices.elementSize;
+			if (job.progress >= vertexBytes + indexBytes) {
+				++job.mesh;
+				job.progress = 0;
+				continue;
+			}
+
+			const auto budget = getBudgetLeft();
+			if (budget == 0)
+				return;
+
+			const bool vertices = job.progress < vertexBytes;
+			const auto begin = vertices ? job.progress : job.progress - vertexBytes;
+			const auto size = std::min((vertices ? vertexBytes : indexBytes) - begin, budget);
+			const auto src = (const char *)(vertices ? meshData.vertices.data : meshData.indices.data) + begin;
+
+			const auto staged = stage(src, size);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, vertices ? meshInfo.vertexBuffer : meshInfo.indexBuffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, staged, begin, size);
+
+			job.progress += size;
+		}
+	}
+
+	bool uploadModel(Entity::ID id, const ModelDataComponent & modelData, OpenGLModelComponent & openGL) {
+		auto & job = g_jobs[id];
+		if (!job.started) {
+			createModel(job, modelData);
+			job.started = true;
+		}
+
+		if (job.fence == nullptr) {
+			copyModel(job, modelData);
+			if (job.mesh < modelData.meshes.size())
+				return false;
+		}
+
+		if (!isComplete(job))
+			return false;
+
+		openGL = std::move(job.model);
+		g_jobs.erase(id);
+		return true;
+	}
+
+	static GLenum getFormat(int components) {
+		switch (components) {
+		case 1:
+			return GL_RED;
+		case 3:
+			return GL_RGB;
+		case 4:
+			return GL_RGBA;
+		default:
+			assert(false);
+			return GL_RGBA;
+		}
+	}
+
+	static int getLevelSize(int size, int level) {
+		return std::max(1, size >> level);
+	}
+
+	static void createTexture(Job & job, const TextureDataComponent & textureData, int firstLevel, int endLevel) {
+		job.firstLevel = job.level = firstLevel;
+		job.endLevel = endLevel < 0 ? textureData.levels : std::min(endLevel, textureData.levels);
+		for (int level = 0; level < firstLevel; ++level)
+			job.levelOffset += (size_t)getLevelSize(textureData.width, level) * getLevelSize(textureData.height, level) * textureData.components;
+
+		job.texture = *textureData.textureID;
+		if (job.texture == (GLuint)-1) {
+			glGenTextures(1, &job.texture);
+			job.ownsTexture = true;
+		}
+
+		if (textureData.data == nullptr)
+			return;
+
+		const auto format = getFormat(textureData.components);
+		glBindTexture(GL_TEXTURE_2D, job.texture);
+		for (int level = job.firstLevel; level < job.endLevel; ++level)
+			glTexImage2D(GL_TEXTURE_2D, level, format, getLevelSize(textureData.width, level), getLevelSize(textureData.height, level), 0, format, GL_UNSIGNED_BYTE, nullptr);
+		if (textureData.levels > 1)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, textureData.levels - 1);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	static void copyTexture(Job & job, const TextureDataComponent & textureData) {
+		const auto format = getFormat(textureData.components);
+
+		glBindTexture(GL_TEXTURE_2D, job.texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are tightly packed, whatever their size
+
+		while (job.level < job.endLevel) {
+			const auto width = getLevelSize(textureData.width, job.level);
+			const auto height = (size_t)getLevelSize(textureData.height, job.level);
+			const auto rowSize = (size_t)width * textureData.components;
+
+			if (rowSize == 0 || job.progress == height) {
+				job.levelOffset += rowSize * height;
+				job.progress = 0;
+				++job.level;
+				continue;
+			}
+
+			auto rows = std::min(height - job.progress, getBudgetLeft() / rowSize);
+			if (rows == 0) {
+				if (g_stagingOffset > 0)
+					break;
+				rows = 1; // A single row exceeds the budget, let it through alone
+			}
+
+			const auto staged = stage((const char *)textureData.data + job.levelOffset + job.progress * rowSize, rows * rowSize);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_staging);
+			glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, (GLint)job.progress, width, (GLsizei)rows, format, GL_UNSIGNED_BYTE, (const void *)staged);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			job.progress += rows;
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		if (job.level == job.endLevel && textureData.levels == 1)
+			glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	bool uploadTexture(Entity::ID id, const TextureDataComponent & textureData, GLuint & texture, int firstLevel, int endLevel) {
+		auto & job = g_jobs[id];
+		if (!job.started) {
+			createTexture(job, textureData, firstLevel, endLevel);
+			job.started = true;
+		}
+
+		if (textureData.data != nullptr && job.fence == nullptr) {
+			copyTexture(job, textureData);
+			if (job.level < job.endLevel)
+				return false;
+		}
+
+		if (textureData.data != nullptr && !isComplete(job))
+			return false;
+
+		if (textureData.levels > 1) { // Levels above the first one uploaded may not exist
+			glBindTexture(GL_TEXTURE_2D, job.texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.firstLevel);
+		}
+
+		texture = job.texture;
+		g_jobs.erase(id);
+		return true;
+	}
+
+	void cancel(Entity::ID id) {
+		// Immediately, as `id` may be reused for another asset before the next frame
+		const auto it = g_jobs.find(id);
+		if (it == g_jobs.end())
+			return;
+		release(it->second);
+		g_jobs.erase(it);
+	}
+
+	const Stats & getStats() { return g_stats; }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <gl/glew.h>
+#include <GL/GL.h>
+
+#include "Entity.hpp"
+
+#ifndef KENGINE_UPLOAD_BUDGET
+# define KENGINE_UPLOAD_BUDGET (4 * 1024 * 1024) // Bytes of mesh and texture data staged per frame
+#endif
+
+namespace kengine {
+	struct ModelDataComponent;
+	struct TextureDataComponent;
+	struct OpenGLModelComponent;
+
+	namespace Uploader {
+		struct Stats {
+			size_t pending = 0; // Models and textures that aren't resident yet
+			size_t bytes = 0; // Staged this frame
+		};
+
+		// Called once per frame by the OpenGLSystem, before any upload
+		void beginFrame();
+
+		// Stages as much of `modelData` as the frame's budget allows and copies it to the model's buffers
+		// Returns true once all copies have completed, after filling `openGL`. `modelData` must stay valid until then
+		bool uploadModel(Entity::ID id, const ModelDataComponent & modelData, OpenGLModelComponent & openGL);
+
+		// Stages as many rows of `textureData`'s levels [firstLevel, endLevel) as the frame's budget allows and copies them to the texture
+		// A negative `endLevel` stands for all levels. Once complete, the texture's base level is `firstLevel`
+		// Returns true once all copies have completed, after setting `texture`. `textureData` must stay valid until then
+		bool uploadTexture(Entity::ID id, const TextureDataComponent & textureData, GLuint & texture, int firstLevel = 0, int endLevel = -1);
+
+		// Releases the GL objects of `id`'s unfinished upload, if any. Must be called on the GL thread, as soon as `id` is removed
+		void cancel(Entity::ID id);
+
+		const Stats & getStats();
+	}
+}
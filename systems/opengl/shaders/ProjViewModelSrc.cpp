@@ -5,13 +5,16 @@ namespace kengine::Shaders::src {
 #version 330
 
 layout (location = 0) in vec3 position;
+layout (location = 5) in mat4 instanceModel;
 
 uniform mat4 proj;
 uniform mat4 view;
 uniform mat4 model;
+uniform int instanced;
 
 void main() {
-    gl_Position = proj * view * model * vec4(position, 1.0);
+    mat4 m = instanced != 0 ? instanceModel : model;
+    gl_Position = proj * view * m * vec4(position, 1.0);
 }
         )";
 		}
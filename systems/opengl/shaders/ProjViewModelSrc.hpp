@@ -11,11 +11,13 @@ namespace kengine::Shaders::src {
 				putils::gl::Uniform<glm::mat4> _proj;
 				putils::gl::Uniform<glm::mat4> _view;
 				putils::gl::Uniform<glm::mat4> _model;
+				putils::gl::Uniform<bool> _instanced; // Use Instancing's per-instance matrices instead of _model
 
 				putils_reflection_attributes(
 					putils_reflection_attribute_private(&Uniforms::_proj), 
 					putils_reflection_attribute_private(&Uniforms::_view), 
-					putils_reflection_attribute_private(&Uniforms::_model)
+					putils_reflection_attribute_private(&Uniforms::_model),
+					putils_reflection_attribute_private(&Uniforms::_instanced)
 				);
 			};
 		}
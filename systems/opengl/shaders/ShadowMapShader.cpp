@@ -7,6 +7,7 @@
 #include "Entity.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Culling.hpp"
 #include "helpers/LightHelper.hpp"
 
 namespace kengine::Shaders {
@@ -163,10 +164,16 @@ namespace kengine::Shaders {
 
 		_lightPos = pos;
 		_farPlane = radius;
+		_casterPos = vPos;
+		_casterRadius = radius;
 
 		drawObjects();
 
 		putils::gl::setViewPort(params.viewPort);
 		glCullFace(GL_BACK);
 	}
-}
\ No newline at end of file
+
+	const std::vector<Entity::ID> & ShadowCubeShader::getCasters() const {
+		return Culling::getCasters(_casterPos, _casterRadius);
+	}
+}
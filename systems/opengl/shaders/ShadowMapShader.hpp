@@ -1,12 +1,13 @@
 #pragma once
 
+#include <vector>
 #include <glm/glm.hpp>
 #include "Point.hpp"
+#include "Entity.hpp"
 #include "opengl/Program.hpp"
 #include "DepthCubeSrc.hpp"
 
 namespace kengine {
-	class Entity;
 	struct DirLightComponent;
 	struct SpotLightComponent;
 	struct PointLightComponent;
@@ -42,16 +43,26 @@ namespace kengine::Shaders {
 
 		virtual void drawObjects() {}
 
+	protected:
+		// Entities within the current light's radius, shared by all shadow cube shaders
+		const std::vector<Entity::ID> & getCasters() const;
+
+	private:
+		glm::vec3 _casterPos;
+		float _casterRadius = 0.f;
+
 	protected:
 		putils::gl::Uniform<glm::mat4> _proj;
 		putils::gl::Uniform<glm::mat4> _view;
 		putils::gl::Uniform<glm::mat4> _model;
+		putils::gl::Uniform<bool> _instanced;
 
 	public:
 		putils_reflection_attributes(
 			putils_reflection_attribute_private(&ShadowCubeShader::_proj),
 			putils_reflection_attribute_private(&ShadowCubeShader::_view),
-			putils_reflection_attribute_private(&ShadowCubeShader::_model)
+			putils_reflection_attribute_private(&ShadowCubeShader::_model),
+			putils_reflection_attribute_private(&ShadowCubeShader::_instanced)
 		);
 
 		putils_reflection_parents(
@@ -11,7 +11,8 @@
 
 #include "functions/OnEntityCreated.hpp"
 
-#include "stb_image.h"
+#include "helpers/AssetHelper.hpp"
+#include "systems/opengl/TextureCache.hpp"
 
 namespace kengine {
 	static EntityManager * g_em;
@@ -41,33 +42,29 @@ namespace kengine {
 		auto & graphics = e.get<GraphicsComponent>();
 		const auto & file = graphics.appearance;
 
-		for (const auto &[e, model] : g_em->getEntities<TextureModelComponent>())
-			if (model.file == file) {
-				graphics.model = e.id;
-				return;
-			}
+		graphics.model = AssetHelper::find<TextureModelComponent>(file.c_str());
+		if (graphics.model != Entity::INVALID_ID)
+			return;
 
-		int width, height, components;
-		const auto data = stbi_load(file.c_str(), &width, &height, &components, 0);
-		if (data == nullptr)
+		TextureCache::Texture texture;
+		if (!TextureCache::load(file.c_str(), texture))
 			return; // Not supported image type
 
-		*g_em += [&](Entity & e) {
-			graphics.model = e.id;
-
+		graphics.model = AssetHelper::findOrCreate<TextureModelComponent>(*g_em, file.c_str(), [&](Entity & e) {
 			auto & comp = e.attach<TextureModelComponent>();
 			comp.file = file;
 
 			TextureDataComponent textureLoader; {
 				textureLoader.textureID = &comp.texture;
 
-				textureLoader.data = data;
-				textureLoader.width = width;
-				textureLoader.height = height;
-				textureLoader.components = components;
+				textureLoader.data = texture.data;
+				textureLoader.width = texture.width;
+				textureLoader.height = texture.height;
+				textureLoader.components = 4;
+				textureLoader.levels = texture.levels;
 
-				textureLoader.free = stbi_image_free;
+				textureLoader.free = TextureCache::release;
 			} e += textureLoader;
-		};
+		});
 	}
 }
@@ -11,6 +11,7 @@
 #include "systems/opengl/shaders/ApplyTransparencySrc.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Culling.hpp"
 
 static inline const char * vert = R"(
 #version 330
@@ -164,6 +165,8 @@ namespace kengine {
 		_view = params.view;
 		_proj = params.proj;
 		for (const auto &[e, graphics, transform, sprite] : _em.getEntities<GraphicsComponent, TransformComponent, SpriteComponent3D>()) {
+			if (!Culling::isVisible(e.id))
+				continue;
 			_entityID = (float)e.id;
 			drawObject(_em, graphics, transform, uniforms);
 		}
@@ -1,6 +1,5 @@
 #include "MagicaVoxelSystem.hpp"
 
-#include <filesystem>
 #include <unordered_map>
 #include <fstream>
 
@@ -18,6 +17,9 @@
 
 #include "functions/OnEntityCreated.hpp"
 
+#include "helpers/AssetHelper.hpp"
+#include "helpers/VFS.hpp"
+
 #include "string.hpp"
 #include "Export.hpp"
 #include "file_extension.hpp"
@@ -57,17 +59,9 @@ namespace kengine {
 		e += PolyVoxObjectComponent{};
 		e += DefaultShadowComponent{};
 
-		graphics.model = Entity::INVALID_ID;
-		for (const auto &[e, model] : g_em->getEntities<ModelComponent>())
-			if (model.file == graphics.appearance) {
-				graphics.model = e.id;
-				return;
-			}
-
-		*g_em += [&](Entity & e) {
+		graphics.model = AssetHelper::findOrCreate<ModelComponent>(*g_em, graphics.appearance.c_str(), [&](Entity & e) {
 			e += ModelComponent{ graphics.appearance.c_str() };
-			graphics.model = e.id;
-		};
+		});
 	}
 
 	namespace detailMagicaVoxel {
@@ -87,7 +81,9 @@ namespace kengine {
 	};
 
 	// declarations
-	static void loadBinaryModel(Entity & e, const char * binaryFile);
+	static void reloadModel(Entity & e);
+	static MagicaVoxel::ChunkContent::Size loadModelData(Entity & e);
+	static MagicaVoxel::ChunkContent::Size loadBinaryModel(Entity & e, const char * binaryFile);
 	static MeshInfo loadVoxModel(const char * f);
 	static ModelDataComponent generateModelData(Entity & e, const MeshType & mesh);
 	static void serialize(const char * f, const ModelDataComponent & modelData, const MagicaVoxel::ChunkContent::Size & size);
@@ -98,12 +94,25 @@ namespace kengine {
 		if (putils::file_extension(f) != "vox")
 			return;
 
+		AssetHelper::add<ModelComponent>(f, e.id);
+		AssetHelper::setReloader(e.id, reloadModel);
+
+		const auto size = loadModelData(e);
+		applyOffset(e, size);
+	}
+
+	// The ModelComponent was already offset when the model was first loaded
+	static void reloadModel(Entity & e) {
+		loadModelData(e);
+	}
+
+	// Attaches a ModelDataComponent and returns the model's size in voxels
+	static MagicaVoxel::ChunkContent::Size loadModelData(Entity & e) {
+		const auto & f = e.get<ModelComponent>().file.c_str();
 		const putils::string<256> binaryFile("%s.bin", f);
 
-		if (std::filesystem::exists(binaryFile.c_str())) {
-			loadBinaryModel(e, binaryFile.c_str());
-			return;
-		}
+		if (VFS::exists(binaryFile.c_str()))
+			return loadBinaryModel(e, binaryFile.c_str());
 
 #ifndef KENGINE_NDEBUG
 		std::cout << putils::termcolor::green << "[MagicaVoxel] Loading " << putils::termcolor::cyan << f << putils::termcolor::green << "..." << putils::termcolor::reset;
@@ -116,11 +125,10 @@ namespace kengine {
 		serialize(binaryFile, modelData, meshInfo.size);
 		e += std::move(modelData);
 
-		applyOffset(e, meshInfo.size);
-
 #ifndef KENGINE_NDEBUG
 		std::cout << putils::termcolor::green << " Done.\n" << putils::termcolor::reset;
 #endif
+		return meshInfo.size;
 	}
 
 	// declarations
@@ -133,7 +141,7 @@ namespace kengine {
 	}
 	//
 	static MeshInfo loadVoxModel(const char * f) {
-		std::ifstream stream(f, std::ios::binary);
+		VFS::InputStream stream(f);
 		assert(stream);
 		checkHeader(stream);
 
@@ -220,9 +228,11 @@ namespace kengine {
 
 
 	static void applyOffset(Entity & e, const MagicaVoxel::ChunkContent::Size & size) {
-		auto & box = e.get<ModelComponent>().boundingBox;
+		auto & model = e.get<ModelComponent>();
+		auto & box = model.boundingBox;
 		box.position.x += size.x / 2.f * box.size.x;
 		box.position.z += size.y / 2.f * box.size.z;
+		model.markDirty();
 	}
 
 	static void serialize(const char * f, const ModelDataComponent & modelData, const MagicaVoxel::ChunkContent::Size & size) {
@@ -257,7 +267,7 @@ namespace kengine {
 	// declarations
 	static void unserialize(const char * f, ModelDataComponent::Mesh & meshData, MagicaVoxel::ChunkContent::Size & size);
 	//
-	static void loadBinaryModel(Entity & e, const char * binaryFile) {
+	static MagicaVoxel::ChunkContent::Size loadBinaryModel(Entity & e, const char * binaryFile) {
 		MagicaVoxel::ChunkContent::Size size;
 
 		ModelDataComponent modelData;
@@ -266,15 +276,12 @@ namespace kengine {
 		modelData.free = release(e.id, *g_em);
 		modelData.vertexRegisterFunc = putils::gl::setPolyvoxVertexType<MeshType::VertexType>;
 		e += std::move(modelData);
-
-		auto & box = e.get<ModelComponent>().boundingBox;
-		box.position.x += size.x / 2.f * box.size.x;
-		box.position.z += size.y / 2.f * box.size.z;
+		return size;
 	}
 
 	static void unserialize(const char * f, ModelDataComponent::Mesh & meshData, MagicaVoxel::ChunkContent::Size & size) {
-		std::ifstream file(f, std::ofstream::binary);
-		assert(f);
+		VFS::InputStream file(f);
+		assert(file);
 
 		const auto parse = [&](auto & val) {
 			file.read((char *)&val, sizeof(val));
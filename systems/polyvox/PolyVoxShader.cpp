@@ -11,24 +11,46 @@
 #include "systems/opengl/shaders/ApplyTransparencySrc.hpp"
 
 #include "systems/opengl/ShaderHelper.hpp"
+#include "systems/opengl/Culling.hpp"
+#include "systems/opengl/Instancing.hpp"
+#include "systems/opengl/RenderSnapshot.hpp"
 
 static inline const char * vert = R"(
 #version 330
 
 layout (location = 0) in vec3 position;
 layout (location = 2) in vec3 color;
+layout (location = 5) in mat4 instanceModel;
+layout (location = 9) in vec4 instanceColor;
+layout (location = 10) in float instanceEntityID;
 
 uniform mat4 proj;
 uniform mat4 view;
 uniform mat4 model;
 uniform vec3 viewPos;
+uniform int instanced;
+
+uniform vec4 entityColor;
+uniform float entityID;
 
 out vec4 WorldPosition;
 out vec3 EyeRelativePos;
 out vec3 Color;
+out vec4 EntityColor;
+flat out float EntityID;
 
 void main() {
-	WorldPosition = model * vec4(position, 1.0);
+	if (instanced != 0) {
+		WorldPosition = instanceModel * vec4(position, 1.0);
+		EntityColor = instanceColor;
+		EntityID = instanceEntityID;
+	}
+	else {
+		WorldPosition = model * vec4(position, 1.0);
+		EntityColor = entityColor;
+		EntityID = entityID;
+	}
+
 	EyeRelativePos = WorldPosition.xyz - viewPos;
 	Color = color;
 	//Color = vec3(1.0); // This is pretty
@@ -43,9 +65,8 @@ static inline const char * frag = R"(
 in vec4 WorldPosition;
 in vec3 EyeRelativePos;
 in vec3 Color;
-
-uniform vec4 color;
-uniform float entityID;
+in vec4 EntityColor;
+flat in float EntityID;
 
 layout (location = 0) out vec4 gposition;
 layout (location = 1) out vec3 gnormal;
@@ -55,12 +76,12 @@ layout (location = 3) out float gentityID;
 void applyTransparency(float a);
 
 void main() {
-	applyTransparency(color.a);
+	applyTransparency(EntityColor.a);
 
     gposition = WorldPosition;
     gnormal = -normalize(cross(dFdy(EyeRelativePos), dFdx(EyeRelativePos)));
-    gcolor = vec4(Color * color.rgb, 0.0);
-	gentityID = entityID;
+    gcolor = vec4(Color * EntityColor.rgb, 0.0);
+	gentityID = EntityID;
 }
         )";
 
@@ -87,22 +108,26 @@ namespace kengine {
 		_proj = params.proj;
 		_viewPos = params.camPos;
 
-		for (const auto &[e, poly, graphics, transform] : _em.getEntities<PolyVoxObjectComponent, GraphicsComponent, TransformComponent>()) {
-			if (graphics.model == Entity::INVALID_ID)
-				continue;
-
-			const auto & modelInfoEntity = _em.getEntity(graphics.model);
-			if (!modelInfoEntity.has<OpenGLModelComponent>() || !modelInfoEntity.has<ModelComponent>())
-				continue;
-
-			const auto & modelInfo = modelInfoEntity.get<ModelComponent>();
-			const auto & openGL = modelInfoEntity.get<OpenGLModelComponent>();
-
-			_model = ShaderHelper::getModelMatrix(modelInfo, transform);
-			_entityID = (float)e.id;
-			_color = graphics.color;
-
-			ShaderHelper::drawModel(openGL);
-		}
+		const auto & drawables = RenderSnapshot::get().drawables;
+		const auto tasks = RenderSnapshot::getTaskCount(drawables.size());
+		if (_taskBatchers.size() < tasks)
+			_taskBatchers.resize(tasks);
+
+		RenderSnapshot::runTasks(drawables.size(), [&](size_t task, size_t begin, size_t end) {
+			auto & batcher = _taskBatchers[task];
+			batcher.clear();
+			for (size_t i = begin; i < end; ++i)
+				if (drawables[i].entity.has<PolyVoxObjectComponent>() && Culling::isVisible(drawables[i].entity.id))
+					batcher.add(_em, drawables[i]);
+		});
+
+		_batcher.clear();
+		for (size_t task = 0; task < tasks; ++task)
+			_batcher.merge(_taskBatchers[task]);
+
+		_instanced = true;
+		_batcher.forEach([this](Entity::ID model, size_t lod, const auto & instances) {
+			Instancing::drawModel(_em.getEntity(model).get<OpenGLModelComponent>(), instances, lod);
+		});
 	}
 }
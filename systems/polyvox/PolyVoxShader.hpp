@@ -1,6 +1,8 @@
 #pragma once
 
+#include <vector>
 #include "opengl/Program.hpp"
+#include "systems/opengl/Instancing.hpp"
 
 namespace kengine {
 	class EntityManager;
@@ -17,21 +19,25 @@ namespace kengine {
 		putils::gl::Uniform<glm::mat4> _view;
 		putils::gl::Uniform<glm::mat4> _proj;
 		putils::gl::Uniform<glm::vec3> _viewPos;
+		putils::gl::Uniform<bool> _instanced;
 
 		putils::gl::Uniform<float> _entityID;
-		putils::gl::Uniform<putils::NormalizedColor> _color;
+		putils::gl::Uniform<putils::NormalizedColor> _entityColor;
 
 		putils_reflection_attributes(
 			putils_reflection_attribute_private(&PolyVoxShader::_model),
 			putils_reflection_attribute_private(&PolyVoxShader::_view),
 			putils_reflection_attribute_private(&PolyVoxShader::_proj),
 			putils_reflection_attribute_private(&PolyVoxShader::_viewPos),
+			putils_reflection_attribute_private(&PolyVoxShader::_instanced),
 
 			putils_reflection_attribute_private(&PolyVoxShader::_entityID),
-			putils_reflection_attribute_private(&PolyVoxShader::_color)
+			putils_reflection_attribute_private(&PolyVoxShader::_entityColor)
 		);
 
 	private:
 		EntityManager & _em;
+		std::vector<Instancing::Batcher> _taskBatchers; // One per task, merged into _batcher
+		Instancing::Batcher _batcher;
 	};
 }
\ No newline at end of file
@@ -62,6 +62,7 @@ namespace kengine {
 			const auto & centre = poly.volume.getEnclosingRegion().getCentre();
 			auto & model = e.attach<ModelComponent>();
 			model.boundingBox.position = { (float)centre.getX(), (float)centre.getY(), (float)centre.getZ() };
+			model.markDirty();
 
 			ModelDataComponent::Mesh meshData;
 			meshData.vertices = { mesh.getNoOfVertices(), sizeof(PolyVoxMeshContainerComponent::MeshType::VertexType), mesh.getRawVertexData() };